@@ -0,0 +1,469 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+/*
+ * GPIO benchmark suite on a gpio-sim simulated GPIO chip.
+ *
+ * Creates a gpio-sim chip through configfs, then measures toggle throughput,
+ * simulated edge to event return latency, event burst drain rate, and
+ * open/close cost of the character device backend this program is built with
+ * (cdev v1 or v2) and of the sysfs backend. Results are printed to stdout as
+ * one JSON object per line.
+ *
+ * Requires root, configfs mounted at /sys/kernel/config, and the gpio-sim
+ * kernel module loaded.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <glob.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "gpio.h"
+
+#define GPIO_SIM_CONFIGFS   "/sys/kernel/config/gpio-sim"
+
+/* Simulated lines */
+#define LINE_OUTPUT         0
+#define LINE_INPUT          1
+#define LINE_OUTPUT_NAME    "bench-out"
+#define LINE_INPUT_NAME     "bench-in"
+
+/* Edges per burst, the default kernel event buffer size of a line */
+#define BURST_EDGES         16
+
+#define DEFAULT_ITERATIONS  100000
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT == 2
+#define CDEV_BACKEND        "cdev_v2"
+#else
+#define CDEV_BACKEND        "cdev_v1"
+#endif
+
+struct gpio_sim {
+    char device_path[128];  /* configfs device directory */
+    char chip_path[64];     /* /dev/gpiochipN */
+    char sysfs_path[192];   /* sysfs directory of the simulated chip */
+    unsigned int base;      /* sysfs GPIO number of line 0 */
+    bool has_base;
+};
+
+static struct gpio_sim sim;
+
+/*********************************************************************************/
+/* Helpers */
+/*********************************************************************************/
+
+static void fail(const char *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    fprintf(stderr, "bench_gpio: ");
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+
+    exit(1);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int write_attr(const char *path, const char *value) {
+    int fd, ret;
+
+    if ((fd = open(path, O_WRONLY)) < 0)
+        return -1;
+
+    ret = write(fd, value, strlen(value)) < 0 ? -1 : 0;
+    close(fd);
+
+    return ret;
+}
+
+static int read_attr(const char *path, char *buf, size_t len) {
+    ssize_t ret;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+
+    ret = read(fd, buf, len - 1);
+    close(fd);
+    if (ret < 0)
+        return -1;
+
+    /* Strip newline */
+    buf[ret] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+
+    return 0;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t count, unsigned int p) {
+    return sorted[((count - 1) * p) / 100];
+}
+
+/*********************************************************************************/
+/* gpio-sim chip */
+/*********************************************************************************/
+
+static void sim_teardown(void) {
+    char path[256];
+
+    if (sim.device_path[0] == '\0')
+        return;
+
+    snprintf(path, sizeof(path), "%s/live", sim.device_path);
+    write_attr(path, "0");
+
+    snprintf(path, sizeof(path), "%s/bank0/line%u", sim.device_path, LINE_OUTPUT);
+    rmdir(path);
+    snprintf(path, sizeof(path), "%s/bank0/line%u", sim.device_path, LINE_INPUT);
+    rmdir(path);
+    snprintf(path, sizeof(path), "%s/bank0", sim.device_path);
+    rmdir(path);
+    rmdir(sim.device_path);
+
+    sim.device_path[0] = '\0';
+}
+
+static void sim_setup(void) {
+    static const char *line_names[2] = {LINE_OUTPUT_NAME, LINE_INPUT_NAME};
+    char path[256], dev_name[64], chip_name[32], buf[32];
+    glob_t chips;
+
+    snprintf(sim.device_path, sizeof(sim.device_path), GPIO_SIM_CONFIGFS "/periphery-bench-%d", getpid());
+
+    if (mkdir(sim.device_path, 0755) < 0) {
+        int errsv = errno;
+        sim.device_path[0] = '\0';
+        fail("creating gpio-sim device in " GPIO_SIM_CONFIGFS ": %s (is the gpio-sim module loaded, configfs mounted, and running as root?)", strerror(errsv));
+    }
+
+    atexit(sim_teardown);
+
+    snprintf(path, sizeof(path), "%s/bank0", sim.device_path);
+    if (mkdir(path, 0755) < 0)
+        fail("creating gpio-sim bank: %s", strerror(errno));
+
+    snprintf(path, sizeof(path), "%s/bank0/num_lines", sim.device_path);
+    if (write_attr(path, "2") < 0)
+        fail("writing gpio-sim num_lines: %s", strerror(errno));
+
+    for (unsigned int i = 0; i < 2; i++) {
+        snprintf(path, sizeof(path), "%s/bank0/line%u", sim.device_path, i);
+        if (mkdir(path, 0755) < 0)
+            fail("creating gpio-sim line: %s", strerror(errno));
+
+        snprintf(path, sizeof(path), "%s/bank0/line%u/name", sim.device_path, i);
+        if (write_attr(path, line_names[i]) < 0)
+            fail("writing gpio-sim line name: %s", strerror(errno));
+    }
+
+    snprintf(path, sizeof(path), "%s/live", sim.device_path);
+    if (write_attr(path, "1") < 0)
+        fail("enabling gpio-sim device: %s", strerror(errno));
+
+    snprintf(path, sizeof(path), "%s/dev_name", sim.device_path);
+    if (read_attr(path, dev_name, sizeof(dev_name)) < 0)
+        fail("reading gpio-sim dev_name: %s", strerror(errno));
+
+    snprintf(path, sizeof(path), "%s/bank0/chip_name", sim.device_path);
+    if (read_attr(path, chip_name, sizeof(chip_name)) < 0)
+        fail("reading gpio-sim chip_name: %s", strerror(errno));
+
+    snprintf(sim.chip_path, sizeof(sim.chip_path), "/dev/%s", chip_name);
+    snprintf(sim.sysfs_path, sizeof(sim.sysfs_path), "/sys/devices/platform/%s/%s", dev_name, chip_name);
+
+    /* Line numbering of the legacy sysfs interface, if enabled. Its chips
+     * are named after their base, gpiochip<base>, rather than after the
+     * character device, so find the one under the simulated device. */
+    snprintf(path, sizeof(path), "/sys/devices/platform/%s/", dev_name);
+    if (glob("/sys/class/gpio/gpiochip*", 0, NULL, &chips) == 0) {
+        for (size_t i = 0; i < chips.gl_pathc; i++) {
+            char real_path[PATH_MAX], base_path[PATH_MAX + 8];
+
+            if (realpath(chips.gl_pathv[i], real_path) == NULL || strncmp(real_path, path, strlen(path)) != 0)
+                continue;
+
+            snprintf(base_path, sizeof(base_path), "%s/base", real_path);
+            if (read_attr(base_path, buf, sizeof(buf)) == 0) {
+                sim.base = strtoul(buf, NULL, 10);
+                sim.has_base = true;
+                break;
+            }
+        }
+
+        globfree(&chips);
+    }
+}
+
+static int sim_pull_open(unsigned int line) {
+    char path[256];
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/sim_gpio%u/pull", sim.sysfs_path, line);
+    if ((fd = open(path, O_WRONLY)) < 0)
+        fail("opening gpio-sim pull attribute: %s", strerror(errno));
+
+    return fd;
+}
+
+static void sim_pull(int fd, bool up) {
+    const char *value = up ? "pull-up" : "pull-down";
+
+    if (pwrite(fd, value, strlen(value), 0) < 0)
+        fail("writing gpio-sim pull attribute: %s", strerror(errno));
+}
+
+/*********************************************************************************/
+/* Benchmarks */
+/*********************************************************************************/
+
+static void open_output(gpio_t *gpio, bool sysfs) {
+    int ret;
+
+    if (sysfs)
+        ret = gpio_open_sysfs(gpio, sim.base + LINE_OUTPUT, GPIO_DIR_OUT);
+    else
+        ret = gpio_open(gpio, sim.chip_path, LINE_OUTPUT, GPIO_DIR_OUT);
+
+    if (ret < 0)
+        fail("opening output line: %s", gpio_errmsg(gpio));
+}
+
+static void open_input(gpio_t *gpio, bool sysfs) {
+    gpio_config_t config = {
+        .direction = GPIO_DIR_IN,
+        .edge = GPIO_EDGE_BOTH,
+        .event_clock = GPIO_EVENT_CLOCK_REALTIME,
+        .debounce_us = 0,
+        .event_buffer_size = 0,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+
+    if (sysfs) {
+        if (gpio_open_sysfs(gpio, sim.base + LINE_INPUT, GPIO_DIR_IN) < 0 || gpio_set_edge(gpio, GPIO_EDGE_BOTH) < 0)
+            fail("opening input line: %s", gpio_errmsg(gpio));
+    } else {
+        if (gpio_open_advanced(gpio, sim.chip_path, LINE_INPUT, &config) < 0)
+            fail("opening input line: %s", gpio_errmsg(gpio));
+    }
+}
+
+static void bench_open_close(const char *backend, bool sysfs, unsigned int iterations) {
+    gpio_t *gpio = gpio_new();
+    uint64_t start, elapsed;
+
+    start = now_ns();
+    for (unsigned int i = 0; i < iterations; i++) {
+        open_output(gpio, sysfs);
+        if (gpio_close(gpio) < 0)
+            fail("closing line: %s", gpio_errmsg(gpio));
+    }
+    elapsed = now_ns() - start;
+
+    printf("{\"benchmark\": \"open_close\", \"backend\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f}\n",
+           backend, iterations, (double)elapsed / iterations);
+
+    /* Line name lookup, character device only */
+    if (!sysfs) {
+        start = now_ns();
+        for (unsigned int i = 0; i < iterations; i++) {
+            if (gpio_open_name(gpio, sim.chip_path, LINE_OUTPUT_NAME, GPIO_DIR_OUT) < 0)
+                fail("opening line by name: %s", gpio_errmsg(gpio));
+            if (gpio_close(gpio) < 0)
+                fail("closing line: %s", gpio_errmsg(gpio));
+        }
+        elapsed = now_ns() - start;
+
+        printf("{\"benchmark\": \"open_name_close\", \"backend\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f}\n",
+               backend, iterations, (double)elapsed / iterations);
+    }
+
+    gpio_free(gpio);
+}
+
+static void bench_toggle(const char *backend, bool sysfs, unsigned int iterations) {
+    gpio_t *gpio = gpio_new();
+    uint64_t start, elapsed;
+
+    open_output(gpio, sysfs);
+
+    start = now_ns();
+    for (unsigned int i = 0; i < iterations; i++) {
+        if (gpio_write(gpio, i & 0x1) < 0)
+            fail("writing line: %s", gpio_errmsg(gpio));
+    }
+    elapsed = now_ns() - start;
+
+    printf("{\"benchmark\": \"toggle\", \"backend\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f, \"ops_per_sec\": %.0f}\n",
+           backend, iterations, (double)elapsed / iterations, iterations / (elapsed / 1e9));
+
+    gpio_close(gpio);
+    gpio_free(gpio);
+}
+
+static void bench_edge_latency(const char *backend, bool sysfs, unsigned int iterations) {
+    gpio_t *gpio = gpio_new();
+    uint64_t *samples, start;
+    gpio_edge_t edge;
+    uint64_t timestamp;
+    bool value;
+    int pull_fd, ret;
+
+    if ((samples = malloc(iterations * sizeof(uint64_t))) == NULL)
+        fail("allocating samples");
+
+    pull_fd = sim_pull_open(LINE_INPUT);
+    sim_pull(pull_fd, false);
+
+    open_input(gpio, sysfs);
+
+    /* Time from the simulated edge to the return of the event */
+    for (unsigned int i = 0; i < iterations; i++) {
+        start = now_ns();
+        sim_pull(pull_fd, (i % 2) == 0);
+
+        if (sysfs) {
+            if ((ret = gpio_poll(gpio, 1000)) > 0)
+                ret = gpio_read(gpio, &value);
+            else if (ret == 0)
+                fail("edge event timed out");
+        } else {
+            ret = gpio_read_event(gpio, &edge, &timestamp);
+        }
+
+        if (ret < 0)
+            fail("reading edge event: %s", gpio_errmsg(gpio));
+
+        samples[i] = now_ns() - start;
+    }
+
+    qsort(samples, iterations, sizeof(uint64_t), compare_u64);
+
+    printf("{\"benchmark\": \"edge_latency\", \"backend\": \"%s\", \"iterations\": %u, \"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"min_ns\": %llu, \"max_ns\": %llu}\n",
+           backend, iterations,
+           (unsigned long long)percentile(samples, iterations, 50),
+           (unsigned long long)percentile(samples, iterations, 90),
+           (unsigned long long)percentile(samples, iterations, 99),
+           (unsigned long long)samples[0],
+           (unsigned long long)samples[iterations - 1]);
+
+    gpio_close(gpio);
+    gpio_free(gpio);
+    close(pull_fd);
+    free(samples);
+}
+
+static void bench_burst_drain(const char *backend, unsigned int iterations) {
+    gpio_t *gpio = gpio_new();
+    gpio_event_t events[BURST_EDGES];
+    uint64_t start, elapsed = 0, drained = 0;
+    int pull_fd, ret;
+
+    pull_fd = sim_pull_open(LINE_INPUT);
+    sim_pull(pull_fd, false);
+
+    open_input(gpio, false);
+
+    for (unsigned int i = 0; i < iterations; i++) {
+        /* Queue a burst of edges, and let the kernel deliver them */
+        for (unsigned int j = 0; j < BURST_EDGES; j++)
+            sim_pull(pull_fd, (j % 2) == 0);
+        usleep(1000);
+
+        /* Drain the queued edges */
+        start = now_ns();
+        while ((ret = gpio_read_events(gpio, events, BURST_EDGES, 0)) > 0)
+            drained += ret;
+        elapsed += now_ns() - start;
+
+        if (ret < 0)
+            fail("reading edge events: %s", gpio_errmsg(gpio));
+    }
+
+    printf("{\"benchmark\": \"burst_drain\", \"backend\": \"%s\", \"iterations\": %u, \"burst_edges\": %u, \"events\": %llu, \"ns_per_event\": %.1f, \"events_per_sec\": %.0f}\n",
+           backend, iterations, BURST_EDGES, (unsigned long long)drained,
+           drained ? (double)elapsed / drained : 0.0, elapsed ? drained / (elapsed / 1e9) : 0.0);
+
+    gpio_close(gpio);
+    gpio_free(gpio);
+    close(pull_fd);
+}
+
+/*********************************************************************************/
+
+static void bench_backend(bool sysfs, unsigned int iterations) {
+    const char *backend = sysfs ? "sysfs" : CDEV_BACKEND;
+
+    /* Cost of exporting dominates sysfs opens */
+    bench_open_close(backend, sysfs, sysfs ? iterations / 1000 + 1 : iterations / 100 + 1);
+    bench_toggle(backend, sysfs, iterations);
+    bench_edge_latency(backend, sysfs, iterations / 100 + 1);
+
+    /* sysfs has no event queue to drain */
+    if (!sysfs)
+        bench_burst_drain(backend, iterations / 1000 + 1);
+}
+
+int main(int argc, char *argv[]) {
+    const char *which = (argc > 1) ? argv[1] : "all";
+    unsigned int iterations = (argc > 2) ? strtoul(argv[2], NULL, 10) : DEFAULT_ITERATIONS;
+    bool cdev = strcmp(which, "all") == 0 || strcmp(which, "cdev") == 0;
+    bool sysfs = strcmp(which, "all") == 0 || strcmp(which, "sysfs") == 0;
+
+    if ((!cdev && !sysfs) || iterations == 0) {
+        fprintf(stderr, "Usage: %s [all|cdev|sysfs] [iterations]\n\n", argv[0]);
+        fprintf(stderr, "Benchmark the " CDEV_BACKEND " and sysfs GPIO backends on a gpio-sim simulated chip.\n");
+        fprintf(stderr, "Requires root, configfs, and the gpio-sim kernel module:\n");
+        fprintf(stderr, "    sudo modprobe gpio-sim\n");
+        fprintf(stderr, "    sudo %s all %u > results.json\n\n", argv[0], DEFAULT_ITERATIONS);
+        exit(1);
+    }
+
+    sim_setup();
+
+    if (cdev)
+        bench_backend(false, iterations);
+
+    if (sysfs) {
+#if PERIPHERY_GPIO_CDEV_ONLY
+        fprintf(stderr, "bench_gpio: skipping sysfs backend, built with character device GPIO backend only\n");
+#else
+        if (!sim.has_base)
+            fprintf(stderr, "bench_gpio: skipping sysfs backend, simulated chip not found in /sys/class/gpio\n");
+        else
+            bench_backend(true, iterations);
+#endif
+    }
+
+    return 0;
+}
@@ -9,11 +9,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
 #include <errno.h>
 
 #include <sys/ioctl.h>
@@ -21,8 +23,15 @@
 #include "gpio.h"
 #include "gpio_internal.h"
 
-extern const struct gpio_ops gpio_cdev_ops;
-extern const struct gpio_ops gpio_sysfs_ops;
+#if PERIPHERY_GPIO_CDEV_SUPPORT
+#include <linux/gpio.h>
+#endif
+
+/* Maximum number of ready GPIOs collected by a single epoll_wait() */
+#define GPIO_EVENT_SET_READY_MAX    64
+
+/* Number of input register reads between line fd checks of an MMIO spin */
+#define GPIO_WAIT_MMIO_CHECK_INTERVAL   64
 
 gpio_t *gpio_new(void) {
     gpio_t *gpio = calloc(1, sizeof(gpio_t));
@@ -36,17 +45,28 @@ gpio_t *gpio_new(void) {
 #else
     gpio->ops = &gpio_sysfs_ops;
     gpio->u.sysfs.line_fd = -1;
+    gpio->u.sysfs.direction_fd = -1;
+    gpio->u.sysfs.edge_fd = -1;
+    gpio->u.sysfs.active_low_fd = -1;
 #endif
 
     return gpio;
 }
 
 int gpio_read(gpio_t *gpio, bool *value) {
+#if PERIPHERY_GPIO_CDEV_ONLY
+    return gpio_cdev_read(gpio, value);
+#else
     return gpio->ops->read(gpio, value);
+#endif
 }
 
 int gpio_write(gpio_t *gpio, bool value) {
+#if PERIPHERY_GPIO_CDEV_ONLY
+    return gpio_cdev_write(gpio, value);
+#else
     return gpio->ops->write(gpio, value);
+#endif
 }
 
 int gpio_poll(gpio_t *gpio, int timeout_ms) {
@@ -65,6 +85,192 @@ int gpio_read_event(gpio_t *gpio, gpio_edge_t *edge, uint64_t *timestamp) {
     return gpio->ops->read_event(gpio, edge, timestamp);
 }
 
+int gpio_read_events(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms) {
+    return gpio->ops->read_events(gpio, events, max, timeout_ms);
+}
+
+int gpio_get_event_stats(gpio_t *gpio, gpio_event_stats_t *stats) {
+    return gpio->ops->get_event_stats(gpio, stats);
+}
+
+int gpio_read_line_info_event(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms) {
+    return gpio->ops->read_line_info_event(gpio, event, timeout_ms);
+}
+
+static uint64_t _gpio_wait_now(clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void _gpio_wait_account(gpio_t *gpio, const gpio_event_t *event, bool spin) {
+    gpio_wait_stats_t *stats = &gpio->wait.stats;
+    gpio_event_clock_t event_clock = GPIO_EVENT_CLOCK_MONOTONIC;
+    uint64_t wakes, now, latency_ns, latency_us;
+    unsigned int bucket;
+
+    if (spin)
+        stats->spin_wakes++;
+    else
+        stats->sleep_wakes++;
+
+    /* Wake latency is measured against the event timestamp, which is only
+     * comparable for the realtime and monotonic event clocks */
+    gpio->ops->get_event_clock(gpio, &event_clock);
+    if (event_clock == GPIO_EVENT_CLOCK_HTE)
+        return;
+
+    now = _gpio_wait_now((event_clock == GPIO_EVENT_CLOCK_REALTIME) ? CLOCK_REALTIME : CLOCK_MONOTONIC);
+    latency_ns = (now > event->timestamp) ? now - event->timestamp : 0;
+
+    wakes = 0;
+    for (bucket = 0; bucket < GPIO_WAIT_LATENCY_BUCKETS; bucket++)
+        wakes += stats->latency_histogram[bucket];
+    wakes++;
+
+    if (wakes == 1 || latency_ns < stats->latency_min_ns)
+        stats->latency_min_ns = latency_ns;
+    if (latency_ns > stats->latency_max_ns)
+        stats->latency_max_ns = latency_ns;
+    stats->latency_mean_ns += ((double)latency_ns - stats->latency_mean_ns) / wakes;
+
+    /* Bucket 0 is under 1 us, bucket i is 2^(i-1) us to 2^i us */
+    for (bucket = 0, latency_us = latency_ns / 1000; latency_us > 0 && bucket < GPIO_WAIT_LATENCY_BUCKETS - 1; latency_us >>= 1)
+        bucket++;
+    stats->latency_histogram[bucket]++;
+}
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT
+static int _gpio_wait_spin_mmio(gpio_t *gpio, gpio_event_t *event, uint64_t deadline) {
+    bool inverted = gpio->u.cdev.inverted;
+    bool last = _gpio_mmio_line_get(&gpio->mmio) ^ inverted;
+    unsigned int i = 0;
+    int ret;
+
+    /* Spin on the input register for an edge of the configured polarity,
+     * checking the line fd periodically for edges too short to observe */
+    do {
+        bool value = _gpio_mmio_line_get(&gpio->mmio) ^ inverted;
+
+        if (value != last) {
+            last = value;
+
+            if (gpio->u.cdev.edge == GPIO_EDGE_BOTH ||
+                    (gpio->u.cdev.edge == GPIO_EDGE_RISING && value) ||
+                    (gpio->u.cdev.edge == GPIO_EDGE_FALLING && !value)) {
+                /* Spin out the interrupt latency for the edge event, leaving
+                 * the remaining timeout to the poll() fallback if the spin
+                 * budget runs out first */
+                while ((ret = gpio->ops->read_events(gpio, event, 1, 0)) == 0 && _gpio_wait_now(CLOCK_MONOTONIC) < deadline)
+                    ;
+
+                return ret;
+            }
+        }
+
+        if (++i % GPIO_WAIT_MMIO_CHECK_INTERVAL == 0 && (ret = gpio->ops->read_events(gpio, event, 1, 0)) != 0)
+            return ret;
+    } while (_gpio_wait_now(CLOCK_MONOTONIC) < deadline);
+
+    return 0;
+}
+#endif
+
+int gpio_set_spin_us(gpio_t *gpio, uint32_t spin_us) {
+    if (_gpio_is_sysfs(gpio))
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support low latency wait");
+
+    gpio->wait.spin_us = spin_us;
+    memset(&gpio->wait.stats, 0, sizeof(gpio->wait.stats));
+
+    return 0;
+}
+
+int gpio_get_spin_us(gpio_t *gpio, uint32_t *spin_us) {
+    *spin_us = gpio->wait.spin_us;
+
+    return 0;
+}
+
+int gpio_wait_event(gpio_t *gpio, gpio_event_t *event, int timeout_ms) {
+    int ret;
+
+    if (_gpio_is_sysfs(gpio))
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support low latency wait");
+
+    /* Spin for up to the busy-poll budget, bounded by the timeout */
+    if (gpio->wait.spin_us > 0 && timeout_ms != 0) {
+        uint64_t start = _gpio_wait_now(CLOCK_MONOTONIC);
+        uint64_t budget = (uint64_t)gpio->wait.spin_us * 1000;
+        uint64_t elapsed_ms;
+
+        if (timeout_ms > 0 && budget > (uint64_t)timeout_ms * 1000000)
+            budget = (uint64_t)timeout_ms * 1000000;
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT
+        if (_gpio_is_mmio(gpio)) {
+            ret = _gpio_wait_spin_mmio(gpio, event, start + budget);
+        } else
+#endif
+        {
+            /* Spin on non-blocking reads of the line fd */
+            while ((ret = gpio->ops->read_events(gpio, event, 1, 0)) == 0 && _gpio_wait_now(CLOCK_MONOTONIC) < start + budget)
+                ;
+        }
+
+        if (ret != 0) {
+            if (ret > 0)
+                _gpio_wait_account(gpio, event, true);
+            return ret;
+        }
+
+        /* Fall back to poll() for the remaining timeout */
+        if (timeout_ms > 0) {
+            elapsed_ms = (_gpio_wait_now(CLOCK_MONOTONIC) - start) / 1000000;
+            timeout_ms = (elapsed_ms < (uint64_t)timeout_ms) ? timeout_ms - (int)elapsed_ms : 0;
+        }
+    }
+
+    if ((ret = gpio->ops->read_events(gpio, event, 1, timeout_ms)) > 0)
+        _gpio_wait_account(gpio, event, false);
+    else if (ret == 0)
+        gpio->wait.stats.timeouts++;
+
+    return ret;
+}
+
+int gpio_get_wait_stats(gpio_t *gpio, gpio_wait_stats_t *stats) {
+    *stats = gpio->wait.stats;
+
+    return 0;
+}
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT
+int gpio_get_inline(gpio_t *gpio, gpio_inline_t *inl) {
+    if (_gpio_is_sysfs(gpio))
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support inline access");
+    else if (_gpio_is_mmio(gpio))
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type mmio does not support inline access");
+    else if (_gpio_is_mock(gpio))
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type mock does not support inline access");
+    else if (gpio->u.cdev.line_fd < 0)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO is not open");
+
+    inl->line_fd = gpio->u.cdev.line_fd;
+    inl->abi = PERIPHERY_GPIO_CDEV_SUPPORT;
+    inl->output = gpio->u.cdev.direction == GPIO_DIR_OUT;
+
+    return 0;
+}
+#else
+int gpio_get_inline(gpio_t *gpio, gpio_inline_t *inl) {
+    (void)inl;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+#endif
+
 int gpio_poll_multiple(gpio_t **gpios, size_t count, int timeout_ms, bool *gpios_ready) {
     struct pollfd fds[count];
     int ret;
@@ -72,7 +278,7 @@ int gpio_poll_multiple(gpio_t **gpios, size_t count, int timeout_ms, bool *gpios
     /* Setup pollfd structs */
     for (size_t i = 0; i < count; i++) {
         fds[i].fd = gpio_fd(gpios[i]);
-        fds[i].events = (gpios[i]->ops == &gpio_sysfs_ops) ?
+        fds[i].events = (_gpio_is_sysfs(gpios[i])) ?
                             (POLLPRI | POLLERR) : (POLLIN | POLLRDNORM);
         if (gpios_ready)
             gpios_ready[i] = false;
@@ -88,12 +294,6 @@ int gpio_poll_multiple(gpio_t **gpios, size_t count, int timeout_ms, bool *gpios
             /* Set ready GPIOs */
             if (gpios_ready)
                 gpios_ready[i] = fds[i].revents != 0;
-
-            /* Rewind GPIO if it is a sysfs GPIO */
-            if (gpios[i]->ops == &gpio_sysfs_ops) {
-                if (lseek(gpios[i]->u.sysfs.line_fd, 0, SEEK_SET) < 0)
-                    return GPIO_ERROR_IO;
-            }
         }
 
         return ret;
@@ -159,6 +359,10 @@ int gpio_set_inverted(gpio_t *gpio, bool inverted) {
     return gpio->ops->set_inverted(gpio, inverted);
 }
 
+int gpio_set_config(gpio_t *gpio, const gpio_config_t *config) {
+    return gpio->ops->set_config(gpio, config);
+}
+
 unsigned int gpio_line(gpio_t *gpio) {
     return gpio->ops->line(gpio);
 }
@@ -199,6 +403,428 @@ const char *gpio_errmsg(gpio_t *gpio) {
     return gpio->error.errmsg;
 }
 
+gpio_chip_t *gpio_chip_new(void) {
+    gpio_chip_t *chip = calloc(1, sizeof(gpio_chip_t));
+    if (chip == NULL)
+        return NULL;
+
+    chip->fd = -1;
+    chip->refcount = 1;
+
+    return chip;
+}
+
+void _gpio_chip_ref(gpio_chip_t *chip) {
+    chip->refcount++;
+    chip->fd_refcount++;
+}
+
+int _gpio_chip_unref(gpio_chip_t *chip) {
+    int ret = 0;
+
+    /* Close chip fd when the chip is closed and no GPIOs reference it */
+    if (--chip->fd_refcount == 0) {
+        ret = close(chip->fd);
+        chip->fd = -1;
+    }
+
+    /* Free chip when the handle is freed and no GPIOs reference it */
+    if (--chip->refcount == 0)
+        free(chip);
+
+    return ret;
+}
+
+void gpio_chip_free(gpio_chip_t *chip) {
+    if (--chip->refcount == 0)
+        free(chip);
+}
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT
+
+int gpio_chip_open(gpio_chip_t *chip, const char *path) {
+    struct gpiochip_info chip_info = {0};
+    int fd;
+
+    if (chip->opened || chip->fd_refcount != 0)
+        return _gpio_chip_error(chip, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO chip already open or in use");
+
+    /* Open GPIO chip */
+    if ((fd = open(path, 0)) < 0)
+        return _gpio_chip_error(chip, GPIO_ERROR_OPEN, errno, "Opening GPIO chip");
+
+    /* Query chip info once, for all GPIOs opened from the chip */
+    if (ioctl(fd, GPIO_GET_CHIPINFO_IOCTL, &chip_info) < 0) {
+        int errsv = errno;
+        close(fd);
+        return _gpio_chip_error(chip, GPIO_ERROR_QUERY, errsv, "Querying GPIO chip info");
+    }
+
+    chip->fd = fd;
+    chip->opened = true;
+    chip->num_lines = chip_info.lines;
+    chip->line_info_queue.head = chip->line_info_queue.count = 0;
+    strncpy(chip->path, path, sizeof(chip->path) - 1);
+    chip->path[sizeof(chip->path) - 1] = '\0';
+    strncpy(chip->name, chip_info.name, sizeof(chip->name) - 1);
+    chip->name[sizeof(chip->name) - 1] = '\0';
+    strncpy(chip->label, chip_info.label, sizeof(chip->label) - 1);
+    chip->label[sizeof(chip->label) - 1] = '\0';
+
+    chip->fd_refcount = 1;
+
+    return 0;
+}
+
+int gpio_chip_close(gpio_chip_t *chip) {
+    if (!chip->opened)
+        return 0;
+
+    chip->opened = false;
+
+    /* Drop the reference of the open chip. The chip fd remains open until
+     * the last GPIO opened from the chip is closed. */
+    if (--chip->fd_refcount == 0) {
+        int fd = chip->fd;
+
+        chip->fd = -1;
+
+        if (close(fd) < 0)
+            return _gpio_chip_error(chip, GPIO_ERROR_CLOSE, errno, "Closing GPIO chip");
+    }
+
+    return 0;
+}
+
+#else
+
+int gpio_chip_open(gpio_chip_t *chip, const char *path) {
+    (void)path;
+    return _gpio_chip_error(chip, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+
+int gpio_chip_close(gpio_chip_t *chip) {
+    (void)chip;
+    return 0;
+}
+
+#endif
+
+unsigned int gpio_chip_num_lines(gpio_chip_t *chip) {
+    return chip->num_lines;
+}
+
+int gpio_chip_handle_fd(gpio_chip_t *chip) {
+    return chip->fd;
+}
+
+int gpio_chip_handle_name(gpio_chip_t *chip, char *str, size_t len) {
+    if (!len)
+        return 0;
+
+    strncpy(str, chip->name, len - 1);
+    str[len - 1] = '\0';
+
+    return 0;
+}
+
+int gpio_chip_handle_label(gpio_chip_t *chip, char *str, size_t len) {
+    if (!len)
+        return 0;
+
+    strncpy(str, chip->label, len - 1);
+    str[len - 1] = '\0';
+
+    return 0;
+}
+
+int gpio_chip_tostring(gpio_chip_t *chip, char *str, size_t len) {
+    return snprintf(str, len, "GPIO chip %s (fd=%d, name=\"%s\", label=\"%s\", num_lines=%u, gpios_open=%u)",
+                    chip->path, chip->fd, chip->name, chip->label, chip->num_lines,
+                    chip->fd_refcount - ((chip->opened && chip->fd_refcount) ? 1 : 0));
+}
+
+int gpio_chip_errno(gpio_chip_t *chip) {
+    return chip->error.c_errno;
+}
+
+const char *gpio_chip_errmsg(gpio_chip_t *chip) {
+    return chip->error.errmsg;
+}
+
+gpio_lines_t *gpio_lines_new(void) {
+    gpio_lines_t *lines = calloc(1, sizeof(gpio_lines_t));
+    if (lines == NULL)
+        return NULL;
+
+    lines->line_fd = -1;
+    lines->chip_fd = -1;
+
+    return lines;
+}
+
+void gpio_lines_free(gpio_lines_t *lines) {
+    free(lines);
+}
+
+int gpio_lines_open(gpio_lines_t *lines, const char *path, const unsigned int *offsets, size_t count, gpio_direction_t direction) {
+    gpio_config_t config = {
+        .direction = direction,
+        .edge = GPIO_EDGE_NONE,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+
+    return gpio_lines_open_advanced(lines, path, offsets, count, &config);
+}
+
+size_t gpio_lines_count(gpio_lines_t *lines) {
+    return lines->count;
+}
+
+unsigned int gpio_lines_line(gpio_lines_t *lines, size_t index) {
+    return (index < lines->count) ? lines->lines[index] : (unsigned int)-1;
+}
+
+int gpio_lines_fd(gpio_lines_t *lines) {
+    return lines->line_fd;
+}
+
+int gpio_lines_chip_fd(gpio_lines_t *lines) {
+    return lines->chip_fd;
+}
+
+int gpio_lines_errno(gpio_lines_t *lines) {
+    return lines->error.c_errno;
+}
+
+const char *gpio_lines_errmsg(gpio_lines_t *lines) {
+    return lines->error.errmsg;
+}
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT
+/* Shared by the cdev v1 and v2 multiple lines implementations */
+int gpio_lines_close(gpio_lines_t *lines) {
+    /* Close line fd */
+    if (lines->line_fd >= 0) {
+        if (close(lines->line_fd) < 0)
+            return _gpio_lines_error(lines, GPIO_ERROR_CLOSE, errno, "Closing GPIO lines");
+
+        lines->line_fd = -1;
+    }
+
+    /* Close chip fd */
+    if (lines->chip_fd >= 0) {
+        if (close(lines->chip_fd) < 0)
+            return _gpio_lines_error(lines, GPIO_ERROR_CLOSE, errno, "Closing GPIO chip");
+
+        lines->chip_fd = -1;
+    }
+
+    lines->count = 0;
+
+    return 0;
+}
+
+int gpio_lines_tostring(gpio_lines_t *lines, char *str, size_t len) {
+    char offsets_str[GPIO_LINES_MAX * 11 + 1] = "";
+    size_t pos = 0;
+
+    for (size_t i = 0; i < lines->count; i++)
+        pos += snprintf(offsets_str + pos, sizeof(offsets_str) - pos, (i == 0) ? "%u" : ",%u", lines->lines[i]);
+
+    return snprintf(str, len, "GPIO lines %s (line_fd=%d, chip_fd=%d, direction=%s, edge=%s, debounce_us=%u, bias=%s, drive=%s, inverted=%s, label=\"%s\", type=cdev)",
+                    offsets_str, lines->line_fd, lines->chip_fd,
+                    (lines->direction == GPIO_DIR_IN) ? "in" : "out",
+                    (lines->edge == GPIO_EDGE_NONE) ? "none" :
+                    (lines->edge == GPIO_EDGE_RISING) ? "rising" :
+                    (lines->edge == GPIO_EDGE_FALLING) ? "falling" : "both",
+                    lines->debounce_us,
+                    (lines->bias == GPIO_BIAS_DEFAULT) ? "default" :
+                    (lines->bias == GPIO_BIAS_PULL_UP) ? "pull_up" :
+                    (lines->bias == GPIO_BIAS_PULL_DOWN) ? "pull_down" : "disable",
+                    (lines->drive == GPIO_DRIVE_DEFAULT) ? "default" :
+                    (lines->drive == GPIO_DRIVE_OPEN_DRAIN) ? "open_drain" : "open_source",
+                    lines->inverted ? "true" : "false", lines->label);
+}
+#endif
+
+gpio_event_set_t *gpio_event_set_new(void) {
+    gpio_event_set_t *set = calloc(1, sizeof(gpio_event_set_t));
+    if (set == NULL)
+        return NULL;
+
+    set->epoll_fd = -1;
+
+    return set;
+}
+
+void gpio_event_set_free(gpio_event_set_t *set) {
+    free(set);
+}
+
+int gpio_event_set_open(gpio_event_set_t *set) {
+    int fd, ret;
+
+    /* Release the epoll instance and members of a previous open */
+    if ((ret = gpio_event_set_close(set)) < 0)
+        return ret;
+
+    if ((fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        return _gpio_event_set_error(set, GPIO_ERROR_OPEN, errno, "Creating epoll instance");
+
+    memset(set, 0, sizeof(gpio_event_set_t));
+    set->epoll_fd = fd;
+
+    return 0;
+}
+
+int gpio_event_set_add(gpio_event_set_t *set, gpio_t *gpio) {
+    struct gpio_event_set_member *members;
+    struct epoll_event ev = {0};
+
+    if (_gpio_is_sysfs(gpio))
+        return _gpio_event_set_error(set, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support event sets");
+
+    if ((members = realloc(set->members, (set->count + 1) * sizeof(struct gpio_event_set_member))) == NULL)
+        return _gpio_event_set_error(set, GPIO_ERROR_CONFIGURE, errno, "Allocating event set members");
+    set->members = members;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = gpio;
+
+    if (epoll_ctl(set->epoll_fd, EPOLL_CTL_ADD, gpio_fd(gpio), &ev) < 0)
+        return _gpio_event_set_error(set, GPIO_ERROR_CONFIGURE, errno, "Adding GPIO %u to event set", gpio_line(gpio));
+
+    set->members[set->count].gpio = gpio;
+    set->members[set->count].fd_generation = gpio->fd_generation;
+    set->count++;
+
+    return 0;
+}
+
+int gpio_event_set_remove(gpio_event_set_t *set, gpio_t *gpio) {
+    size_t i;
+
+    for (i = 0; i < set->count && set->members[i].gpio != gpio; i++);
+
+    if (i == set->count)
+        return _gpio_event_set_error(set, GPIO_ERROR_ARG, 0, "GPIO %u not added to event set", gpio_line(gpio));
+
+    /* A replaced line fd was removed from the epoll instance when closed */
+    if (set->members[i].fd_generation == gpio->fd_generation && epoll_ctl(set->epoll_fd, EPOLL_CTL_DEL, gpio_fd(gpio), NULL) < 0)
+        return _gpio_event_set_error(set, GPIO_ERROR_CONFIGURE, errno, "Removing GPIO %u from event set", gpio_line(gpio));
+
+    set->members[i] = set->members[--set->count];
+
+    return 0;
+}
+
+static int _gpio_event_set_reregister(gpio_event_set_t *set) {
+    struct epoll_event ev = {0};
+
+    /* Register the line fds that replaced the registered fds of GPIOs, e.g.
+     * on reconfiguration with the gpio-cdev v1 ABI */
+    for (size_t i = 0; i < set->count; i++) {
+        gpio_t *gpio = set->members[i].gpio;
+
+        if (set->members[i].fd_generation == gpio->fd_generation)
+            continue;
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = gpio;
+
+        if (gpio_fd(gpio) >= 0 && epoll_ctl(set->epoll_fd, EPOLL_CTL_ADD, gpio_fd(gpio), &ev) < 0)
+            return _gpio_event_set_error(set, GPIO_ERROR_CONFIGURE, errno, "Adding GPIO %u to event set", gpio_line(gpio));
+
+        set->members[i].fd_generation = gpio->fd_generation;
+    }
+
+    return 0;
+}
+
+int gpio_event_set_wait(gpio_event_set_t *set, gpio_t **gpios, gpio_event_t *events, size_t max, int timeout_ms) {
+    struct epoll_event ready[GPIO_EVENT_SET_READY_MAX];
+    size_t count = 0;
+    int n;
+
+    if (max == 0)
+        return 0;
+
+    if ((n = _gpio_event_set_reregister(set)) < 0)
+        return n;
+
+    /* Wait for ready GPIOs */
+    if ((n = epoll_wait(set->epoll_fd, ready, (max < GPIO_EVENT_SET_READY_MAX) ? max : GPIO_EVENT_SET_READY_MAX, timeout_ms)) < 0)
+        return _gpio_event_set_error(set, GPIO_ERROR_IO, errno, "Waiting on GPIO event set");
+
+    /* Drain events of ready GPIOs without blocking, as events may have been
+     * read since the wait. GPIOs with events remaining after the events
+     * array is filled stay ready for the next wait. A failing GPIO after
+     * events were collected stays registered, to report its failure on
+     * the next wait, rather than discarding the events. */
+    for (int i = 0; i < n && count < max; i++) {
+        gpio_t *gpio = (gpio_t *)ready[i].data.ptr;
+        int ret;
+
+        if (!(ready[i].events & EPOLLIN)) {
+            if (count > 0)
+                break;
+
+            return _gpio_event_set_error(set, GPIO_ERROR_IO, 0, "Error condition on GPIO %u", gpio_line(gpio));
+        }
+
+        if ((ret = gpio->ops->read_events(gpio, events + count, max - count, 0)) < 0) {
+            if (count > 0)
+                break;
+
+            return _gpio_event_set_error(set, ret, gpio->error.c_errno, "Reading events of GPIO %u", gpio_line(gpio));
+        }
+
+        if (gpios) {
+            for (int j = 0; j < ret; j++)
+                gpios[count + j] = gpio;
+        }
+
+        count += ret;
+    }
+
+    return count;
+}
+
+int gpio_event_set_close(gpio_event_set_t *set) {
+    if (set->epoll_fd < 0)
+        return 0;
+
+    if (close(set->epoll_fd) < 0)
+        return _gpio_event_set_error(set, GPIO_ERROR_CLOSE, errno, "Closing epoll instance");
+
+    free(set->members);
+    set->members = NULL;
+    set->epoll_fd = -1;
+    set->count = 0;
+
+    return 0;
+}
+
+size_t gpio_event_set_count(gpio_event_set_t *set) {
+    return set->count;
+}
+
+int gpio_event_set_fd(gpio_event_set_t *set) {
+    return set->epoll_fd;
+}
+
+int gpio_event_set_errno(gpio_event_set_t *set) {
+    return set->error.c_errno;
+}
+
+const char *gpio_event_set_errmsg(gpio_event_set_t *set) {
+    return set->error.errmsg;
+}
+
 #if !PERIPHERY_GPIO_CDEV_SUPPORT
 
 int gpio_open(gpio_t *gpio, const char *path, unsigned int line, gpio_direction_t direction)  {
@@ -230,5 +856,83 @@ int gpio_open_name_advanced(gpio_t *gpio, const char *path, const char *name, co
     return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
 }
 
+int gpio_open_chip(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, gpio_direction_t direction) {
+    (void)chip;
+    (void)line;
+    (void)direction;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+
+int gpio_open_chip_advanced(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, const gpio_config_t *config) {
+    (void)chip;
+    (void)line;
+    (void)config;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+
+int gpio_lines_open_advanced(gpio_lines_t *lines, const char *path, const unsigned int *offsets, size_t count, const gpio_config_t *config) {
+    (void)path;
+    (void)offsets;
+    (void)count;
+    (void)config;
+    return _gpio_lines_error(lines, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+
+int gpio_lines_read(gpio_lines_t *lines, uint64_t mask, uint64_t *bits) {
+    (void)mask;
+    (void)bits;
+    return _gpio_lines_error(lines, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+
+int gpio_lines_write(gpio_lines_t *lines, uint64_t mask, uint64_t bits) {
+    (void)mask;
+    (void)bits;
+    return _gpio_lines_error(lines, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+
+int gpio_lines_read_events(gpio_lines_t *lines, gpio_event_t *events, size_t max, int timeout_ms) {
+    (void)events;
+    (void)max;
+    (void)timeout_ms;
+    return _gpio_lines_error(lines, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO support.");
+}
+
+int gpio_lines_close(gpio_lines_t *lines) {
+    (void)lines;
+    return 0;
+}
+
+int gpio_lines_tostring(gpio_lines_t *lines, char *str, size_t len) {
+    (void)lines;
+    return snprintf(str, len, "GPIO lines (unsupported)");
+}
+
 #endif
 
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT != 2
+
+int gpio_open_name_any(gpio_t *gpio, const char *name, gpio_direction_t direction) {
+    (void)name;
+    (void)direction;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO v2 support.");
+}
+
+int gpio_open_name_any_advanced(gpio_t *gpio, const char *name, const gpio_config_t *config) {
+    (void)name;
+    (void)config;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built without character device GPIO v2 support.");
+}
+
+int gpio_index_lookup(const char *name, char *path, size_t len, unsigned int *line) {
+    (void)name;
+    (void)path;
+    (void)len;
+    (void)line;
+    return GPIO_ERROR_UNSUPPORTED;
+}
+
+void gpio_index_invalidate(void) {
+}
+
+#endif
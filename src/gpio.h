@@ -70,10 +70,100 @@ typedef struct gpio_config {
     gpio_drive_t drive;
     bool inverted;
     const char *label; /* Can be NULL for default consumer label */
+    uint32_t event_buffer_size; /* Can be 0 for default kernel event buffer size */
 } gpio_config_t;
 
+/* Edge event structure for gpio_read_events() */
+typedef struct gpio_event {
+    gpio_edge_t edge;       /* Rising or falling edge */
+    uint64_t timestamp;     /* Event timestamp in nanoseconds */
+    unsigned int line;      /* Line number */
+    uint32_t seqno;         /* Sequence number across all lines of the request */
+    uint32_t line_seqno;    /* Sequence number of the line */
+} gpio_event_t;
+
+/* Edge event statistics structure for gpio_get_event_stats() */
+typedef struct gpio_event_stats {
+    uint64_t events;        /* Events read */
+    uint64_t dropped;       /* Events dropped by the kernel due to buffer overflow */
+} gpio_event_stats_t;
+
+/* Number of wake latency histogram buckets of gpio_wait_stats_t */
+#define GPIO_WAIT_LATENCY_BUCKETS   16
+
+/* Low latency wait statistics structure for gpio_get_wait_stats() */
+typedef struct gpio_wait_stats {
+    uint64_t spin_wakes;        /* Events caught while spinning */
+    uint64_t sleep_wakes;       /* Events caught after falling back to poll() */
+    uint64_t timeouts;          /* Waits timed out */
+    uint64_t latency_min_ns;    /* Minimum wake latency */
+    uint64_t latency_max_ns;    /* Maximum wake latency */
+    double latency_mean_ns;     /* Mean wake latency */
+    /* Wake latency histogram, bucket 0 is under 1 us, bucket i is 2^(i-1) us
+     * to 2^i us, and the last bucket is unbounded */
+    uint64_t latency_histogram[GPIO_WAIT_LATENCY_BUCKETS];
+} gpio_wait_stats_t;
+
+/* Line info change type for gpio_read_line_info_event() */
+typedef enum gpio_line_info_change {
+    GPIO_LINE_INFO_REQUESTED,       /* Line requested by a consumer */
+    GPIO_LINE_INFO_RELEASED,        /* Line released by a consumer */
+    GPIO_LINE_INFO_RECONFIGURED,    /* Line reconfigured by a consumer */
+} gpio_line_info_change_t;
+
+/* Line info event structure for gpio_read_line_info_event() */
+typedef struct gpio_line_info_event {
+    gpio_line_info_change_t change; /* Change type */
+    uint64_t timestamp;             /* Event timestamp in nanoseconds (monotonic) */
+    unsigned int line;              /* Line number */
+    bool used;                      /* Line in use by a consumer */
+    char consumer[32];              /* Consumer label */
+} gpio_line_info_event_t;
+
+/* GPIO controller registers for direct MMIO line access. Line n is bit (n %
+ * 32) of the registers of bank (n / 32), at offset (n / 32) * bank_stride from
+ * the registers of the first bank. */
+typedef struct gpio_mmio_regs {
+    struct mmio_handle *mmio;   /* Opened MMIO handle of the GPIO controller */
+    uintptr_t level_offset;     /* Input level register */
+    uintptr_t set_offset;       /* Output set register */
+    uintptr_t clear_offset;     /* Output clear register */
+    uintptr_t bank_stride;      /* Bank register stride, can be 0 for a single bank */
+    uintptr_t data_offset;      /* Output data register, used instead of set and clear registers if rmw */
+    bool rmw;                   /* Read-modify-write data register, for controllers without set and clear registers */
+} gpio_mmio_regs_t;
+
+/* Register layouts of common SoC GPIO controllers, as gpio_mmio_regs_t
+ * initializers for an MMIO handle mapping the controller (or one bank of it,
+ * for controllers with a GPIO chip per bank) */
+#define GPIO_MMIO_REGS_BCM2835(handle)  {(handle), 0x34, 0x1c, 0x28, 0x4, 0x0, false}   /* Broadcom BCM2835/BCM2711 */
+#define GPIO_MMIO_REGS_AM335X(handle)   {(handle), 0x138, 0x194, 0x190, 0x0, 0x0, false} /* TI AM335x/OMAP, per bank */
+#define GPIO_MMIO_REGS_IMX(handle)      {(handle), 0x08, 0x0, 0x0, 0x0, 0x00, true}     /* NXP i.MX6/7/8, per bank */
+#define GPIO_MMIO_REGS_SUNXI(handle)    {(handle), 0x10, 0x0, 0x0, 0x24, 0x10, true}    /* Allwinner sunxi */
+#define GPIO_MMIO_REGS_ROCKCHIP(handle) {(handle), 0x50, 0x0, 0x0, 0x0, 0x00, true}     /* Rockchip RK3288/RK3399, per bank */
+
+/* Inline access structure for gpio_get_inline(), a snapshot of the line
+ * request of a character device GPIO for the static inline accessors of
+ * gpio_inline.h */
+typedef struct gpio_inline {
+    int line_fd;                /* Line request fd */
+    unsigned int abi;           /* Character device ABI version (1 or 2) */
+    bool output;                /* Line is an output */
+} gpio_inline_t;
+
 typedef struct gpio_handle gpio_t;
 
+typedef struct gpio_chip_handle gpio_chip_t;
+
+/* Maximum number of lines in a multiple line request */
+#define GPIO_LINES_MAX  64
+
+typedef struct gpio_lines_handle gpio_lines_t;
+
+typedef struct gpio_event_set_handle gpio_event_set_t;
+
+typedef struct gpio_reader_handle gpio_reader_t;
+
 /* Primary Functions */
 gpio_t *gpio_new(void);
 int gpio_open(gpio_t *gpio, const char *path, unsigned int line, gpio_direction_t direction);
@@ -81,6 +171,11 @@ int gpio_open_name(gpio_t *gpio, const char *path, const char *name, gpio_direct
 int gpio_open_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config);
 int gpio_open_name_advanced(gpio_t *gpio, const char *path, const char *name, const gpio_config_t *config);
 int gpio_open_sysfs(gpio_t *gpio, unsigned int line, gpio_direction_t direction);
+int gpio_open_sysfs_many(gpio_t **gpios, const unsigned int *lines, const gpio_direction_t *directions, size_t count);
+int gpio_open_mmio(gpio_t *gpio, const char *path, unsigned int line, gpio_direction_t direction, const gpio_mmio_regs_t *regs);
+int gpio_open_mmio_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config, const gpio_mmio_regs_t *regs);
+int gpio_open_mock(gpio_t *gpio, unsigned int line, gpio_direction_t direction);
+int gpio_open_mock_advanced(gpio_t *gpio, unsigned int line, const gpio_config_t *config);
 int gpio_read(gpio_t *gpio, bool *value);
 int gpio_write(gpio_t *gpio, bool value);
 int gpio_poll(gpio_t *gpio, int timeout_ms);
@@ -89,6 +184,24 @@ void gpio_free(gpio_t *gpio);
 
 /* Read Event (for character device GPIOs) */
 int gpio_read_event(gpio_t *gpio, gpio_edge_t *edge, uint64_t *timestamp);
+int gpio_read_events(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms);
+int gpio_get_event_stats(gpio_t *gpio, gpio_event_stats_t *stats);
+
+/* Read Line Info Event (for character device GPIOs) */
+int gpio_read_line_info_event(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms);
+
+/* Low Latency Wait (for character device GPIOs) */
+int gpio_set_spin_us(gpio_t *gpio, uint32_t spin_us);
+int gpio_get_spin_us(gpio_t *gpio, uint32_t *spin_us);
+int gpio_wait_event(gpio_t *gpio, gpio_event_t *event, int timeout_ms);
+int gpio_get_wait_stats(gpio_t *gpio, gpio_wait_stats_t *stats);
+
+/* Inline Access (for character device GPIOs, see gpio_inline.h) */
+int gpio_get_inline(gpio_t *gpio, gpio_inline_t *inl);
+
+/* Event Injection (for mock GPIOs) */
+int gpio_mock_inject_edge(gpio_t *gpio, gpio_edge_t edge, uint64_t timestamp);
+int gpio_mock_inject_events(gpio_t *gpio, const gpio_event_t *events, size_t count);
 
 /* Poll Multiple */
 int gpio_poll_multiple(gpio_t **gpios, size_t count, int timeout_ms, bool *gpios_ready);
@@ -110,6 +223,7 @@ int gpio_set_debounce_us(gpio_t *gpio, uint32_t debounce_us);
 int gpio_set_bias(gpio_t *gpio, gpio_bias_t bias);
 int gpio_set_drive(gpio_t *gpio, gpio_drive_t drive);
 int gpio_set_inverted(gpio_t *gpio, bool inverted);
+int gpio_set_config(gpio_t *gpio, const gpio_config_t *config);
 
 /* Miscellaneous Properties */
 unsigned int gpio_line(gpio_t *gpio);
@@ -125,6 +239,89 @@ int gpio_tostring(gpio_t *gpio, char *str, size_t len);
 int gpio_errno(gpio_t *gpio);
 const char *gpio_errmsg(gpio_t *gpio);
 
+/* GPIO Chip (for character device GPIOs) */
+gpio_chip_t *gpio_chip_new(void);
+int gpio_chip_open(gpio_chip_t *chip, const char *path);
+int gpio_chip_close(gpio_chip_t *chip);
+void gpio_chip_free(gpio_chip_t *chip);
+int gpio_open_chip(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, gpio_direction_t direction);
+int gpio_open_chip_advanced(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, const gpio_config_t *config);
+
+/* GPIO Chip Miscellaneous Properties */
+unsigned int gpio_chip_num_lines(gpio_chip_t *chip);
+int gpio_chip_handle_fd(gpio_chip_t *chip);
+int gpio_chip_handle_name(gpio_chip_t *chip, char *str, size_t len);
+int gpio_chip_handle_label(gpio_chip_t *chip, char *str, size_t len);
+int gpio_chip_tostring(gpio_chip_t *chip, char *str, size_t len);
+
+/* GPIO Chip Error Handling */
+int gpio_chip_errno(gpio_chip_t *chip);
+const char *gpio_chip_errmsg(gpio_chip_t *chip);
+
+/* Line Name Index (for character device GPIOs) */
+int gpio_open_name_any(gpio_t *gpio, const char *name, gpio_direction_t direction);
+int gpio_open_name_any_advanced(gpio_t *gpio, const char *name, const gpio_config_t *config);
+int gpio_index_lookup(const char *name, char *path, size_t len, unsigned int *line);
+void gpio_index_invalidate(void);
+
+/* Multiple Lines (for character device GPIOs) */
+gpio_lines_t *gpio_lines_new(void);
+int gpio_lines_open(gpio_lines_t *lines, const char *path, const unsigned int *offsets, size_t count, gpio_direction_t direction);
+int gpio_lines_open_advanced(gpio_lines_t *lines, const char *path, const unsigned int *offsets, size_t count, const gpio_config_t *config);
+int gpio_lines_read(gpio_lines_t *lines, uint64_t mask, uint64_t *bits);
+int gpio_lines_write(gpio_lines_t *lines, uint64_t mask, uint64_t bits);
+int gpio_lines_read_events(gpio_lines_t *lines, gpio_event_t *events, size_t max, int timeout_ms);
+int gpio_lines_close(gpio_lines_t *lines);
+void gpio_lines_free(gpio_lines_t *lines);
+
+/* Multiple Lines Miscellaneous Properties */
+size_t gpio_lines_count(gpio_lines_t *lines);
+unsigned int gpio_lines_line(gpio_lines_t *lines, size_t index);
+int gpio_lines_fd(gpio_lines_t *lines);
+int gpio_lines_chip_fd(gpio_lines_t *lines);
+int gpio_lines_tostring(gpio_lines_t *lines, char *str, size_t len);
+
+/* Multiple Lines Error Handling */
+int gpio_lines_errno(gpio_lines_t *lines);
+const char *gpio_lines_errmsg(gpio_lines_t *lines);
+
+/* Event Set (for character device GPIOs) */
+gpio_event_set_t *gpio_event_set_new(void);
+int gpio_event_set_open(gpio_event_set_t *set);
+int gpio_event_set_add(gpio_event_set_t *set, gpio_t *gpio);
+int gpio_event_set_remove(gpio_event_set_t *set, gpio_t *gpio);
+int gpio_event_set_wait(gpio_event_set_t *set, gpio_t **gpios, gpio_event_t *events, size_t max, int timeout_ms);
+int gpio_event_set_close(gpio_event_set_t *set);
+void gpio_event_set_free(gpio_event_set_t *set);
+
+/* Event Set Miscellaneous Properties */
+size_t gpio_event_set_count(gpio_event_set_t *set);
+int gpio_event_set_fd(gpio_event_set_t *set);
+
+/* Event Set Error Handling */
+int gpio_event_set_errno(gpio_event_set_t *set);
+const char *gpio_event_set_errmsg(gpio_event_set_t *set);
+
+/* Background Reader (for character device GPIOs) */
+gpio_reader_t *gpio_reader_new(void);
+int gpio_reader_open(gpio_reader_t *reader, size_t ring_size);
+int gpio_reader_add(gpio_reader_t *reader, gpio_t *gpio);
+int gpio_reader_remove(gpio_reader_t *reader, gpio_t *gpio);
+int gpio_reader_start(gpio_reader_t *reader);
+int gpio_reader_stop(gpio_reader_t *reader);
+int gpio_reader_dequeue(gpio_reader_t *reader, gpio_t *gpio, gpio_event_t *events, size_t max);
+int gpio_reader_get_stats(gpio_reader_t *reader, gpio_t *gpio, gpio_event_stats_t *stats);
+int gpio_reader_close(gpio_reader_t *reader);
+void gpio_reader_free(gpio_reader_t *reader);
+
+/* Background Reader Miscellaneous Properties */
+size_t gpio_reader_count(gpio_reader_t *reader);
+bool gpio_reader_running(gpio_reader_t *reader);
+
+/* Background Reader Error Handling */
+int gpio_reader_errno(gpio_reader_t *reader);
+const char *gpio_reader_errmsg(gpio_reader_t *reader);
+
 #ifdef __cplusplus
 }
 #endif
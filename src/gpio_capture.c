@@ -0,0 +1,597 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <errno.h>
+
+#include "gpio_capture.h"
+#include "gpio_internal.h"
+
+/* Maximum number of ready GPIOs collected by a single epoll_wait() */
+#define GPIO_CAPTURE_READY_MAX  16
+
+/* Maximum number of events drained from a GPIO per wakeup */
+#define GPIO_CAPTURE_BATCH      64
+
+/* Maximum encoded record size: 10 byte timestamp delta varint, 2 byte
+ * channel and edge varint */
+#define GPIO_CAPTURE_RECORD_MAX 12
+
+struct gpio_capture_channel {
+    gpio_t *gpio;
+    char name[32];
+    bool initial_value;
+    bool have_line_seqno;
+    uint32_t last_line_seqno;
+};
+
+struct gpio_capture_handle {
+    int epoll_fd;
+    int stop_fd;
+    int file_fd;
+
+    /* capture buffer, length is published by capture thread */
+    uint8_t *buffer;
+    size_t size;
+    size_t length;
+    uint64_t last_timestamp;
+
+    struct gpio_capture_channel channels[GPIO_CAPTURE_CHANNELS_MAX];
+    size_t count;
+    bool running;
+    pthread_t thread;
+
+    /* updated by capture thread */
+    uint64_t events;
+    uint64_t dropped;
+    uint64_t overflows;
+    int code;
+    int c_errno;
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_capture_error(gpio_capture_t *capture, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    capture->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(capture->error.errmsg, sizeof(capture->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(capture->error.errmsg+strlen(capture->error.errmsg), sizeof(capture->error.errmsg)-strlen(capture->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+/*********************************************************************************/
+/* Record encoding */
+/*********************************************************************************/
+
+/* Each record is a zigzag varint of the signed timestamp delta from the
+ * previous record, followed by a varint of (channel << 1) | rising. Deltas are
+ * signed, as events of different channels are not strictly ordered across
+ * reads. */
+
+static size_t _gpio_capture_put_varint(uint8_t *buf, uint64_t value) {
+    size_t n = 0;
+
+    while (value >= 0x80) {
+        buf[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (uint8_t)value;
+
+    return n;
+}
+
+static int _gpio_capture_get_varint(const uint8_t *buf, size_t len, size_t *offset, uint64_t *value) {
+    uint64_t result = 0;
+
+    for (unsigned int shift = 0; shift < 64 && *offset < len; shift += 7) {
+        uint8_t byte = buf[(*offset)++];
+
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static size_t _gpio_capture_encode(uint8_t *buf, uint64_t *last_timestamp, unsigned int channel, gpio_edge_t edge, uint64_t timestamp) {
+    int64_t delta = (int64_t)(timestamp - *last_timestamp);
+    size_t n;
+
+    n = _gpio_capture_put_varint(buf, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    n += _gpio_capture_put_varint(buf + n, ((uint64_t)channel << 1) | (edge == GPIO_EDGE_RISING));
+
+    *last_timestamp = timestamp;
+
+    return n;
+}
+
+/*********************************************************************************/
+/* Capture thread */
+/*********************************************************************************/
+
+static int _gpio_capture_compare(const void *a, const void *b) {
+    const gpio_capture_event_t *ea = (const gpio_capture_event_t *)a;
+    const gpio_capture_event_t *eb = (const gpio_capture_event_t *)b;
+
+    return (ea->timestamp > eb->timestamp) - (ea->timestamp < eb->timestamp);
+}
+
+static void _gpio_capture_fail(gpio_capture_t *capture, int code, int c_errno) {
+    __atomic_store_n(&capture->c_errno, c_errno, __ATOMIC_RELAXED);
+    __atomic_store_n(&capture->code, code, __ATOMIC_RELEASE);
+}
+
+static void *_gpio_capture_thread(void *arg) {
+    gpio_capture_t *capture = (gpio_capture_t *)arg;
+    struct epoll_event ready[GPIO_CAPTURE_READY_MAX];
+    gpio_event_t events[GPIO_CAPTURE_BATCH];
+    gpio_capture_event_t *round;
+
+    if ((round = malloc(GPIO_CAPTURE_READY_MAX * GPIO_CAPTURE_BATCH * sizeof(gpio_capture_event_t))) == NULL) {
+        _gpio_capture_fail(capture, GPIO_ERROR_OPEN, ENOMEM);
+        return NULL;
+    }
+
+    while (true) {
+        size_t count = 0, length, stored = 0, overflows = 0;
+        bool stop = false;
+        int n;
+
+        if ((n = epoll_wait(capture->epoll_fd, ready, GPIO_CAPTURE_READY_MAX, -1)) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            _gpio_capture_fail(capture, GPIO_ERROR_IO, errno);
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            struct gpio_capture_channel *channel = (struct gpio_capture_channel *)ready[i].data.ptr;
+            uint32_t dropped = 0;
+            int ret;
+
+            /* Stop requested, after storing the events of this wakeup */
+            if (channel == NULL) {
+                stop = true;
+                continue;
+            }
+
+            if (!(ready[i].events & EPOLLIN))
+                ret = GPIO_ERROR_IO;
+            else
+                ret = channel->gpio->ops->read_events(channel->gpio, events, GPIO_CAPTURE_BATCH, -1);
+
+            if (ret < 0) {
+                /* Stop watching the GPIO and publish the failure */
+                epoll_ctl(capture->epoll_fd, EPOLL_CTL_DEL, gpio_fd(channel->gpio), NULL);
+                _gpio_capture_fail(capture, ret, (ready[i].events & EPOLLIN) ? channel->gpio->error.c_errno : 0);
+                continue;
+            }
+
+            for (int j = 0; j < ret; j++) {
+                /* Detect events dropped by the kernel from line sequence
+                 * number gaps. Backends without sequence numbers, like the
+                 * cdev v1 ABI, report 0. */
+                if (events[j].line_seqno != 0) {
+                    if (channel->have_line_seqno && events[j].line_seqno != channel->last_line_seqno + 1)
+                        dropped += events[j].line_seqno - channel->last_line_seqno - 1;
+                    channel->have_line_seqno = true;
+                    channel->last_line_seqno = events[j].line_seqno;
+                }
+
+                round[count].channel = channel - capture->channels;
+                round[count].edge = events[j].edge;
+                round[count].timestamp = events[j].timestamp;
+                count++;
+            }
+
+            if (dropped)
+                __atomic_add_fetch(&capture->dropped, dropped, __ATOMIC_RELAXED);
+        }
+
+        /* Order the events of this wakeup across channels */
+        qsort(round, count, sizeof(gpio_capture_event_t), _gpio_capture_compare);
+
+        /* Append records, counting overflows rather than blocking when the
+         * buffer is full */
+        length = capture->length;
+        for (size_t i = 0; i < count; i++) {
+            if (capture->size - length < GPIO_CAPTURE_RECORD_MAX) {
+                overflows += count - i;
+                break;
+            }
+
+            length += _gpio_capture_encode(capture->buffer + length, &capture->last_timestamp,
+                                           round[i].channel, round[i].edge, round[i].timestamp);
+            stored++;
+        }
+
+        __atomic_store_n(&capture->length, length, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&capture->events, stored, __ATOMIC_RELAXED);
+        if (overflows)
+            __atomic_add_fetch(&capture->overflows, overflows, __ATOMIC_RELAXED);
+
+        if (stop)
+            break;
+    }
+
+    free(round);
+
+    return NULL;
+}
+
+/*********************************************************************************/
+/* Primary Functions */
+/*********************************************************************************/
+
+gpio_capture_t *gpio_capture_new(void) {
+    gpio_capture_t *capture = calloc(1, sizeof(gpio_capture_t));
+    if (capture == NULL)
+        return NULL;
+
+    capture->epoll_fd = -1;
+    capture->stop_fd = -1;
+    capture->file_fd = -1;
+
+    return capture;
+}
+
+void gpio_capture_free(gpio_capture_t *capture) {
+    free(capture);
+}
+
+int gpio_capture_open(gpio_capture_t *capture, size_t size, const char *path) {
+    struct epoll_event ev = {0};
+    int epoll_fd, stop_fd, file_fd = -1;
+    void *buffer;
+
+    if (size < GPIO_CAPTURE_RECORD_MAX)
+        return _gpio_capture_error(capture, GPIO_ERROR_ARG, 0, "Invalid capture buffer size (can be at least %d)", GPIO_CAPTURE_RECORD_MAX);
+
+    /* Preallocate and prefault the capture buffer, backed by a file for long
+     * captures, so the capture thread does not take page faults */
+    if (path) {
+        if ((file_fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0)
+            return _gpio_capture_error(capture, GPIO_ERROR_OPEN, errno, "Opening capture file");
+
+        if (ftruncate(file_fd, size) < 0) {
+            int errsv = errno;
+            close(file_fd);
+            return _gpio_capture_error(capture, GPIO_ERROR_OPEN, errsv, "Sizing capture file");
+        }
+
+        buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, file_fd, 0);
+    } else {
+        buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    }
+
+    if (buffer == MAP_FAILED) {
+        int errsv = errno;
+        if (file_fd >= 0)
+            close(file_fd);
+        return _gpio_capture_error(capture, GPIO_ERROR_OPEN, errsv, "Mapping capture buffer");
+    }
+
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        int errsv = errno;
+        munmap(buffer, size);
+        if (file_fd >= 0)
+            close(file_fd);
+        return _gpio_capture_error(capture, GPIO_ERROR_OPEN, errsv, "Creating epoll instance");
+    }
+
+    if ((stop_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        int errsv = errno;
+        close(epoll_fd);
+        munmap(buffer, size);
+        if (file_fd >= 0)
+            close(file_fd);
+        return _gpio_capture_error(capture, GPIO_ERROR_OPEN, errsv, "Creating stop eventfd");
+    }
+
+    /* Stop eventfd is identified by a NULL channel */
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &ev) < 0) {
+        int errsv = errno;
+        close(stop_fd);
+        close(epoll_fd);
+        munmap(buffer, size);
+        if (file_fd >= 0)
+            close(file_fd);
+        return _gpio_capture_error(capture, GPIO_ERROR_OPEN, errsv, "Adding stop eventfd to epoll instance");
+    }
+
+    memset(capture, 0, sizeof(gpio_capture_t));
+    capture->epoll_fd = epoll_fd;
+    capture->stop_fd = stop_fd;
+    capture->file_fd = file_fd;
+    capture->buffer = buffer;
+    capture->size = size;
+
+    return 0;
+}
+
+int gpio_capture_add(gpio_capture_t *capture, gpio_t *gpio, const char *name) {
+    struct gpio_capture_channel *channel;
+    struct epoll_event ev = {0};
+    gpio_direction_t direction;
+    gpio_edge_t edge;
+
+    if (capture->running)
+        return _gpio_capture_error(capture, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot add GPIO to running capture");
+
+    if (capture->length > 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot add GPIO to non-empty capture");
+
+    if (capture->count == GPIO_CAPTURE_CHANNELS_MAX)
+        return _gpio_capture_error(capture, GPIO_ERROR_ARG, 0, "Capture channels full (max %d)", GPIO_CAPTURE_CHANNELS_MAX);
+
+    if (_gpio_is_sysfs(gpio))
+        return _gpio_capture_error(capture, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support capture");
+
+    for (size_t i = 0; i < capture->count; i++) {
+        if (capture->channels[i].gpio == gpio)
+            return _gpio_capture_error(capture, GPIO_ERROR_ARG, 0, "GPIO %u already added to capture", gpio_line(gpio));
+    }
+
+    if (gpio_get_direction(gpio, &direction) < 0 || gpio_get_edge(gpio, &edge) < 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_QUERY, gpio_errno(gpio), "Querying GPIO configuration");
+
+    if (direction != GPIO_DIR_IN || edge != GPIO_EDGE_BOTH)
+        return _gpio_capture_error(capture, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO must be an input with both edges configured");
+
+    channel = &capture->channels[capture->count];
+    memset(channel, 0, sizeof(struct gpio_capture_channel));
+    channel->gpio = gpio;
+
+    if (name) {
+        strncpy(channel->name, name, sizeof(channel->name) - 1);
+        channel->name[sizeof(channel->name) - 1] = '\0';
+    } else {
+        snprintf(channel->name, sizeof(channel->name), "gpio%u", gpio_line(gpio));
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = channel;
+
+    if (epoll_ctl(capture->epoll_fd, EPOLL_CTL_ADD, gpio_fd(gpio), &ev) < 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_CONFIGURE, errno, "Adding GPIO %u to capture", gpio_line(gpio));
+
+    capture->count++;
+
+    return 0;
+}
+
+int gpio_capture_start(gpio_capture_t *capture) {
+    int ret;
+
+    if (capture->running)
+        return 0;
+
+    /* Sample initial values on first start */
+    if (capture->length == 0) {
+        for (size_t i = 0; i < capture->count; i++) {
+            if ((ret = gpio_read(capture->channels[i].gpio, &capture->channels[i].initial_value)) < 0)
+                return _gpio_capture_error(capture, ret, gpio_errno(capture->channels[i].gpio), "Reading initial value of GPIO %u", gpio_line(capture->channels[i].gpio));
+        }
+    }
+
+    if ((ret = pthread_create(&capture->thread, NULL, _gpio_capture_thread, capture)) != 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_CONFIGURE, ret, "Creating capture thread");
+
+    capture->running = true;
+
+    return 0;
+}
+
+int gpio_capture_stop(gpio_capture_t *capture) {
+    uint64_t value = 1;
+    int ret;
+
+    if (!capture->running)
+        return 0;
+
+    if (write(capture->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_CONFIGURE, errno, "Signaling capture thread");
+
+    if ((ret = pthread_join(capture->thread, NULL)) != 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_CONFIGURE, ret, "Joining capture thread");
+
+    /* Reset stop eventfd */
+    if (read(capture->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_CONFIGURE, errno, "Resetting stop eventfd");
+
+    capture->running = false;
+
+    /* Report capture thread failure */
+    if ((ret = __atomic_load_n(&capture->code, __ATOMIC_ACQUIRE)) < 0)
+        return _gpio_capture_error(capture, ret, __atomic_load_n(&capture->c_errno, __ATOMIC_RELAXED), "Capturing GPIO events");
+
+    return 0;
+}
+
+int gpio_capture_next(gpio_capture_t *capture, gpio_capture_cursor_t *cursor, gpio_capture_event_t *event) {
+    size_t length = __atomic_load_n(&capture->length, __ATOMIC_ACQUIRE);
+    size_t offset = cursor->offset;
+    uint64_t delta, value;
+
+    if (offset >= length)
+        return 0;
+
+    if (_gpio_capture_get_varint(capture->buffer, length, &offset, &delta) < 0 ||
+            _gpio_capture_get_varint(capture->buffer, length, &offset, &value) < 0 ||
+            (value >> 1) >= capture->count)
+        return _gpio_capture_error(capture, GPIO_ERROR_IO, 0, "Corrupt capture record at offset %zu", cursor->offset);
+
+    /* Undo zigzag encoding of the signed delta */
+    cursor->timestamp += (delta >> 1) ^ (~(delta & 1) + 1);
+    cursor->offset = offset;
+
+    event->channel = value >> 1;
+    event->edge = (value & 1) ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING;
+    event->timestamp = cursor->timestamp;
+
+    return 1;
+}
+
+int gpio_capture_get_stats(gpio_capture_t *capture, gpio_capture_stats_t *stats) {
+    stats->events = __atomic_load_n(&capture->events, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&capture->dropped, __ATOMIC_RELAXED);
+    stats->overflows = __atomic_load_n(&capture->overflows, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&capture->length, __ATOMIC_ACQUIRE);
+
+    return 0;
+}
+
+int gpio_capture_export_vcd(gpio_capture_t *capture, const char *path) {
+    gpio_capture_cursor_t cursor = {0};
+    gpio_capture_event_t event;
+    uint64_t origin = 0, last = 0;
+    bool first = true;
+    FILE *fp;
+    int ret;
+
+    if ((fp = fopen(path, "w")) == NULL)
+        return _gpio_capture_error(capture, GPIO_ERROR_OPEN, errno, "Opening VCD file");
+
+    /* Header, with one single bit wire per channel */
+    fprintf(fp, "$version c-periphery gpio capture $end\n");
+    fprintf(fp, "$timescale 1ns $end\n");
+    fprintf(fp, "$scope module gpio $end\n");
+    for (size_t i = 0; i < capture->count; i++)
+        fprintf(fp, "$var wire 1 %c %s $end\n", (char)('!' + i), capture->channels[i].name);
+    fprintf(fp, "$upscope $end\n");
+    fprintf(fp, "$enddefinitions $end\n");
+
+    /* Initial values */
+    fprintf(fp, "#0\n$dumpvars\n");
+    for (size_t i = 0; i < capture->count; i++)
+        fprintf(fp, "%c%c\n", capture->channels[i].initial_value ? '1' : '0', (char)('!' + i));
+    fprintf(fp, "$end\n");
+
+    /* Value changes, relative to the first edge. VCD time cannot go
+     * backwards, so out of order edges are emitted at the current time. */
+    while ((ret = gpio_capture_next(capture, &cursor, &event)) > 0) {
+        uint64_t time;
+
+        if (first) {
+            origin = event.timestamp;
+            first = false;
+        }
+
+        time = (event.timestamp > origin) ? event.timestamp - origin : 0;
+        if (time < last)
+            time = last;
+
+        if (time != last)
+            fprintf(fp, "#%" PRIu64 "\n", time);
+        fprintf(fp, "%c%c\n", (event.edge == GPIO_EDGE_RISING) ? '1' : '0', (char)('!' + event.channel));
+
+        last = time;
+    }
+
+    if (ret < 0) {
+        fclose(fp);
+        return ret;
+    }
+
+    if (fclose(fp) != 0)
+        return _gpio_capture_error(capture, GPIO_ERROR_IO, errno, "Writing VCD file");
+
+    return 0;
+}
+
+int gpio_capture_close(gpio_capture_t *capture) {
+    int ret;
+
+    if ((ret = gpio_capture_stop(capture)) < 0)
+        return ret;
+
+    if (capture->buffer) {
+        if (munmap(capture->buffer, capture->size) < 0)
+            return _gpio_capture_error(capture, GPIO_ERROR_CLOSE, errno, "Unmapping capture buffer");
+
+        capture->buffer = NULL;
+    }
+
+    /* Trim capture file to the records */
+    if (capture->file_fd >= 0) {
+        if (ftruncate(capture->file_fd, capture->length) < 0)
+            return _gpio_capture_error(capture, GPIO_ERROR_CLOSE, errno, "Trimming capture file");
+
+        if (close(capture->file_fd) < 0)
+            return _gpio_capture_error(capture, GPIO_ERROR_CLOSE, errno, "Closing capture file");
+
+        capture->file_fd = -1;
+    }
+
+    capture->count = 0;
+    capture->length = 0;
+
+    if (capture->stop_fd >= 0) {
+        if (close(capture->stop_fd) < 0)
+            return _gpio_capture_error(capture, GPIO_ERROR_CLOSE, errno, "Closing stop eventfd");
+
+        capture->stop_fd = -1;
+    }
+
+    if (capture->epoll_fd >= 0) {
+        if (close(capture->epoll_fd) < 0)
+            return _gpio_capture_error(capture, GPIO_ERROR_CLOSE, errno, "Closing epoll instance");
+
+        capture->epoll_fd = -1;
+    }
+
+    return 0;
+}
+
+size_t gpio_capture_count(gpio_capture_t *capture) {
+    return capture->count;
+}
+
+bool gpio_capture_running(gpio_capture_t *capture) {
+    return capture->running;
+}
+
+int gpio_capture_errno(gpio_capture_t *capture) {
+    return capture->error.c_errno;
+}
+
+const char *gpio_capture_errmsg(gpio_capture_t *capture) {
+    return capture->error.errmsg;
+}
+
@@ -0,0 +1,71 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_CAPTURE_H
+#define _PERIPHERY_GPIO_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio.h"
+
+/* Maximum number of capture channels */
+#define GPIO_CAPTURE_CHANNELS_MAX   64
+
+/* Captured edge structure for gpio_capture_next() */
+typedef struct gpio_capture_event {
+    unsigned int channel;   /* Channel index, in order added */
+    gpio_edge_t edge;       /* Rising or falling edge */
+    uint64_t timestamp;     /* Timestamp in ns */
+} gpio_capture_event_t;
+
+/* Decoding cursor for gpio_capture_next(), zero initialize to start */
+typedef struct gpio_capture_cursor {
+    size_t offset;
+    uint64_t timestamp;
+} gpio_capture_cursor_t;
+
+/* Capture statistics structure for gpio_capture_get_stats() */
+typedef struct gpio_capture_stats {
+    uint64_t events;        /* Edges stored */
+    uint64_t dropped;       /* Edges dropped by the kernel */
+    uint64_t overflows;     /* Edges lost to a full capture buffer */
+    size_t bytes;           /* Capture buffer bytes used */
+} gpio_capture_stats_t;
+
+typedef struct gpio_capture_handle gpio_capture_t;
+
+/* Primary Functions */
+gpio_capture_t *gpio_capture_new(void);
+int gpio_capture_open(gpio_capture_t *capture, size_t size, const char *path);
+int gpio_capture_add(gpio_capture_t *capture, gpio_t *gpio, const char *name);
+int gpio_capture_start(gpio_capture_t *capture);
+int gpio_capture_stop(gpio_capture_t *capture);
+int gpio_capture_next(gpio_capture_t *capture, gpio_capture_cursor_t *cursor, gpio_capture_event_t *event);
+int gpio_capture_get_stats(gpio_capture_t *capture, gpio_capture_stats_t *stats);
+int gpio_capture_export_vcd(gpio_capture_t *capture, const char *path);
+int gpio_capture_close(gpio_capture_t *capture);
+void gpio_capture_free(gpio_capture_t *capture);
+
+/* Miscellaneous */
+size_t gpio_capture_count(gpio_capture_t *capture);
+bool gpio_capture_running(gpio_capture_t *capture);
+
+/* Error Handling */
+int gpio_capture_errno(gpio_capture_t *capture);
+const char *gpio_capture_errmsg(gpio_capture_t *capture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
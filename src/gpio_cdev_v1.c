@@ -27,33 +27,46 @@
 
 #if PERIPHERY_GPIO_CDEV_SUPPORT == 1
 
-static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge_t edge, gpio_bias_t bias, gpio_drive_t drive, bool inverted) {
-    uint32_t flags = 0;
+/* Maximum number of events drained by a single read() */
+#define GPIO_CDEV_EVENTS_BATCH  64
+
+static const char *_gpio_cdev_handle_flags(gpio_bias_t bias, gpio_drive_t drive, bool inverted, uint32_t *flags) {
+    *flags = 0;
 
     #ifdef GPIOHANDLE_REQUEST_BIAS_PULL_UP
     if (bias == GPIO_BIAS_PULL_UP)
-        flags |= GPIOHANDLE_REQUEST_BIAS_PULL_UP;
+        *flags |= GPIOHANDLE_REQUEST_BIAS_PULL_UP;
     else if (bias == GPIO_BIAS_PULL_DOWN)
-        flags |= GPIOHANDLE_REQUEST_BIAS_PULL_DOWN;
+        *flags |= GPIOHANDLE_REQUEST_BIAS_PULL_DOWN;
     else if (bias == GPIO_BIAS_DISABLE)
-        flags |= GPIOHANDLE_REQUEST_BIAS_DISABLE;
+        *flags |= GPIOHANDLE_REQUEST_BIAS_DISABLE;
     #else
     if (bias != GPIO_BIAS_DEFAULT)
-        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support configuring GPIO line bias");
+        return "Kernel version does not support configuring GPIO line bias";
     #endif
 
     #ifdef GPIOHANDLE_REQUEST_OPEN_DRAIN
     if (drive == GPIO_DRIVE_OPEN_DRAIN)
-        flags |= GPIOHANDLE_REQUEST_OPEN_DRAIN;
+        *flags |= GPIOHANDLE_REQUEST_OPEN_DRAIN;
     else if (drive == GPIO_DRIVE_OPEN_SOURCE)
-        flags |= GPIOHANDLE_REQUEST_OPEN_SOURCE;
+        *flags |= GPIOHANDLE_REQUEST_OPEN_SOURCE;
     #else
     if (drive != GPIO_DRIVE_DEFAULT)
-        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support configuring GPIO line drive");
+        return "Kernel version does not support configuring GPIO line drive";
     #endif
 
     if (inverted)
-        flags |= GPIOHANDLE_REQUEST_ACTIVE_LOW;
+        *flags |= GPIOHANDLE_REQUEST_ACTIVE_LOW;
+
+    return NULL;
+}
+
+static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge_t edge, gpio_bias_t bias, gpio_drive_t drive, bool inverted) {
+    const char *errmsg;
+    uint32_t flags;
+
+    if ((errmsg = _gpio_cdev_handle_flags(bias, drive, inverted, &flags)) != NULL)
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "%s", errmsg);
 
     /* FIXME this should really use GPIOHANDLE_SET_CONFIG_IOCTL instead of
      * closing and reopening, especially to preserve output value on
@@ -64,6 +77,7 @@ static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge
             return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO line");
 
         gpio->u.cdev.line_fd = -1;
+        gpio->fd_generation++;
     }
 
     if (direction == GPIO_DIR_IN) {
@@ -124,7 +138,7 @@ static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge
     return 0;
 }
 
-static int gpio_cdev_read(gpio_t *gpio, bool *value) {
+int gpio_cdev_read(gpio_t *gpio, bool *value) {
     struct gpiohandle_data data = {0};
 
     if (ioctl(gpio->u.cdev.line_fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0)
@@ -135,7 +149,7 @@ static int gpio_cdev_read(gpio_t *gpio, bool *value) {
     return 0;
 }
 
-static int gpio_cdev_write(gpio_t *gpio, bool value) {
+int gpio_cdev_write(gpio_t *gpio, bool value) {
     struct gpiohandle_data data = {0};
 
     if (gpio->u.cdev.direction != GPIO_DIR_OUT)
@@ -166,6 +180,8 @@ static int gpio_cdev_read_event(gpio_t *gpio, gpio_edge_t *edge, uint64_t *times
     if (timestamp)
         *timestamp = event_data.timestamp;
 
+    __atomic_store_n(&gpio->u.cdev.event_stats.events, gpio->u.cdev.event_stats.events + 1, __ATOMIC_RELAXED);
+
     return 0;
 }
 
@@ -184,6 +200,72 @@ static int gpio_cdev_poll(gpio_t *gpio, int timeout_ms) {
     return ret > 0;
 }
 
+static int gpio_cdev_read_events(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms) {
+    struct gpioevent_data event_data[GPIO_CDEV_EVENTS_BATCH];
+    size_t count = 0;
+    ssize_t ret;
+
+    if (gpio->u.cdev.direction != GPIO_DIR_IN)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot read event of output GPIO");
+    else if (gpio->u.cdev.edge == GPIO_EDGE_NONE)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO edge not set");
+
+    if (max == 0)
+        return 0;
+
+    /* Wait for an event, unless blocking in read() */
+    if (timeout_ms >= 0 && (ret = gpio_cdev_poll(gpio, timeout_ms)) <= 0)
+        return ret;
+
+    while (count < max) {
+        size_t n = ((max - count) < GPIO_CDEV_EVENTS_BATCH) ? (max - count) : GPIO_CDEV_EVENTS_BATCH;
+
+        /* Read as many queued events as fit */
+        if ((ret = read(gpio->u.cdev.line_fd, event_data, n * sizeof(event_data[0]))) < (ssize_t)sizeof(event_data[0]))
+            return _gpio_error(gpio, GPIO_ERROR_IO, (ret < 0) ? errno : 0, "Reading GPIO events");
+
+        n = ret / sizeof(event_data[0]);
+
+        for (size_t i = 0; i < n; i++) {
+            gpio_event_t *event = &events[count + i];
+
+            event->edge = (event_data[i].id == GPIOEVENT_EVENT_RISING_EDGE) ? GPIO_EDGE_RISING :
+                          (event_data[i].id == GPIOEVENT_EVENT_FALLING_EDGE) ? GPIO_EDGE_FALLING : GPIO_EDGE_NONE;
+            event->timestamp = event_data[i].timestamp;
+            event->line = gpio->u.cdev.line;
+            event->seqno = 0;
+            event->line_seqno = 0;
+        }
+
+        count += n;
+        __atomic_store_n(&gpio->u.cdev.event_stats.events, gpio->u.cdev.event_stats.events + n, __ATOMIC_RELAXED);
+
+        /* Continue only if the batch was filled and more events are queued */
+        if (count == max || n < GPIO_CDEV_EVENTS_BATCH)
+            break;
+        else if ((ret = gpio_cdev_poll(gpio, 0)) < 0)
+            return ret;
+        else if (ret == 0)
+            break;
+    }
+
+    return count;
+}
+
+static int gpio_cdev_get_event_stats(gpio_t *gpio, gpio_event_stats_t *stats) {
+    /* The v1 ABI has no event sequence numbers to detect dropped events.
+     * Event stats may be updated by a background reader thread. */
+    stats->events = __atomic_load_n(&gpio->u.cdev.event_stats.events, __ATOMIC_RELAXED);
+    stats->dropped = 0;
+    return 0;
+}
+
+static int gpio_cdev_read_line_info_event(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms) {
+    (void)event;
+    (void)timeout_ms;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support line info events");
+}
+
 static int gpio_cdev_close(gpio_t *gpio) {
     /* Close line fd */
     if (gpio->u.cdev.line_fd >= 0) {
@@ -193,8 +275,16 @@ static int gpio_cdev_close(gpio_t *gpio) {
         gpio->u.cdev.line_fd = -1;
     }
 
-    /* Close chip fd */
-    if (gpio->u.cdev.chip_fd >= 0) {
+    /* Release shared chip or close chip fd */
+    if (gpio->u.cdev.chip) {
+        gpio_chip_t *chip = gpio->u.cdev.chip;
+
+        gpio->u.cdev.chip = NULL;
+        gpio->u.cdev.chip_fd = -1;
+
+        if (_gpio_chip_unref(chip) < 0)
+            return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO chip");
+    } else if (gpio->u.cdev.chip_fd >= 0) {
         if (close(gpio->u.cdev.chip_fd) < 0)
             return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO chip");
 
@@ -307,6 +397,56 @@ static int gpio_cdev_set_inverted(gpio_t *gpio, bool inverted) {
     return _gpio_cdev_reopen(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.bias, gpio->u.cdev.drive, inverted);
 }
 
+/* Returns NULL, or an error message with its GPIO error code in code */
+static const char *_gpio_cdev_check_config(const gpio_config_t *config, int *code) {
+    *code = GPIO_ERROR_ARG;
+
+    if (config->direction != GPIO_DIR_IN && config->direction != GPIO_DIR_OUT && config->direction != GPIO_DIR_OUT_LOW && config->direction != GPIO_DIR_OUT_HIGH)
+        return "Invalid GPIO direction (can be in, out, low, high)";
+
+    if (config->edge != GPIO_EDGE_NONE && config->edge != GPIO_EDGE_RISING && config->edge != GPIO_EDGE_FALLING && config->edge != GPIO_EDGE_BOTH)
+        return "Invalid GPIO interrupt edge (can be none, rising, falling, both)";
+
+    if (config->direction != GPIO_DIR_IN && config->edge != GPIO_EDGE_NONE)
+        return "Invalid GPIO edge for output GPIO";
+
+    if (config->bias != GPIO_BIAS_DEFAULT && config->bias != GPIO_BIAS_PULL_UP && config->bias != GPIO_BIAS_PULL_DOWN && config->bias != GPIO_BIAS_DISABLE)
+        return "Invalid GPIO line bias (can be default, pull_up, pull_down, disable)";
+
+    if (config->drive != GPIO_DRIVE_DEFAULT && config->drive != GPIO_DRIVE_OPEN_DRAIN && config->drive != GPIO_DRIVE_OPEN_SOURCE)
+        return "Invalid GPIO line drive (can be default, open_drain, open_source)";
+
+    if (config->direction == GPIO_DIR_IN && config->drive != GPIO_DRIVE_DEFAULT)
+        return "Invalid GPIO line drive for input GPIO";
+
+    if (config->event_clock != GPIO_EVENT_CLOCK_REALTIME)
+        return "Kernel version does not support configuring event clock";
+
+    *code = GPIO_ERROR_UNSUPPORTED;
+
+    if (config->debounce_us != 0)
+        return "Kernel version does not support configuring debounce";
+
+    if (config->event_buffer_size != 0)
+        return "Kernel version does not support configuring event buffer size";
+
+    return NULL;
+}
+
+static int gpio_cdev_set_config(gpio_t *gpio, const gpio_config_t *config) {
+    const char *errmsg;
+    int ret;
+
+    if ((errmsg = _gpio_cdev_check_config(config, &ret)) != NULL)
+        return _gpio_error(gpio, ret, 0, "%s", errmsg);
+
+    if (config->direction == gpio->u.cdev.direction && config->edge == gpio->u.cdev.edge &&
+            config->bias == gpio->u.cdev.bias && config->drive == gpio->u.cdev.drive && config->inverted == gpio->u.cdev.inverted)
+        return 0;
+
+    return _gpio_cdev_reopen(gpio, config->direction, config->edge, config->bias, config->drive, config->inverted);
+}
+
 static unsigned int gpio_cdev_line(gpio_t *gpio) {
     return gpio->u.cdev.line;
 }
@@ -359,6 +499,10 @@ static int gpio_cdev_chip_name(gpio_t *gpio, char *str, size_t len) {
     if (!len)
         return 0;
 
+    /* Use chip info cached by shared chip */
+    if (gpio->u.cdev.chip)
+        return gpio_chip_handle_name(gpio->u.cdev.chip, str, len);
+
     if (ioctl(gpio->u.cdev.chip_fd, GPIO_GET_CHIPINFO_IOCTL, &chip_info) < 0)
         return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Querying GPIO chip info");
 
@@ -374,6 +518,10 @@ static int gpio_cdev_chip_label(gpio_t *gpio, char *str, size_t len) {
     if (!len)
         return 0;
 
+    /* Use chip info cached by shared chip */
+    if (gpio->u.cdev.chip)
+        return gpio_chip_handle_label(gpio->u.cdev.chip, str, len);
+
     if (ioctl(gpio->u.cdev.chip_fd, GPIO_GET_CHIPINFO_IOCTL, &chip_info) < 0)
         return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Querying GPIO chip info");
 
@@ -465,6 +613,9 @@ const struct gpio_ops gpio_cdev_ops = {
     .read = gpio_cdev_read,
     .write = gpio_cdev_write,
     .read_event = gpio_cdev_read_event,
+    .read_events = gpio_cdev_read_events,
+    .get_event_stats = gpio_cdev_get_event_stats,
+    .read_line_info_event = gpio_cdev_read_line_info_event,
     .poll = gpio_cdev_poll,
     .close = gpio_cdev_close,
     .get_direction = gpio_cdev_get_direction,
@@ -481,6 +632,7 @@ const struct gpio_ops gpio_cdev_ops = {
     .set_bias = gpio_cdev_set_bias,
     .set_drive = gpio_cdev_set_drive,
     .set_inverted = gpio_cdev_set_inverted,
+    .set_config = gpio_cdev_set_config,
     .line = gpio_cdev_line,
     .fd = gpio_cdev_fd,
     .name = gpio_cdev_name,
@@ -491,56 +643,71 @@ const struct gpio_ops gpio_cdev_ops = {
     .tostring = gpio_cdev_tostring,
 };
 
-int gpio_open_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config) {
-    int ret, fd;
-
-    if (config->direction != GPIO_DIR_IN && config->direction != GPIO_DIR_OUT && config->direction != GPIO_DIR_OUT_LOW && config->direction != GPIO_DIR_OUT_HIGH)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
-
-    if (config->edge != GPIO_EDGE_NONE && config->edge != GPIO_EDGE_RISING && config->edge != GPIO_EDGE_FALLING && config->edge != GPIO_EDGE_BOTH)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO interrupt edge (can be none, rising, falling, both)");
+static int _gpio_cdev_open(gpio_t *gpio, int chip_fd, gpio_chip_t *chip, unsigned int line, const gpio_config_t *config) {
+    int ret;
 
-    if (config->direction != GPIO_DIR_IN && config->edge != GPIO_EDGE_NONE)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO edge for output GPIO");
+    memset(gpio, 0, sizeof(gpio_t));
+    gpio->ops = &gpio_cdev_ops;
+    gpio->u.cdev.line = line;
+    gpio->u.cdev.line_fd = -1;
+    gpio->u.cdev.chip_fd = chip_fd;
+    strncpy(gpio->u.cdev.label, config->label ? config->label : "periphery", sizeof(gpio->u.cdev.label) - 1);
+    gpio->u.cdev.label[sizeof(gpio->u.cdev.label) - 1] = '\0';
 
-    if (config->bias != GPIO_BIAS_DEFAULT && config->bias != GPIO_BIAS_PULL_UP && config->bias != GPIO_BIAS_PULL_DOWN && config->bias != GPIO_BIAS_DISABLE)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line bias (can be default, pull_up, pull_down, disable)");
+    /* Take reference on shared chip before using its fd */
+    if (chip) {
+        _gpio_chip_ref(chip);
+        gpio->u.cdev.chip = chip;
+    }
 
-    if (config->drive != GPIO_DRIVE_DEFAULT && config->drive != GPIO_DRIVE_OPEN_DRAIN && config->drive != GPIO_DRIVE_OPEN_SOURCE)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line drive (can be default, open_drain, open_source)");
+    /* Open GPIO line */
+    if ((ret = _gpio_cdev_reopen(gpio, config->direction, config->edge, config->bias, config->drive, config->inverted)) < 0) {
+        gpio->u.cdev.chip = NULL;
+        gpio->u.cdev.chip_fd = -1;
+        if (chip)
+            _gpio_chip_unref(chip);
+        return ret;
+    }
 
-    if (config->direction == GPIO_DIR_IN && config->drive != GPIO_DRIVE_DEFAULT)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line drive for input GPIO");
+    return 0;
+}
 
-    if (config->event_clock != GPIO_EVENT_CLOCK_REALTIME)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Kernel version does not support configuring event clock");
+int gpio_open_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config) {
+    const char *errmsg;
+    int ret, fd;
 
-    if (config->debounce_us != 0)
-        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support configuring debounce");
+    if ((errmsg = _gpio_cdev_check_config(config, &ret)) != NULL)
+        return _gpio_error(gpio, ret, 0, "%s", errmsg);
 
     /* Open GPIO chip */
     if ((fd = open(path, 0)) < 0)
         return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO chip");
 
-    memset(gpio, 0, sizeof(gpio_t));
-    gpio->ops = &gpio_cdev_ops;
-    gpio->u.cdev.line = line;
-    gpio->u.cdev.line_fd = -1;
-    gpio->u.cdev.chip_fd = fd;
-    strncpy(gpio->u.cdev.label, config->label ? config->label : "periphery", sizeof(gpio->u.cdev.label) - 1);
-    gpio->u.cdev.label[sizeof(gpio->u.cdev.label) - 1] = '\0';
-
     /* Open GPIO line */
-    ret = _gpio_cdev_reopen(gpio, config->direction, config->edge, config->bias, config->drive, config->inverted);
-    if (ret < 0) {
-        close(gpio->u.cdev.chip_fd);
-        gpio->u.cdev.chip_fd = -1;
+    if ((ret = _gpio_cdev_open(gpio, fd, NULL, line, config)) < 0) {
+        close(fd);
         return ret;
     }
 
     return 0;
 }
 
+int gpio_open_chip_advanced(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, const gpio_config_t *config) {
+    const char *errmsg;
+    int ret;
+
+    if ((errmsg = _gpio_cdev_check_config(config, &ret)) != NULL)
+        return _gpio_error(gpio, ret, 0, "%s", errmsg);
+
+    if (!chip->opened)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO chip not open");
+
+    if (line >= chip->num_lines)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line %u (chip has %u lines)", line, chip->num_lines);
+
+    return _gpio_cdev_open(gpio, chip->fd, chip, line, config);
+}
+
 int gpio_open_name_advanced(gpio_t *gpio, const char *path, const char *name, const gpio_config_t *config) {
     int fd;
 
@@ -599,6 +766,19 @@ int gpio_open(gpio_t *gpio, const char *path, unsigned int line, gpio_direction_
     return gpio_open_advanced(gpio, path, line, &config);
 }
 
+int gpio_open_chip(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, gpio_direction_t direction) {
+    gpio_config_t config = {
+        .direction = direction,
+        .edge = GPIO_EDGE_NONE,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+
+    return gpio_open_chip_advanced(gpio, chip, line, &config);
+}
+
 int gpio_open_name(gpio_t *gpio, const char *path, const char *name, gpio_direction_t direction) {
     gpio_config_t config = {
         .direction = direction,
@@ -612,5 +792,142 @@ int gpio_open_name(gpio_t *gpio, const char *path, const char *name, gpio_direct
     return gpio_open_name_advanced(gpio, path, name, &config);
 }
 
+/*********************************************************************************/
+/* cdev v1 multiple lines implementation */
+/*********************************************************************************/
+
+int gpio_lines_open_advanced(gpio_lines_t *lines, const char *path, const unsigned int *offsets, size_t count, const gpio_config_t *config) {
+    struct gpiohandle_request request = {0};
+    const char *errmsg;
+    uint32_t flags;
+    int ret, fd;
+
+    if (count == 0 || count > GPIOHANDLES_MAX)
+        return _gpio_lines_error(lines, GPIO_ERROR_ARG, 0, "Invalid GPIO line count (can be 1 to %d)", GPIOHANDLES_MAX);
+
+    if ((errmsg = _gpio_cdev_check_config(config, &ret)) != NULL)
+        return _gpio_lines_error(lines, ret, 0, "%s", errmsg);
+
+    /* Line handles of the v1 ABI carry no edge events, which take a line
+     * event request per line */
+    if (config->edge != GPIO_EDGE_NONE)
+        return _gpio_lines_error(lines, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support edge events on multiple lines");
+
+    if ((errmsg = _gpio_cdev_handle_flags(config->bias, config->drive, config->inverted, &flags)) != NULL)
+        return _gpio_lines_error(lines, GPIO_ERROR_UNSUPPORTED, 0, "%s", errmsg);
+
+    /* Open GPIO chip */
+    if ((fd = open(path, 0)) < 0)
+        return _gpio_lines_error(lines, GPIO_ERROR_OPEN, errno, "Opening GPIO chip");
+
+    memset(lines, 0, sizeof(gpio_lines_t));
+    lines->count = count;
+    lines->line_fd = -1;
+    lines->chip_fd = fd;
+    strncpy(lines->label, config->label ? config->label : "periphery", sizeof(lines->label) - 1);
+    lines->label[sizeof(lines->label) - 1] = '\0';
+
+    if (config->direction != GPIO_DIR_IN) {
+        bool initial_value = (config->direction == GPIO_DIR_OUT_HIGH) ? true : false;
+        initial_value ^= config->inverted;
+
+        lines->values = initial_value ? _gpio_lines_mask(count) : 0;
+        flags |= GPIOHANDLE_REQUEST_OUTPUT;
+    } else {
+        flags |= GPIOHANDLE_REQUEST_INPUT;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        lines->lines[i] = offsets[i];
+        request.lineoffsets[i] = offsets[i];
+        request.default_values[i] = (lines->values >> i) & 0x1;
+    }
+
+    request.flags = flags;
+    strncpy(request.consumer_label, lines->label, sizeof(request.consumer_label) - 1);
+    request.consumer_label[sizeof(request.consumer_label) - 1] = '\0';
+    request.lines = count;
+
+    if (ioctl(lines->chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &request) < 0) {
+        int errsv = errno;
+        close(lines->chip_fd);
+        lines->chip_fd = -1;
+        return _gpio_lines_error(lines, GPIO_ERROR_OPEN, errsv, "Opening line handle for %zu lines", count);
+    }
+
+    lines->line_fd = request.fd;
+    lines->direction = (config->direction == GPIO_DIR_IN) ? GPIO_DIR_IN : GPIO_DIR_OUT;
+    lines->edge = GPIO_EDGE_NONE;
+    lines->event_clock = GPIO_EVENT_CLOCK_REALTIME;
+    lines->bias = config->bias;
+    lines->drive = config->drive;
+    lines->inverted = config->inverted;
+
+    return 0;
+}
+
+int gpio_lines_read(gpio_lines_t *lines, uint64_t mask, uint64_t *bits) {
+    struct gpiohandle_data data = {{0}};
+    uint64_t values = 0;
+
+    if (mask & ~_gpio_lines_mask(lines->count))
+        return _gpio_lines_error(lines, GPIO_ERROR_ARG, 0, "Invalid line mask (lines requested: %zu)", lines->count);
+
+    if (!mask) {
+        *bits = 0;
+        return 0;
+    }
+
+    /* All lines of the handle are read at once */
+    if (ioctl(lines->line_fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0)
+        return _gpio_lines_error(lines, GPIO_ERROR_IO, errno, "Getting line values");
+
+    for (size_t i = 0; i < lines->count; i++)
+        values |= (uint64_t)(data.values[i] & 0x1) << i;
+
+    *bits = values & mask;
+
+    return 0;
+}
+
+int gpio_lines_write(gpio_lines_t *lines, uint64_t mask, uint64_t bits) {
+    struct gpiohandle_data data = {{0}};
+    uint64_t values;
+
+    if (lines->direction != GPIO_DIR_OUT)
+        return _gpio_lines_error(lines, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot write to input GPIO lines");
+
+    if (mask & ~_gpio_lines_mask(lines->count))
+        return _gpio_lines_error(lines, GPIO_ERROR_ARG, 0, "Invalid line mask (lines requested: %zu)", lines->count);
+
+    if (!mask)
+        return 0;
+
+    /* All lines of the handle are set at once, so unselected lines keep
+     * their last written values */
+    values = (lines->values & ~mask) | (bits & mask);
+
+    for (size_t i = 0; i < lines->count; i++)
+        data.values[i] = (values >> i) & 0x1;
+
+    if (ioctl(lines->line_fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) < 0)
+        return _gpio_lines_error(lines, GPIO_ERROR_IO, errno, "Setting line values");
+
+    lines->values = values;
+
+    return 0;
+}
+
+int gpio_lines_read_events(gpio_lines_t *lines, gpio_event_t *events, size_t max, int timeout_ms) {
+    (void)events;
+    (void)max;
+    (void)timeout_ms;
+
+    if (lines->direction != GPIO_DIR_IN)
+        return _gpio_lines_error(lines, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot read events of output GPIO lines");
+
+    return _gpio_lines_error(lines, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO lines edge not set");
+}
+
 #endif
 
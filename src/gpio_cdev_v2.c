@@ -11,7 +11,10 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <dirent.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <errno.h>
 
 #include "gpio.h"
@@ -28,13 +31,43 @@
 
 #if PERIPHERY_GPIO_CDEV_SUPPORT == 2
 
-static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge_t edge, gpio_event_clock_t event_clock, uint32_t debounce_us, gpio_bias_t bias, gpio_drive_t drive, bool inverted) {
-    uint32_t flags = 0;
+/* Maximum number of events drained by a single read() */
+#define GPIO_CDEV_EVENTS_BATCH  64
 
-    #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
-    if (event_clock == GPIO_EVENT_CLOCK_HTE)
-        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support GPIO event clock HTE");
-    #endif
+/* Size of the kernel line info event FIFO of a chip fd, which drops new
+ * events when full */
+#define GPIO_CDEV_LINE_INFO_FIFO_SIZE   32
+
+static const char *_gpio_cdev_check_config(const gpio_config_t *config) {
+    if (config->direction != GPIO_DIR_IN && config->direction != GPIO_DIR_OUT && config->direction != GPIO_DIR_OUT_LOW && config->direction != GPIO_DIR_OUT_HIGH)
+        return "Invalid GPIO direction (can be in, out, low, high)";
+
+    if (config->edge != GPIO_EDGE_NONE && config->edge != GPIO_EDGE_RISING && config->edge != GPIO_EDGE_FALLING && config->edge != GPIO_EDGE_BOTH)
+        return "Invalid GPIO interrupt edge (can be none, rising, falling, both)";
+
+    if (config->event_clock != GPIO_EVENT_CLOCK_REALTIME && config->event_clock != GPIO_EVENT_CLOCK_MONOTONIC && config->event_clock != GPIO_EVENT_CLOCK_HTE)
+        return "Invalid GPIO event clock (can be realtime, monotonic, hte)";
+
+    if (config->direction != GPIO_DIR_IN && config->edge != GPIO_EDGE_NONE)
+        return "Invalid GPIO edge for output GPIO";
+
+    if (config->direction != GPIO_DIR_IN && config->debounce_us != 0)
+        return "Invalid GPIO debounce for output GPIO";
+
+    if (config->bias != GPIO_BIAS_DEFAULT && config->bias != GPIO_BIAS_PULL_UP && config->bias != GPIO_BIAS_PULL_DOWN && config->bias != GPIO_BIAS_DISABLE)
+        return "Invalid GPIO line bias (can be default, pull_up, pull_down, disable)";
+
+    if (config->drive != GPIO_DRIVE_DEFAULT && config->drive != GPIO_DRIVE_OPEN_DRAIN && config->drive != GPIO_DRIVE_OPEN_SOURCE)
+        return "Invalid GPIO line drive (can be default, open_drain, open_source)";
+
+    if (config->direction == GPIO_DIR_IN && config->drive != GPIO_DRIVE_DEFAULT)
+        return "Invalid GPIO line drive for input GPIO";
+
+    return NULL;
+}
+
+static uint64_t _gpio_cdev_flags(gpio_direction_t direction, gpio_edge_t edge, gpio_event_clock_t event_clock, gpio_bias_t bias, gpio_drive_t drive, bool inverted) {
+    uint64_t flags = 0;
 
     if (bias == GPIO_BIAS_PULL_UP)
         flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
@@ -51,20 +84,7 @@ static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge
     if (inverted)
         flags |= GPIO_V2_LINE_FLAG_ACTIVE_LOW;
 
-    /* FIXME this should really use GPIO_V2_LINE_SET_CONFIG_IOCTL instead of
-     * closing and reopening, especially to preserve output value on
-     * configuration changes */
-
-    if (gpio->u.cdev.line_fd >= 0) {
-        if (close(gpio->u.cdev.line_fd) < 0)
-            return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO line");
-
-        gpio->u.cdev.line_fd = -1;
-    }
-
     if (direction == GPIO_DIR_IN) {
-        struct gpio_v2_line_request line_request = {0};
-
         flags |= GPIO_V2_LINE_FLAG_INPUT;
         flags |= (edge == GPIO_EDGE_RISING) ? GPIO_V2_LINE_FLAG_EDGE_RISING :
                  (edge == GPIO_EDGE_FALLING) ? GPIO_V2_LINE_FLAG_EDGE_FALLING :
@@ -77,45 +97,157 @@ static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge
                     0
                     #endif
                   : 0;
+    } else {
+        flags |= GPIO_V2_LINE_FLAG_OUTPUT;
+    }
 
-        line_request.offsets[0] = gpio->u.cdev.line;
-        strncpy(line_request.consumer, gpio->u.cdev.label, sizeof(line_request.consumer) - 1);
-        line_request.consumer[sizeof(line_request.consumer) - 1] = '\0';
-        line_request.config.flags = flags;
-        line_request.num_lines = 1;
+    return flags;
+}
 
-        if (debounce_us) {
-            line_request.config.num_attrs = 1;
-            line_request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
-            line_request.config.attrs[0].attr.debounce_period_us = debounce_us;
+static void _gpio_cdev_account_event(gpio_t *gpio, uint32_t line_seqno) {
+    /* Line sequence numbers start at 1 for a new line request, so gaps,
+     * including before the first event read, are events the kernel dropped
+     * on event buffer overflow */
+    if (line_seqno > gpio->u.cdev.last_line_seqno)
+        __atomic_store_n(&gpio->u.cdev.event_stats.dropped, gpio->u.cdev.event_stats.dropped + (line_seqno - gpio->u.cdev.last_line_seqno - 1), __ATOMIC_RELAXED);
+
+    gpio->u.cdev.last_line_seqno = line_seqno;
+    __atomic_store_n(&gpio->u.cdev.event_stats.events, gpio->u.cdev.event_stats.events + 1, __ATOMIC_RELAXED);
+}
+
+static void _gpio_cdev_cache_line_info(gpio_t *gpio, const struct gpio_v2_line_info *line_info) {
+    strncpy(gpio->u.cdev.line_name, line_info->name, sizeof(gpio->u.cdev.line_name) - 1);
+    gpio->u.cdev.line_name[sizeof(gpio->u.cdev.line_name) - 1] = '\0';
+    strncpy(gpio->u.cdev.line_consumer, line_info->consumer, sizeof(gpio->u.cdev.line_consumer) - 1);
+    gpio->u.cdev.line_consumer[sizeof(gpio->u.cdev.line_consumer) - 1] = '\0';
+}
+
+static struct gpio_line_info_queue *_gpio_cdev_line_info_queue(gpio_t *gpio) {
+    /* Line info events of a shared chip fd are queued on the chip, for
+     * all GPIOs opened from it */
+    return gpio->u.cdev.chip ? &gpio->u.cdev.chip->line_info_queue : &gpio->u.cdev.line_info_queue;
+}
+
+static void _gpio_cdev_dispatch_line_info_event(gpio_t *gpio, const struct gpio_v2_line_info_changed *info_changed) {
+    struct gpio_line_info_queue *queue = _gpio_cdev_line_info_queue(gpio);
+    gpio_line_info_event_t *event;
+
+    /* Refresh cached line info of the GPIO watching the line, which may be
+     * another GPIO opened from the same shared chip */
+    if (gpio->u.cdev.chip) {
+        for (gpio_t *watcher = gpio->u.cdev.chip->gpios; watcher != NULL; watcher = watcher->u.cdev.chip_next) {
+            if (watcher->u.cdev.line == info_changed->info.offset && watcher->u.cdev.line_info_cached)
+                _gpio_cdev_cache_line_info(watcher, &info_changed->info);
         }
+    } else if (gpio->u.cdev.line == info_changed->info.offset && gpio->u.cdev.line_info_cached) {
+        _gpio_cdev_cache_line_info(gpio, &info_changed->info);
+    }
 
-        if (ioctl(gpio->u.cdev.chip_fd, GPIO_V2_GET_LINE_IOCTL, &line_request) < 0)
-            return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening input line handle");
+    /* Queue event, dropping the oldest event if the queue is full */
+    if (queue->count == GPIO_LINE_INFO_QUEUE_SIZE) {
+        queue->head = (queue->head + 1) % GPIO_LINE_INFO_QUEUE_SIZE;
+        queue->count--;
+    }
 
-        gpio->u.cdev.line_fd = line_request.fd;
+    event = &queue->events[(queue->head + queue->count) % GPIO_LINE_INFO_QUEUE_SIZE];
+    event->change = (info_changed->event_type == GPIO_V2_LINE_CHANGED_REQUESTED) ? GPIO_LINE_INFO_REQUESTED :
+                    (info_changed->event_type == GPIO_V2_LINE_CHANGED_RELEASED) ? GPIO_LINE_INFO_RELEASED : GPIO_LINE_INFO_RECONFIGURED;
+    event->timestamp = info_changed->timestamp_ns;
+    event->line = info_changed->info.offset;
+    event->used = (info_changed->info.flags & GPIO_V2_LINE_FLAG_USED) ? true : false;
+    strncpy(event->consumer, info_changed->info.consumer, sizeof(event->consumer) - 1);
+    event->consumer[sizeof(event->consumer) - 1] = '\0';
+    queue->count++;
+}
+
+static int _gpio_cdev_read_line_info_events(gpio_t *gpio) {
+    struct gpio_v2_line_info_changed info_changed[GPIO_CDEV_LINE_INFO_FIFO_SIZE];
+    ssize_t ret;
+    size_t count;
+
+    /* Read available line info events, blocking until at least one */
+    if ((ret = read(gpio->u.cdev.chip_fd, info_changed, sizeof(info_changed))) < (ssize_t)sizeof(info_changed[0]))
+        return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Reading GPIO line info event");
+
+    count = (size_t)ret / sizeof(info_changed[0]);
+    for (size_t i = 0; i < count; i++)
+        _gpio_cdev_dispatch_line_info_event(gpio, &info_changed[i]);
+
+    /* A full kernel FIFO may have dropped later events, so the cached line
+     * info is requeried on next use */
+    if (count == GPIO_CDEV_LINE_INFO_FIFO_SIZE) {
+        if (gpio->u.cdev.chip) {
+            for (gpio_t *watcher = gpio->u.cdev.chip->gpios; watcher != NULL; watcher = watcher->u.cdev.chip_next)
+                watcher->u.cdev.line_info_stale = true;
+        } else {
+            gpio->u.cdev.line_info_stale = true;
+        }
+    }
+
+    return 0;
+}
+
+static int _gpio_cdev_configure(gpio_t *gpio, gpio_direction_t direction, gpio_edge_t edge, gpio_event_clock_t event_clock, uint32_t debounce_us, gpio_bias_t bias, gpio_drive_t drive, bool inverted) {
+    struct gpio_v2_line_config line_config = {0};
+
+    #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
+    if (event_clock == GPIO_EVENT_CLOCK_HTE)
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support GPIO event clock HTE");
+    #endif
+
+    line_config.flags = _gpio_cdev_flags(direction, edge, event_clock, bias, drive, inverted);
+
+    if (direction == GPIO_DIR_IN) {
+        if (debounce_us) {
+            line_config.num_attrs = 1;
+            line_config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+            line_config.attrs[0].attr.debounce_period_us = debounce_us;
+            line_config.attrs[0].mask = 1;
+        }
     } else {
-        struct gpio_v2_line_request line_request = {0};
+        bool initial_value;
+
+        if (direction == GPIO_DIR_OUT && gpio->u.cdev.line_fd >= 0 && gpio->u.cdev.direction == GPIO_DIR_OUT) {
+            /* Preserve the physical output level across reconfiguration */
+            struct gpio_v2_line_values line_values = {0, 1};
+
+            if (ioctl(gpio->u.cdev.line_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &line_values) < 0)
+                return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Getting line value");
+
+            initial_value = (line_values.bits & 0x1) ^ gpio->u.cdev.inverted;
+        } else {
+            initial_value = (direction == GPIO_DIR_OUT_HIGH) ? true : false;
+        }
 
-        bool initial_value = (direction == GPIO_DIR_OUT_HIGH) ? true : false;
         initial_value ^= inverted;
 
-        flags |= GPIO_V2_LINE_FLAG_OUTPUT;
+        line_config.num_attrs = 1;
+        line_config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        line_config.attrs[0].attr.values = initial_value & 0x1;
+        line_config.attrs[0].mask = 1;
+    }
+
+    if (gpio->u.cdev.line_fd < 0) {
+        /* Request line */
+        struct gpio_v2_line_request line_request = {0};
 
         line_request.offsets[0] = gpio->u.cdev.line;
         strncpy(line_request.consumer, gpio->u.cdev.label, sizeof(line_request.consumer) - 1);
         line_request.consumer[sizeof(line_request.consumer) - 1] = '\0';
-        line_request.config.flags = flags;
-        line_request.config.num_attrs = 1;
-        line_request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
-        line_request.config.attrs[0].attr.values = initial_value & 0x1;
-        line_request.config.attrs[0].mask = 1;
+        line_request.config = line_config;
         line_request.num_lines = 1;
+        line_request.event_buffer_size = gpio->u.cdev.event_buffer_size;
 
         if (ioctl(gpio->u.cdev.chip_fd, GPIO_V2_GET_LINE_IOCTL, &line_request) < 0)
-            return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening output line handle");
+            return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, (direction == GPIO_DIR_IN) ? "Opening input line handle" : "Opening output line handle");
 
         gpio->u.cdev.line_fd = line_request.fd;
+        gpio->u.cdev.last_line_seqno = 0;
+    } else {
+        /* Reconfigure line in place, retaining the line request, its
+         * pending edge events, and its output value */
+        if (ioctl(gpio->u.cdev.line_fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &line_config) < 0)
+            return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Configuring GPIO line");
     }
 
     gpio->u.cdev.direction = (direction == GPIO_DIR_IN) ? GPIO_DIR_IN : GPIO_DIR_OUT;
@@ -129,7 +261,7 @@ static int _gpio_cdev_reopen(gpio_t *gpio, gpio_direction_t direction, gpio_edge
     return 0;
 }
 
-static int gpio_cdev_read(gpio_t *gpio, bool *value) {
+int gpio_cdev_read(gpio_t *gpio, bool *value) {
     struct gpio_v2_line_values line_values = {0, 1};
 
     if (ioctl(gpio->u.cdev.line_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &line_values) < 0)
@@ -140,7 +272,7 @@ static int gpio_cdev_read(gpio_t *gpio, bool *value) {
     return 0;
 }
 
-static int gpio_cdev_write(gpio_t *gpio, bool value) {
+int gpio_cdev_write(gpio_t *gpio, bool value) {
     struct gpio_v2_line_values line_values = {0, 1};
 
     if (gpio->u.cdev.direction != GPIO_DIR_OUT)
@@ -171,6 +303,8 @@ static int gpio_cdev_read_event(gpio_t *gpio, gpio_edge_t *edge, uint64_t *times
     if (timestamp)
         *timestamp = line_event.timestamp_ns;
 
+    _gpio_cdev_account_event(gpio, line_event.line_seqno);
+
     return 0;
 }
 
@@ -189,6 +323,93 @@ static int gpio_cdev_poll(gpio_t *gpio, int timeout_ms) {
     return ret > 0;
 }
 
+static int gpio_cdev_read_events(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms) {
+    struct gpio_v2_line_event line_events[GPIO_CDEV_EVENTS_BATCH];
+    size_t count = 0;
+    ssize_t ret;
+
+    if (gpio->u.cdev.direction != GPIO_DIR_IN)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot read event of output GPIO");
+    else if (gpio->u.cdev.edge == GPIO_EDGE_NONE)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO edge not set");
+
+    if (max == 0)
+        return 0;
+
+    /* Wait for an event, unless blocking in read() */
+    if (timeout_ms >= 0 && (ret = gpio_cdev_poll(gpio, timeout_ms)) <= 0)
+        return ret;
+
+    while (count < max) {
+        size_t n = ((max - count) < GPIO_CDEV_EVENTS_BATCH) ? (max - count) : GPIO_CDEV_EVENTS_BATCH;
+
+        /* Read as many queued events as fit */
+        if ((ret = read(gpio->u.cdev.line_fd, line_events, n * sizeof(line_events[0]))) < (ssize_t)sizeof(line_events[0]))
+            return _gpio_error(gpio, GPIO_ERROR_IO, (ret < 0) ? errno : 0, "Reading GPIO events");
+
+        n = ret / sizeof(line_events[0]);
+
+        for (size_t i = 0; i < n; i++) {
+            gpio_event_t *event = &events[count + i];
+
+            event->edge = (line_events[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE) ? GPIO_EDGE_RISING :
+                          (line_events[i].id == GPIO_V2_LINE_EVENT_FALLING_EDGE) ? GPIO_EDGE_FALLING : GPIO_EDGE_NONE;
+            event->timestamp = line_events[i].timestamp_ns;
+            event->line = line_events[i].offset;
+            event->seqno = line_events[i].seqno;
+            event->line_seqno = line_events[i].line_seqno;
+
+            _gpio_cdev_account_event(gpio, line_events[i].line_seqno);
+        }
+
+        count += n;
+
+        /* Continue only if the batch was filled and more events are queued */
+        if (count == max || n < GPIO_CDEV_EVENTS_BATCH)
+            break;
+        else if ((ret = gpio_cdev_poll(gpio, 0)) < 0)
+            return ret;
+        else if (ret == 0)
+            break;
+    }
+
+    return count;
+}
+
+static int gpio_cdev_get_event_stats(gpio_t *gpio, gpio_event_stats_t *stats) {
+    /* Event stats may be updated by a background reader thread */
+    stats->events = __atomic_load_n(&gpio->u.cdev.event_stats.events, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&gpio->u.cdev.event_stats.dropped, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static int gpio_cdev_read_line_info_event(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms) {
+    struct gpio_line_info_queue *queue = _gpio_cdev_line_info_queue(gpio);
+    struct pollfd fds[1];
+    int ret;
+
+    if (queue->count == 0) {
+        /* Wait for a line info event, unless blocking in read() */
+        if (timeout_ms >= 0) {
+            fds[0].fd = gpio->u.cdev.chip_fd;
+            fds[0].events = POLLIN;
+            if ((ret = poll(fds, 1, timeout_ms)) < 0)
+                return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Polling GPIO chip");
+            else if (ret == 0)
+                return 0;
+        }
+
+        if ((ret = _gpio_cdev_read_line_info_events(gpio)) < 0)
+            return ret;
+    }
+
+    *event = queue->events[queue->head];
+    queue->head = (queue->head + 1) % GPIO_LINE_INFO_QUEUE_SIZE;
+    queue->count--;
+
+    return 1;
+}
+
 static int gpio_cdev_close(gpio_t *gpio) {
     /* Close line fd */
     if (gpio->u.cdev.line_fd >= 0) {
@@ -198,8 +419,30 @@ static int gpio_cdev_close(gpio_t *gpio) {
         gpio->u.cdev.line_fd = -1;
     }
 
-    /* Close chip fd */
-    if (gpio->u.cdev.chip_fd >= 0) {
+    /* Release shared chip or close chip fd */
+    if (gpio->u.cdev.chip) {
+        gpio_chip_t *chip = gpio->u.cdev.chip;
+        uint32_t offset = gpio->u.cdev.line;
+
+        /* Stop watching line info on the shared chip fd. This is best
+         * effort, as a stale watch only delivers extra line info events. */
+        if (gpio->u.cdev.line_info_cached)
+            ioctl(gpio->u.cdev.chip_fd, GPIO_GET_LINEINFO_UNWATCH_IOCTL, &offset);
+
+        for (gpio_t **watcher = &chip->gpios; *watcher != NULL; watcher = &(*watcher)->u.cdev.chip_next) {
+            if (*watcher == gpio) {
+                *watcher = gpio->u.cdev.chip_next;
+                break;
+            }
+        }
+        gpio->u.cdev.chip_next = NULL;
+
+        gpio->u.cdev.chip = NULL;
+        gpio->u.cdev.chip_fd = -1;
+
+        if (_gpio_chip_unref(chip) < 0)
+            return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO chip");
+    } else if (gpio->u.cdev.chip_fd >= 0) {
         if (close(gpio->u.cdev.chip_fd) < 0)
             return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO chip");
 
@@ -254,7 +497,7 @@ static int gpio_cdev_set_direction(gpio_t *gpio, gpio_direction_t direction) {
     if (gpio->u.cdev.direction == direction)
         return 0;
 
-    return _gpio_cdev_reopen(gpio, direction, GPIO_EDGE_NONE, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
+    return _gpio_cdev_configure(gpio, direction, GPIO_EDGE_NONE, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
 }
 
 static int gpio_cdev_set_edge(gpio_t *gpio, gpio_edge_t edge) {
@@ -267,7 +510,7 @@ static int gpio_cdev_set_edge(gpio_t *gpio, gpio_edge_t edge) {
     if (gpio->u.cdev.edge == edge)
         return 0;
 
-    return _gpio_cdev_reopen(gpio, gpio->u.cdev.direction, edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
+    return _gpio_cdev_configure(gpio, gpio->u.cdev.direction, edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
 }
 
 static int gpio_cdev_set_event_clock(gpio_t *gpio, gpio_event_clock_t event_clock) {
@@ -280,7 +523,7 @@ static int gpio_cdev_set_event_clock(gpio_t *gpio, gpio_event_clock_t event_cloc
     if (gpio->u.cdev.event_clock == event_clock)
         return 0;
 
-    return _gpio_cdev_reopen(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
+    return _gpio_cdev_configure(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
 }
 
 static int gpio_cdev_set_debounce_us(gpio_t *gpio, uint32_t debounce_us) {
@@ -290,7 +533,7 @@ static int gpio_cdev_set_debounce_us(gpio_t *gpio, uint32_t debounce_us) {
     if (gpio->u.cdev.debounce_us == debounce_us)
         return 0;
 
-    return _gpio_cdev_reopen(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
+    return _gpio_cdev_configure(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
 }
 
 static int gpio_cdev_set_bias(gpio_t *gpio, gpio_bias_t bias) {
@@ -300,7 +543,7 @@ static int gpio_cdev_set_bias(gpio_t *gpio, gpio_bias_t bias) {
     if (gpio->u.cdev.bias == bias)
         return 0;
 
-    return _gpio_cdev_reopen(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
+    return _gpio_cdev_configure(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, bias, gpio->u.cdev.drive, gpio->u.cdev.inverted);
 }
 
 static int gpio_cdev_set_drive(gpio_t *gpio, gpio_drive_t drive) {
@@ -313,14 +556,28 @@ static int gpio_cdev_set_drive(gpio_t *gpio, gpio_drive_t drive) {
     if (gpio->u.cdev.drive == drive)
         return 0;
 
-    return _gpio_cdev_reopen(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, drive, gpio->u.cdev.inverted);
+    return _gpio_cdev_configure(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, drive, gpio->u.cdev.inverted);
 }
 
 static int gpio_cdev_set_inverted(gpio_t *gpio, bool inverted) {
     if (gpio->u.cdev.inverted == inverted)
         return 0;
 
-    return _gpio_cdev_reopen(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, inverted);
+    return _gpio_cdev_configure(gpio, gpio->u.cdev.direction, gpio->u.cdev.edge, gpio->u.cdev.event_clock, gpio->u.cdev.debounce_us, gpio->u.cdev.bias, gpio->u.cdev.drive, inverted);
+}
+
+static int gpio_cdev_set_config(gpio_t *gpio, const gpio_config_t *config) {
+    const char *errmsg;
+
+    if ((errmsg = _gpio_cdev_check_config(config)) != NULL)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "%s", errmsg);
+
+    if (config->direction == gpio->u.cdev.direction && config->edge == gpio->u.cdev.edge &&
+            config->event_clock == gpio->u.cdev.event_clock && config->debounce_us == gpio->u.cdev.debounce_us &&
+            config->bias == gpio->u.cdev.bias && config->drive == gpio->u.cdev.drive && config->inverted == gpio->u.cdev.inverted)
+        return 0;
+
+    return _gpio_cdev_configure(gpio, config->direction, config->edge, config->event_clock, config->debounce_us, config->bias, config->drive, config->inverted);
 }
 
 static unsigned int gpio_cdev_line(gpio_t *gpio) {
@@ -331,35 +588,49 @@ static int gpio_cdev_fd(gpio_t *gpio) {
     return gpio->u.cdev.line_fd;
 }
 
-static int gpio_cdev_name(gpio_t *gpio, char *str, size_t len) {
+static int _gpio_cdev_refresh_line_info(gpio_t *gpio) {
     struct gpio_v2_line_info line_info = {0};
 
-    if (!len)
+    /* Serve cached line info of a watched line, which line info events
+     * update as they are read, unless events may have been dropped */
+    if (gpio->u.cdev.line_info_cached && !gpio->u.cdev.line_info_stale)
         return 0;
 
     line_info.offset = gpio->u.cdev.line;
-
     if (ioctl(gpio->u.cdev.chip_fd, GPIO_V2_GET_LINEINFO_IOCTL, &line_info) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Querying GPIO line info for line %u", gpio->u.cdev.line);
+        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Querying GPIO line info");
+
+    _gpio_cdev_cache_line_info(gpio, &line_info);
+    gpio->u.cdev.line_info_stale = false;
+
+    return 0;
+}
 
-    strncpy(str, line_info.name, len - 1);
+static int gpio_cdev_name(gpio_t *gpio, char *str, size_t len) {
+    int ret;
+
+    if (!len)
+        return 0;
+
+    if ((ret = _gpio_cdev_refresh_line_info(gpio)) < 0)
+        return ret;
+
+    strncpy(str, gpio->u.cdev.line_name, len - 1);
     str[len - 1] = '\0';
 
     return 0;
 }
 
 static int gpio_cdev_label(gpio_t *gpio, char *str, size_t len) {
-    struct gpio_v2_line_info line_info = {0};
+    int ret;
 
     if (!len)
         return 0;
 
-    line_info.offset = gpio->u.cdev.line;
-
-    if (ioctl(gpio->u.cdev.chip_fd, GPIO_V2_GET_LINEINFO_IOCTL, &line_info) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Querying GPIO line info for line %u", gpio->u.cdev.line);
+    if ((ret = _gpio_cdev_refresh_line_info(gpio)) < 0)
+        return ret;
 
-    strncpy(str, line_info.consumer, len - 1);
+    strncpy(str, gpio->u.cdev.line_consumer, len - 1);
     str[len - 1] = '\0';
 
     return 0;
@@ -369,31 +640,57 @@ static int gpio_cdev_chip_fd(gpio_t *gpio) {
     return gpio->u.cdev.chip_fd;
 }
 
-static int gpio_cdev_chip_name(gpio_t *gpio, char *str, size_t len) {
+static int _gpio_cdev_cache_chip_info(gpio_t *gpio) {
     struct gpiochip_info chip_info = {0};
 
-    if (!len)
+    if (gpio->u.cdev.chip_info_cached)
         return 0;
 
     if (ioctl(gpio->u.cdev.chip_fd, GPIO_GET_CHIPINFO_IOCTL, &chip_info) < 0)
         return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Querying GPIO chip info");
 
-    strncpy(str, chip_info.name, len - 1);
+    strncpy(gpio->u.cdev.chip_name, chip_info.name, sizeof(gpio->u.cdev.chip_name) - 1);
+    gpio->u.cdev.chip_name[sizeof(gpio->u.cdev.chip_name) - 1] = '\0';
+    strncpy(gpio->u.cdev.chip_label, chip_info.label, sizeof(gpio->u.cdev.chip_label) - 1);
+    gpio->u.cdev.chip_label[sizeof(gpio->u.cdev.chip_label) - 1] = '\0';
+    gpio->u.cdev.chip_info_cached = true;
+
+    return 0;
+}
+
+static int gpio_cdev_chip_name(gpio_t *gpio, char *str, size_t len) {
+    int ret;
+
+    if (!len)
+        return 0;
+
+    /* Use chip info cached by shared chip */
+    if (gpio->u.cdev.chip)
+        return gpio_chip_handle_name(gpio->u.cdev.chip, str, len);
+
+    if ((ret = _gpio_cdev_cache_chip_info(gpio)) < 0)
+        return ret;
+
+    strncpy(str, gpio->u.cdev.chip_name, len - 1);
     str[len - 1] = '\0';
 
     return 0;
 }
 
 static int gpio_cdev_chip_label(gpio_t *gpio, char *str, size_t len) {
-    struct gpiochip_info chip_info = {0};
+    int ret;
 
     if (!len)
         return 0;
 
-    if (ioctl(gpio->u.cdev.chip_fd, GPIO_GET_CHIPINFO_IOCTL, &chip_info) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Querying GPIO chip info");
+    /* Use chip info cached by shared chip */
+    if (gpio->u.cdev.chip)
+        return gpio_chip_handle_label(gpio->u.cdev.chip, str, len);
+
+    if ((ret = _gpio_cdev_cache_chip_info(gpio)) < 0)
+        return ret;
 
-    strncpy(str, chip_info.label, len - 1);
+    strncpy(str, gpio->u.cdev.chip_label, len - 1);
     str[len - 1] = '\0';
 
     return 0;
@@ -490,6 +787,9 @@ const struct gpio_ops gpio_cdev_ops = {
     .read = gpio_cdev_read,
     .write = gpio_cdev_write,
     .read_event = gpio_cdev_read_event,
+    .read_events = gpio_cdev_read_events,
+    .get_event_stats = gpio_cdev_get_event_stats,
+    .read_line_info_event = gpio_cdev_read_line_info_event,
     .poll = gpio_cdev_poll,
     .close = gpio_cdev_close,
     .get_direction = gpio_cdev_get_direction,
@@ -506,6 +806,7 @@ const struct gpio_ops gpio_cdev_ops = {
     .set_bias = gpio_cdev_set_bias,
     .set_drive = gpio_cdev_set_drive,
     .set_inverted = gpio_cdev_set_inverted,
+    .set_config = gpio_cdev_set_config,
     .line = gpio_cdev_line,
     .fd = gpio_cdev_fd,
     .name = gpio_cdev_name,
@@ -516,58 +817,485 @@ const struct gpio_ops gpio_cdev_ops = {
     .tostring = gpio_cdev_tostring,
 };
 
-int gpio_open_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config) {
-    int ret, fd;
+/*********************************************************************************/
+/* cdev v2 line name index */
+/*********************************************************************************/
 
-    if (config->direction != GPIO_DIR_IN && config->direction != GPIO_DIR_OUT && config->direction != GPIO_DIR_OUT_LOW && config->direction != GPIO_DIR_OUT_HIGH)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
+/* Initial number of hash buckets, doubled as entries are added */
+#define GPIO_INDEX_BUCKETS_MIN  64
 
-    if (config->edge != GPIO_EDGE_NONE && config->edge != GPIO_EDGE_RISING && config->edge != GPIO_EDGE_FALLING && config->edge != GPIO_EDGE_BOTH)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO interrupt edge (can be none, rising, falling, both)");
+/* Maximum number of line info changed events drained by a single read() */
+#define GPIO_INDEX_CHANGED_BATCH    16
 
-    if (config->event_clock != GPIO_EVENT_CLOCK_REALTIME && config->event_clock != GPIO_EVENT_CLOCK_MONOTONIC && config->event_clock != GPIO_EVENT_CLOCK_HTE)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO event clock (can be realtime, monotonic, hte)");
+struct gpio_index_chip {
+    char path[64];
+    dev_t rdev;
+    int fd;
+    unsigned int num_lines;
+    int *entries; /* entry index by line offset, -1 for unnamed lines */
+};
 
-    if (config->direction != GPIO_DIR_IN && config->edge != GPIO_EDGE_NONE)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO edge for output GPIO");
+struct gpio_index_entry {
+    char name[GPIO_MAX_NAME_SIZE];
+    uint32_t hash;
+    unsigned int chip;
+    unsigned int line;
+    int next;
+};
 
-    if (config->direction != GPIO_DIR_IN && config->debounce_us != 0)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO debounce for output GPIO");
+static struct {
+    bool valid;
+    struct gpio_index_chip *chips;
+    size_t num_chips;
+    struct gpio_index_entry *entries;
+    size_t num_entries;
+    int *buckets;
+    size_t num_buckets;
+} gpio_index;
 
-    if (config->bias != GPIO_BIAS_DEFAULT && config->bias != GPIO_BIAS_PULL_UP && config->bias != GPIO_BIAS_PULL_DOWN && config->bias != GPIO_BIAS_DISABLE)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line bias (can be default, pull_up, pull_down, disable)");
+static pthread_mutex_t gpio_index_lock = PTHREAD_MUTEX_INITIALIZER;
 
-    if (config->drive != GPIO_DRIVE_DEFAULT && config->drive != GPIO_DRIVE_OPEN_DRAIN && config->drive != GPIO_DRIVE_OPEN_SOURCE)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line drive (can be default, open_drain, open_source)");
+static uint32_t _gpio_index_hash(const char *name) {
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
 
-    if (config->direction == GPIO_DIR_IN && config->drive != GPIO_DRIVE_DEFAULT)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line drive for input GPIO");
+    while (*name)
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
 
-    /* Open GPIO chip */
-    if ((fd = open(path, 0)) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO chip");
+    return hash;
+}
+
+static void _gpio_index_clear(void) {
+    for (size_t i = 0; i < gpio_index.num_chips; i++) {
+        close(gpio_index.chips[i].fd);
+        free(gpio_index.chips[i].entries);
+    }
+
+    free(gpio_index.chips);
+    free(gpio_index.entries);
+    free(gpio_index.buckets);
+    memset(&gpio_index, 0, sizeof(gpio_index));
+}
+
+static int _gpio_index_insert(unsigned int chip, unsigned int line, const char *name) {
+    struct gpio_index_entry *entry;
+
+    /* Grow entries and rehash buckets to keep load factor under 1/2 */
+    if (gpio_index.num_entries * 2 >= gpio_index.num_buckets) {
+        size_t num_buckets = gpio_index.num_buckets ? gpio_index.num_buckets * 2 : GPIO_INDEX_BUCKETS_MIN;
+        struct gpio_index_entry *entries;
+        int *buckets;
+
+        if ((entries = realloc(gpio_index.entries, (num_buckets / 2) * sizeof(struct gpio_index_entry))) == NULL)
+            return -1;
+        gpio_index.entries = entries;
+
+        if ((buckets = malloc(num_buckets * sizeof(int))) == NULL)
+            return -1;
+
+        for (size_t i = 0; i < num_buckets; i++)
+            buckets[i] = -1;
+
+        for (size_t i = 0; i < gpio_index.num_entries; i++) {
+            size_t bucket = entries[i].hash & (num_buckets - 1);
+            entries[i].next = buckets[bucket];
+            buckets[bucket] = i;
+        }
+
+        free(gpio_index.buckets);
+        gpio_index.buckets = buckets;
+        gpio_index.num_buckets = num_buckets;
+    }
+
+    entry = &gpio_index.entries[gpio_index.num_entries];
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
+    entry->hash = _gpio_index_hash(entry->name);
+    entry->chip = chip;
+    entry->line = line;
+
+    /* Append to the end of the bucket chain, so lookups of duplicate names
+     * resolve to the lowest numbered chip */
+    int *link = &gpio_index.buckets[entry->hash & (gpio_index.num_buckets - 1)];
+    while (*link >= 0)
+        link = &gpio_index.entries[*link].next;
+    entry->next = -1;
+    *link = gpio_index.num_entries;
+
+    gpio_index.chips[chip].entries[line] = gpio_index.num_entries++;
+
+    return 0;
+}
+
+static int _gpio_index_compare_paths(const void *a, const void *b) {
+    const char *pa = ((const struct gpio_index_chip *)a)->path;
+    const char *pb = ((const struct gpio_index_chip *)b)->path;
+
+    /* Order by chip number */
+    return (strlen(pa) != strlen(pb)) ? (int)strlen(pa) - (int)strlen(pb) : strcmp(pa, pb);
+}
+
+static int _gpio_index_build(void) {
+    struct gpio_v2_line_info *line_infos = NULL;
+    struct dirent *dirent;
+    DIR *dir;
+
+    if ((dir = opendir("/dev")) == NULL)
+        return GPIO_ERROR_OPEN;
+
+    /* Collect GPIO chip device paths */
+    while ((dirent = readdir(dir)) != NULL) {
+        struct gpio_index_chip *chips;
+
+        if (strncmp(dirent->d_name, "gpiochip", 8) != 0 || strlen(dirent->d_name) > sizeof(gpio_index.chips[0].path) - 6)
+            continue;
+
+        if ((chips = realloc(gpio_index.chips, (gpio_index.num_chips + 1) * sizeof(struct gpio_index_chip))) == NULL) {
+            closedir(dir);
+            _gpio_index_clear();
+            return GPIO_ERROR_OPEN;
+        }
+
+        gpio_index.chips = chips;
+        memset(&chips[gpio_index.num_chips], 0, sizeof(struct gpio_index_chip));
+        strcpy(chips[gpio_index.num_chips].path, "/dev/");
+        strcat(chips[gpio_index.num_chips].path, dirent->d_name);
+        chips[gpio_index.num_chips].fd = -1;
+        gpio_index.num_chips++;
+    }
+
+    closedir(dir);
+
+    qsort(gpio_index.chips, gpio_index.num_chips, sizeof(struct gpio_index_chip), _gpio_index_compare_paths);
+
+    for (size_t i = 0; i < gpio_index.num_chips; i++) {
+        struct gpio_index_chip *chip = &gpio_index.chips[i];
+        struct gpiochip_info chip_info = {0};
+        struct stat stat_buf;
+
+        /* Skip chips that cannot be accessed */
+        if ((chip->fd = open(chip->path, O_RDONLY | O_NONBLOCK | O_CLOEXEC)) < 0)
+            continue;
+
+        if (fstat(chip->fd, &stat_buf) < 0 || ioctl(chip->fd, GPIO_GET_CHIPINFO_IOCTL, &chip_info) < 0) {
+            close(chip->fd);
+            chip->fd = -1;
+            continue;
+        }
+
+        chip->rdev = stat_buf.st_rdev;
+
+        if ((chip->entries = malloc(chip_info.lines * sizeof(int))) == NULL ||
+                (line_infos = realloc(line_infos, (chip_info.lines ? chip_info.lines : 1) * sizeof(struct gpio_v2_line_info))) == NULL) {
+            free(line_infos);
+            _gpio_index_clear();
+            return GPIO_ERROR_OPEN;
+        }
+
+        /* Query line info and watch it for changes in one ioctl. Skip chips
+         * that cannot be watched, e.g. on older kernels, as the index could
+         * not detect their name changes. Closing the fd drops the watches. */
+        unsigned int line;
+        for (line = 0; line < chip_info.lines; line++) {
+            memset(&line_infos[line], 0, sizeof(line_infos[line]));
+            line_infos[line].offset = line;
+
+            if (ioctl(chip->fd, GPIO_V2_GET_LINEINFO_WATCH_IOCTL, &line_infos[line]) < 0)
+                break;
+        }
+
+        if (line < chip_info.lines) {
+            close(chip->fd);
+            chip->fd = -1;
+            free(chip->entries);
+            chip->entries = NULL;
+            continue;
+        }
+
+        chip->num_lines = chip_info.lines;
+
+        for (line = 0; line < chip_info.lines; line++) {
+            chip->entries[line] = -1;
+
+            if (line_infos[line].name[0] != '\0' && _gpio_index_insert(i, line, line_infos[line].name) < 0) {
+                free(line_infos);
+                _gpio_index_clear();
+                return GPIO_ERROR_OPEN;
+            }
+        }
+    }
+
+    free(line_infos);
+
+    gpio_index.valid = true;
+
+    return 0;
+}
+
+static void _gpio_index_drain(void) {
+    for (size_t i = 0; i < gpio_index.num_chips; i++) {
+        struct gpio_index_chip *chip = &gpio_index.chips[i];
+        struct gpio_v2_line_info_changed changed[GPIO_INDEX_CHANGED_BATCH];
+        struct pollfd fds[1];
+        ssize_t ret;
+
+        if (chip->fd < 0)
+            continue;
+
+        fds[0].fd = chip->fd;
+        fds[0].events = POLLIN;
+
+        if (poll(fds, 1, 0) <= 0)
+            continue;
+
+        /* Chip removed */
+        if (fds[0].revents & (POLLERR | POLLHUP)) {
+            gpio_index.valid = false;
+            return;
+        }
+
+        while ((ret = read(chip->fd, changed, sizeof(changed))) >= (ssize_t)sizeof(changed[0])) {
+            for (size_t j = 0; j < ret / sizeof(changed[0]); j++) {
+                const struct gpio_v2_line_info *info = &changed[j].info;
+                int entry = (info->offset < chip->num_lines) ? chip->entries[info->offset] : -1;
+
+                /* Invalidate index on line name change */
+                if ((entry < 0 && info->name[0] != '\0') ||
+                        (entry >= 0 && strncmp(gpio_index.entries[entry].name, info->name, sizeof(info->name)) != 0)) {
+                    gpio_index.valid = false;
+                    return;
+                }
+            }
+        }
+
+        if (ret < 0 && errno != EAGAIN) {
+            gpio_index.valid = false;
+            return;
+        }
+    }
+}
+
+static int _gpio_index_lookup(const char *name, char *path, size_t len, unsigned int *line) {
+    int ret = GPIO_ERROR_NOT_FOUND;
+
+    pthread_mutex_lock(&gpio_index_lock);
+
+    /* Apply pending line info changes */
+    if (gpio_index.valid)
+        _gpio_index_drain();
+
+    /* (Re)build invalidated index */
+    if (!gpio_index.valid) {
+        _gpio_index_clear();
+
+        if ((ret = _gpio_index_build()) < 0) {
+            pthread_mutex_unlock(&gpio_index_lock);
+            return ret;
+        }
+
+        ret = GPIO_ERROR_NOT_FOUND;
+    }
+
+    if (gpio_index.num_buckets) {
+        uint32_t hash = _gpio_index_hash(name);
+
+        for (int i = gpio_index.buckets[hash & (gpio_index.num_buckets - 1)]; i >= 0; i = gpio_index.entries[i].next) {
+            const struct gpio_index_entry *entry = &gpio_index.entries[i];
+            const struct gpio_index_chip *chip = &gpio_index.chips[entry->chip];
+
+            if (entry->hash != hash || strcmp(entry->name, name) != 0)
+                continue;
+
+            if (path && len) {
+                strncpy(path, chip->path, len - 1);
+                path[len - 1] = '\0';
+            }
+            *line = entry->line;
+            ret = 0;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&gpio_index_lock);
+
+    return ret;
+}
+
+/* Look up a line name on the chip of device number rdev in an already built
+ * index. Returns 0 if found, GPIO_ERROR_NOT_FOUND if the indexed chip has no
+ * line of the name, or 1 if there is no index or the chip is not indexed. */
+static int _gpio_index_lookup_chip(dev_t rdev, const char *name, unsigned int *line) {
+    int ret = 1;
+
+    pthread_mutex_lock(&gpio_index_lock);
+
+    /* Apply pending line info changes */
+    if (gpio_index.valid)
+        _gpio_index_drain();
+
+    if (!gpio_index.valid) {
+        pthread_mutex_unlock(&gpio_index_lock);
+        return 1;
+    }
+
+    for (size_t i = 0; i < gpio_index.num_chips; i++) {
+        if (gpio_index.chips[i].fd >= 0 && gpio_index.chips[i].rdev == rdev) {
+            ret = GPIO_ERROR_NOT_FOUND;
+            break;
+        }
+    }
+
+    if (ret == GPIO_ERROR_NOT_FOUND && gpio_index.num_buckets) {
+        uint32_t hash = _gpio_index_hash(name);
+
+        /* Entries of a name are chained in chip and line order */
+        for (int i = gpio_index.buckets[hash & (gpio_index.num_buckets - 1)]; i >= 0; i = gpio_index.entries[i].next) {
+            const struct gpio_index_entry *entry = &gpio_index.entries[i];
+
+            if (entry->hash != hash || gpio_index.chips[entry->chip].rdev != rdev || strcmp(entry->name, name) != 0)
+                continue;
+
+            *line = entry->line;
+            ret = 0;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&gpio_index_lock);
+
+    return ret;
+}
+
+int gpio_index_lookup(const char *name, char *path, size_t len, unsigned int *line) {
+    return _gpio_index_lookup(name, path, len, line);
+}
+
+void gpio_index_invalidate(void) {
+    pthread_mutex_lock(&gpio_index_lock);
+    _gpio_index_clear();
+    pthread_mutex_unlock(&gpio_index_lock);
+}
+
+int gpio_open_name_any_advanced(gpio_t *gpio, const char *name, const gpio_config_t *config) {
+    char path[64];
+    unsigned int line;
+    int ret;
+
+    if ((ret = _gpio_index_lookup(name, path, sizeof(path), &line)) == GPIO_ERROR_NOT_FOUND)
+        return _gpio_error(gpio, GPIO_ERROR_NOT_FOUND, 0, "GPIO line \"%s\" not found by name", name);
+    else if (ret < 0)
+        return _gpio_error(gpio, ret, errno, "Indexing GPIO line names");
+
+    return gpio_open_advanced(gpio, path, line, config);
+}
+
+int gpio_open_name_any(gpio_t *gpio, const char *name, gpio_direction_t direction) {
+    gpio_config_t config = {
+        .direction = direction,
+        .edge = GPIO_EDGE_NONE,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+
+    return gpio_open_name_any_advanced(gpio, name, &config);
+}
+
+static int _gpio_cdev_open(gpio_t *gpio, int chip_fd, gpio_chip_t *chip, unsigned int line, const gpio_config_t *config) {
+    int ret;
 
     memset(gpio, 0, sizeof(gpio_t));
     gpio->ops = &gpio_cdev_ops;
     gpio->u.cdev.line = line;
     gpio->u.cdev.line_fd = -1;
-    gpio->u.cdev.chip_fd = fd;
+    gpio->u.cdev.chip_fd = chip_fd;
+    gpio->u.cdev.event_buffer_size = config->event_buffer_size;
     strncpy(gpio->u.cdev.label, config->label ? config->label : "periphery", sizeof(gpio->u.cdev.label) - 1);
     gpio->u.cdev.label[sizeof(gpio->u.cdev.label) - 1] = '\0';
 
+    /* Take reference on shared chip before using its fd */
+    if (chip) {
+        _gpio_chip_ref(chip);
+        gpio->u.cdev.chip = chip;
+    }
+
     /* Open GPIO line */
-    ret = _gpio_cdev_reopen(gpio, config->direction, config->edge, config->event_clock, config->debounce_us, config->bias, config->drive, config->inverted);
-    if (ret < 0) {
-        close(gpio->u.cdev.chip_fd);
+    if ((ret = _gpio_cdev_configure(gpio, config->direction, config->edge, config->event_clock, config->debounce_us, config->bias, config->drive, config->inverted)) < 0) {
+        gpio->u.cdev.chip = NULL;
         gpio->u.cdev.chip_fd = -1;
+        if (chip)
+            _gpio_chip_unref(chip);
         return ret;
     }
 
+    /* Query line info and watch it for changes, to serve line info from
+     * cache and deliver line info events on the chip fd. Without the watch,
+     * line info is queried on demand. */
+    struct gpio_v2_line_info line_info = {0};
+    line_info.offset = line;
+    if (ioctl(chip_fd, GPIO_V2_GET_LINEINFO_WATCH_IOCTL, &line_info) == 0) {
+        _gpio_cdev_cache_line_info(gpio, &line_info);
+        gpio->u.cdev.line_info_cached = true;
+    }
+
+    /* Register for line info events of the shared chip */
+    if (chip) {
+        gpio->u.cdev.chip_next = chip->gpios;
+        chip->gpios = gpio;
+    }
+
     return 0;
 }
 
+int gpio_open_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config) {
+    const char *errmsg;
+    int ret, fd;
+
+    if ((errmsg = _gpio_cdev_check_config(config)) != NULL)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "%s", errmsg);
+
+    /* Open GPIO chip */
+    if ((fd = open(path, 0)) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO chip");
+
+    /* Open GPIO line */
+    if ((ret = _gpio_cdev_open(gpio, fd, NULL, line, config)) < 0) {
+        close(fd);
+        return ret;
+    }
+
+    return 0;
+}
+
+int gpio_open_chip_advanced(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, const gpio_config_t *config) {
+    const char *errmsg;
+
+    if ((errmsg = _gpio_cdev_check_config(config)) != NULL)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "%s", errmsg);
+
+    if (!chip->opened)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO chip not open");
+
+    if (line >= chip->num_lines)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO line %u (chip has %u lines)", line, chip->num_lines);
+
+    return _gpio_cdev_open(gpio, chip->fd, chip, line, config);
+}
+
 int gpio_open_name_advanced(gpio_t *gpio, const char *path, const char *name, const gpio_config_t *config) {
-    int fd;
+    struct stat stat_buf;
+    unsigned int line;
+    int ret, fd;
+
+    /* Look up the line in the line name index, if it was built and indexes
+     * the chip, rather than querying every line of the chip */
+    if (stat(path, &stat_buf) == 0 && S_ISCHR(stat_buf.st_mode)) {
+        if ((ret = _gpio_index_lookup_chip(stat_buf.st_rdev, name, &line)) == 0)
+            return gpio_open_advanced(gpio, path, line, config);
+        else if (ret == GPIO_ERROR_NOT_FOUND)
+            return _gpio_error(gpio, GPIO_ERROR_NOT_FOUND, 0, "GPIO line \"%s\" not found by name", name);
+    }
 
     /* Open GPIO chip */
     if ((fd = open(path, 0)) < 0)
@@ -583,7 +1311,6 @@ int gpio_open_name_advanced(gpio_t *gpio, const char *path, const char *name, co
 
     /* Loop through every line */
     struct gpio_v2_line_info line_info = {0};
-    unsigned int line;
     for (line = 0; line < chip_info.lines; line++) {
         line_info.offset = line;
 
@@ -624,6 +1351,19 @@ int gpio_open(gpio_t *gpio, const char *path, unsigned int line, gpio_direction_
     return gpio_open_advanced(gpio, path, line, &config);
 }
 
+int gpio_open_chip(gpio_t *gpio, gpio_chip_t *chip, unsigned int line, gpio_direction_t direction) {
+    gpio_config_t config = {
+        .direction = direction,
+        .edge = GPIO_EDGE_NONE,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+
+    return gpio_open_chip_advanced(gpio, chip, line, &config);
+}
+
 int gpio_open_name(gpio_t *gpio, const char *path, const char *name, gpio_direction_t direction) {
     gpio_config_t config = {
         .direction = direction,
@@ -637,5 +1377,183 @@ int gpio_open_name(gpio_t *gpio, const char *path, const char *name, gpio_direct
     return gpio_open_name_advanced(gpio, path, name, &config);
 }
 
-#endif
+/*********************************************************************************/
+/* cdev v2 multiple lines implementation */
+/*********************************************************************************/
+
+int gpio_lines_open_advanced(gpio_lines_t *lines, const char *path, const unsigned int *offsets, size_t count, const gpio_config_t *config) {
+    struct gpio_v2_line_request line_request = {0};
+    const char *errmsg;
+    int fd;
+
+    if (count == 0 || count > GPIO_V2_LINES_MAX)
+        return _gpio_lines_error(lines, GPIO_ERROR_ARG, 0, "Invalid GPIO line count (can be 1 to %d)", GPIO_V2_LINES_MAX);
+
+    if ((errmsg = _gpio_cdev_check_config(config)) != NULL)
+        return _gpio_lines_error(lines, GPIO_ERROR_ARG, 0, "%s", errmsg);
+
+    #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
+    if (config->event_clock == GPIO_EVENT_CLOCK_HTE)
+        return _gpio_lines_error(lines, GPIO_ERROR_UNSUPPORTED, 0, "Kernel version does not support GPIO event clock HTE");
+    #endif
+
+    /* Open GPIO chip */
+    if ((fd = open(path, 0)) < 0)
+        return _gpio_lines_error(lines, GPIO_ERROR_OPEN, errno, "Opening GPIO chip");
+
+    memset(lines, 0, sizeof(gpio_lines_t));
+    lines->count = count;
+    lines->line_fd = -1;
+    lines->chip_fd = fd;
+    strncpy(lines->label, config->label ? config->label : "periphery", sizeof(lines->label) - 1);
+    lines->label[sizeof(lines->label) - 1] = '\0';
+
+    for (size_t i = 0; i < count; i++) {
+        lines->lines[i] = offsets[i];
+        line_request.offsets[i] = offsets[i];
+    }
+
+    strncpy(line_request.consumer, lines->label, sizeof(line_request.consumer) - 1);
+    line_request.consumer[sizeof(line_request.consumer) - 1] = '\0';
+    line_request.config.flags = _gpio_cdev_flags(config->direction, config->edge, config->event_clock, config->bias, config->drive, config->inverted);
+    line_request.num_lines = count;
+    line_request.event_buffer_size = config->event_buffer_size;
+
+    if (config->direction == GPIO_DIR_IN) {
+        if (config->debounce_us) {
+            line_request.config.num_attrs = 1;
+            line_request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+            line_request.config.attrs[0].attr.debounce_period_us = config->debounce_us;
+            line_request.config.attrs[0].mask = _gpio_lines_mask(count);
+        }
+    } else {
+        bool initial_value = (config->direction == GPIO_DIR_OUT_HIGH) ? true : false;
+        initial_value ^= config->inverted;
+
+        line_request.config.num_attrs = 1;
+        line_request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        line_request.config.attrs[0].attr.values = initial_value ? _gpio_lines_mask(count) : 0;
+        line_request.config.attrs[0].mask = _gpio_lines_mask(count);
+    }
+
+    if (ioctl(lines->chip_fd, GPIO_V2_GET_LINE_IOCTL, &line_request) < 0) {
+        int errsv = errno;
+        close(lines->chip_fd);
+        lines->chip_fd = -1;
+        return _gpio_lines_error(lines, GPIO_ERROR_OPEN, errsv, "Opening line handle for %zu lines", count);
+    }
+
+    lines->line_fd = line_request.fd;
+    lines->direction = (config->direction == GPIO_DIR_IN) ? GPIO_DIR_IN : GPIO_DIR_OUT;
+    lines->edge = config->edge;
+    lines->event_clock = config->event_clock;
+    lines->debounce_us = config->debounce_us;
+    lines->bias = config->bias;
+    lines->drive = config->drive;
+    lines->inverted = config->inverted;
+
+    return 0;
+}
+
+int gpio_lines_read(gpio_lines_t *lines, uint64_t mask, uint64_t *bits) {
+    struct gpio_v2_line_values line_values = {0};
+
+    if (mask & ~_gpio_lines_mask(lines->count))
+        return _gpio_lines_error(lines, GPIO_ERROR_ARG, 0, "Invalid line mask (lines requested: %zu)", lines->count);
+
+    if (!mask) {
+        *bits = 0;
+        return 0;
+    }
+
+    line_values.mask = mask;
+
+    if (ioctl(lines->line_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &line_values) < 0)
+        return _gpio_lines_error(lines, GPIO_ERROR_IO, errno, "Getting line values");
+
+    *bits = line_values.bits & mask;
+
+    return 0;
+}
+
+int gpio_lines_write(gpio_lines_t *lines, uint64_t mask, uint64_t bits) {
+    struct gpio_v2_line_values line_values = {0};
+
+    if (lines->direction != GPIO_DIR_OUT)
+        return _gpio_lines_error(lines, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot write to input GPIO lines");
+
+    if (mask & ~_gpio_lines_mask(lines->count))
+        return _gpio_lines_error(lines, GPIO_ERROR_ARG, 0, "Invalid line mask (lines requested: %zu)", lines->count);
+
+    if (!mask)
+        return 0;
 
+    line_values.mask = mask;
+    line_values.bits = bits & mask;
+
+    if (ioctl(lines->line_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &line_values) < 0)
+        return _gpio_lines_error(lines, GPIO_ERROR_IO, errno, "Setting line values");
+
+    return 0;
+}
+
+int gpio_lines_read_events(gpio_lines_t *lines, gpio_event_t *events, size_t max, int timeout_ms) {
+    struct gpio_v2_line_event line_events[GPIO_CDEV_EVENTS_BATCH];
+    struct pollfd fds[1];
+    size_t count = 0;
+    ssize_t ret;
+
+    if (lines->direction != GPIO_DIR_IN)
+        return _gpio_lines_error(lines, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot read events of output GPIO lines");
+    else if (lines->edge == GPIO_EDGE_NONE)
+        return _gpio_lines_error(lines, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO lines edge not set");
+
+    if (max == 0)
+        return 0;
+
+    fds[0].fd = lines->line_fd;
+    fds[0].events = POLLIN | POLLPRI | POLLERR;
+
+    /* Wait for an event, unless blocking in read() */
+    if (timeout_ms >= 0) {
+        if ((ret = poll(fds, 1, timeout_ms)) < 0)
+            return _gpio_lines_error(lines, GPIO_ERROR_IO, errno, "Polling GPIO lines");
+        else if (ret == 0)
+            return 0;
+    }
+
+    while (count < max) {
+        size_t n = ((max - count) < GPIO_CDEV_EVENTS_BATCH) ? (max - count) : GPIO_CDEV_EVENTS_BATCH;
+
+        /* Read as many queued events as fit */
+        if ((ret = read(lines->line_fd, line_events, n * sizeof(line_events[0]))) < (ssize_t)sizeof(line_events[0]))
+            return _gpio_lines_error(lines, GPIO_ERROR_IO, (ret < 0) ? errno : 0, "Reading GPIO lines events");
+
+        n = ret / sizeof(line_events[0]);
+
+        for (size_t i = 0; i < n; i++) {
+            gpio_event_t *event = &events[count + i];
+
+            event->edge = (line_events[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE) ? GPIO_EDGE_RISING :
+                          (line_events[i].id == GPIO_V2_LINE_EVENT_FALLING_EDGE) ? GPIO_EDGE_FALLING : GPIO_EDGE_NONE;
+            event->timestamp = line_events[i].timestamp_ns;
+            event->line = line_events[i].offset;
+            event->seqno = line_events[i].seqno;
+            event->line_seqno = line_events[i].line_seqno;
+        }
+
+        count += n;
+
+        /* Continue only if the batch was filled and more events are queued */
+        if (count == max || n < GPIO_CDEV_EVENTS_BATCH)
+            break;
+        else if ((ret = poll(fds, 1, 0)) < 0)
+            return _gpio_lines_error(lines, GPIO_ERROR_IO, errno, "Polling GPIO lines");
+        else if (ret == 0)
+            break;
+    }
+
+    return count;
+}
+
+#endif
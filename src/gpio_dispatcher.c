@@ -0,0 +1,664 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+
+#include "gpio_dispatcher.h"
+#include "gpio_internal.h"
+
+/* Maximum queue size */
+#define GPIO_DISPATCHER_QUEUE_MAX   ((size_t)1 << 24)
+
+/* Maximum number of ready GPIOs collected by a single epoll_wait() */
+#define GPIO_DISPATCHER_READY_MAX   16
+
+/* Maximum number of events drained from a GPIO, or dispatched by a worker, per
+ * wakeup */
+#define GPIO_DISPATCHER_BATCH       64
+
+struct gpio_dispatcher_worker;
+
+struct gpio_dispatcher_slot {
+    gpio_t *gpio;
+    gpio_dispatcher_callback_t callback;
+    void *ctx;
+    struct gpio_dispatcher_worker *worker;
+
+    /* updated by intake thread */
+    uint64_t events;
+    uint64_t dropped;
+    int code;
+    int c_errno;
+
+    /* updated by worker thread */
+    uint64_t dispatched;
+    uint64_t delay_min_ns;
+    uint64_t delay_max_ns;
+    double delay_mean_ns;
+};
+
+struct gpio_dispatcher_entry {
+    struct gpio_dispatcher_slot *slot;
+    uint64_t queued;    /* CLOCK_MONOTONIC timestamp in ns */
+    gpio_event_t event;
+};
+
+/* Single producer, single consumer entry queue, as struct gpio_event_ring */
+struct gpio_dispatcher_queue {
+    struct gpio_dispatcher_entry *entries;
+    size_t mask;
+    size_t head __attribute__((aligned(64)));
+    size_t tail __attribute__((aligned(64)));
+};
+
+struct gpio_dispatcher_worker {
+    struct gpio_dispatcher_queue queue;
+    int wake_fd;
+    bool waiting;
+    bool stop;
+    bool pending;       /* events queued since last wakeup, owned by intake thread */
+    size_t lines;
+    pthread_t thread;
+};
+
+struct gpio_dispatcher_handle {
+    int epoll_fd;
+    int stop_fd;
+    struct gpio_dispatcher_worker *workers;
+    unsigned int num_workers;
+    size_t queue_size;
+    struct gpio_dispatcher_slot **slots;
+    size_t count;
+    bool running;
+    pthread_t thread;
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_dispatcher_error(gpio_dispatcher_t *dispatcher, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    dispatcher->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(dispatcher->error.errmsg, sizeof(dispatcher->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(dispatcher->error.errmsg+strlen(dispatcher->error.errmsg), sizeof(dispatcher->error.errmsg)-strlen(dispatcher->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static uint64_t _gpio_dispatcher_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Push up to count events of a slot, returning the number of events pushed.
+ * Called only by the intake thread. */
+static size_t _gpio_dispatcher_queue_push(struct gpio_dispatcher_queue *queue, struct gpio_dispatcher_slot *slot, const gpio_event_t *events, size_t count, uint64_t queued) {
+    size_t head = queue->head;
+    size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    size_t space = queue->mask + 1 - (head - tail);
+
+    if (count > space)
+        count = space;
+
+    for (size_t i = 0; i < count; i++) {
+        struct gpio_dispatcher_entry *entry = &queue->entries[(head + i) & queue->mask];
+        entry->slot = slot;
+        entry->queued = queued;
+        entry->event = events[i];
+    }
+
+    __atomic_store_n(&queue->head, head + count, __ATOMIC_RELEASE);
+
+    return count;
+}
+
+/* Pop up to max entries, returning the number of entries popped. Called only
+ * by the worker thread. */
+static size_t _gpio_dispatcher_queue_pop(struct gpio_dispatcher_queue *queue, struct gpio_dispatcher_entry *entries, size_t max) {
+    size_t tail = queue->tail;
+    size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    size_t count = head - tail;
+
+    if (count > max)
+        count = max;
+
+    for (size_t i = 0; i < count; i++)
+        entries[i] = queue->entries[(tail + i) & queue->mask];
+
+    __atomic_store_n(&queue->tail, tail + count, __ATOMIC_RELEASE);
+
+    return count;
+}
+
+static bool _gpio_dispatcher_queue_empty(struct gpio_dispatcher_queue *queue) {
+    return __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == queue->tail;
+}
+
+static void _gpio_dispatcher_wake(struct gpio_dispatcher_worker *worker) {
+    uint64_t value = 1;
+
+    /* Wakeups are coalesced by the eventfd counter */
+    while (write(worker->wake_fd, &value, sizeof(value)) < 0 && errno == EINTR)
+        ;
+}
+
+static void _gpio_dispatcher_account(struct gpio_dispatcher_slot *slot, uint64_t delay_ns) {
+    uint64_t dispatched = slot->dispatched + 1;
+    double mean = slot->delay_mean_ns + ((double)delay_ns - slot->delay_mean_ns) / dispatched;
+
+    if (dispatched == 1 || delay_ns < slot->delay_min_ns)
+        __atomic_store_n(&slot->delay_min_ns, delay_ns, __ATOMIC_RELAXED);
+    if (delay_ns > slot->delay_max_ns)
+        __atomic_store_n(&slot->delay_max_ns, delay_ns, __ATOMIC_RELAXED);
+
+    __atomic_store(&slot->delay_mean_ns, &mean, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->dispatched, dispatched, __ATOMIC_RELAXED);
+}
+
+static void *_gpio_dispatcher_worker_thread(void *arg) {
+    struct gpio_dispatcher_worker *worker = (struct gpio_dispatcher_worker *)arg;
+    struct gpio_dispatcher_entry entries[GPIO_DISPATCHER_BATCH];
+
+    while (true) {
+        bool stop = __atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE);
+        size_t count;
+
+        if ((count = _gpio_dispatcher_queue_pop(&worker->queue, entries, GPIO_DISPATCHER_BATCH)) == 0) {
+            /* Intake thread is stopped before workers, so the queue is
+             * drained once stop is observed */
+            if (stop)
+                return NULL;
+
+            /* Sleep until the intake thread queues events or stops the
+             * worker. Paired with the fence in the intake thread, either the
+             * queued events are observed here, or waiting is observed there. */
+            __atomic_store_n(&worker->waiting, true, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+            if (_gpio_dispatcher_queue_empty(&worker->queue) && !__atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE)) {
+                uint64_t value;
+                while (read(worker->wake_fd, &value, sizeof(value)) < 0 && errno == EINTR)
+                    ;
+            }
+
+            __atomic_store_n(&worker->waiting, false, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            struct gpio_dispatcher_slot *slot = entries[i].slot;
+            uint64_t now = _gpio_dispatcher_now();
+
+            /* Queueing delay includes the callbacks ahead in the queue */
+            slot->callback(slot->gpio, &entries[i].event, slot->ctx);
+            _gpio_dispatcher_account(slot, (now > entries[i].queued) ? now - entries[i].queued : 0);
+        }
+    }
+}
+
+static void _gpio_dispatcher_slot_fail(gpio_dispatcher_t *dispatcher, struct gpio_dispatcher_slot *slot, int code, int c_errno) {
+    /* Stop watching the GPIO and publish the failure */
+    epoll_ctl(dispatcher->epoll_fd, EPOLL_CTL_DEL, gpio_fd(slot->gpio), NULL);
+
+    __atomic_store_n(&slot->c_errno, c_errno, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->code, code, __ATOMIC_RELEASE);
+}
+
+static void *_gpio_dispatcher_thread(void *arg) {
+    gpio_dispatcher_t *dispatcher = (gpio_dispatcher_t *)arg;
+    struct epoll_event ready[GPIO_DISPATCHER_READY_MAX];
+    gpio_event_t events[GPIO_DISPATCHER_BATCH];
+
+    while (true) {
+        uint64_t now;
+        int n;
+
+        if ((n = epoll_wait(dispatcher->epoll_fd, ready, GPIO_DISPATCHER_READY_MAX, -1)) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            /* Fail all GPIOs */
+            int errsv = errno;
+            for (size_t i = 0; i < dispatcher->count; i++)
+                _gpio_dispatcher_slot_fail(dispatcher, dispatcher->slots[i], GPIO_ERROR_IO, errsv);
+
+            return NULL;
+        }
+
+        now = _gpio_dispatcher_now();
+
+        for (int i = 0; i < n; i++) {
+            struct gpio_dispatcher_slot *slot = (struct gpio_dispatcher_slot *)ready[i].data.ptr;
+            size_t pushed;
+            int ret;
+
+            /* Stop requested */
+            if (slot == NULL)
+                return NULL;
+
+            if (!(ready[i].events & EPOLLIN)) {
+                _gpio_dispatcher_slot_fail(dispatcher, slot, GPIO_ERROR_IO, 0);
+                continue;
+            }
+
+            /* Drain a batch of events into the queue of the line's worker,
+             * dropping what does not fit rather than waiting on handlers */
+            if ((ret = slot->gpio->ops->read_events(slot->gpio, events, GPIO_DISPATCHER_BATCH, -1)) < 0) {
+                _gpio_dispatcher_slot_fail(dispatcher, slot, ret, slot->gpio->error.c_errno);
+                continue;
+            }
+
+            pushed = _gpio_dispatcher_queue_push(&slot->worker->queue, slot, events, ret, now);
+            slot->worker->pending |= pushed > 0;
+
+            __atomic_add_fetch(&slot->events, ret, __ATOMIC_RELAXED);
+            if (pushed < (size_t)ret)
+                __atomic_add_fetch(&slot->dropped, ret - pushed, __ATOMIC_RELAXED);
+        }
+
+        /* Wake sleeping workers with newly queued events */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        for (unsigned int i = 0; i < dispatcher->num_workers; i++) {
+            struct gpio_dispatcher_worker *worker = &dispatcher->workers[i];
+
+            if (worker->pending && __atomic_load_n(&worker->waiting, __ATOMIC_RELAXED))
+                _gpio_dispatcher_wake(worker);
+
+            worker->pending = false;
+        }
+    }
+}
+
+static struct gpio_dispatcher_slot *_gpio_dispatcher_find(gpio_dispatcher_t *dispatcher, gpio_t *gpio, size_t *index) {
+    for (size_t i = 0; i < dispatcher->count; i++) {
+        if (dispatcher->slots[i]->gpio == gpio) {
+            if (index)
+                *index = i;
+            return dispatcher->slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void _gpio_dispatcher_free_workers(struct gpio_dispatcher_worker *workers, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        if (workers[i].wake_fd >= 0)
+            close(workers[i].wake_fd);
+        free(workers[i].queue.entries);
+    }
+
+    free(workers);
+}
+
+static int _gpio_dispatcher_stop_workers(gpio_dispatcher_t *dispatcher, unsigned int count) {
+    int ret, err = 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        __atomic_store_n(&dispatcher->workers[i].stop, true, __ATOMIC_SEQ_CST);
+        _gpio_dispatcher_wake(&dispatcher->workers[i]);
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        if ((ret = pthread_join(dispatcher->workers[i].thread, NULL)) != 0 && err == 0)
+            err = ret;
+    }
+
+    return err;
+}
+
+gpio_dispatcher_t *gpio_dispatcher_new(void) {
+    gpio_dispatcher_t *dispatcher = calloc(1, sizeof(gpio_dispatcher_t));
+    if (dispatcher == NULL)
+        return NULL;
+
+    dispatcher->epoll_fd = -1;
+    dispatcher->stop_fd = -1;
+
+    return dispatcher;
+}
+
+void gpio_dispatcher_free(gpio_dispatcher_t *dispatcher) {
+    free(dispatcher);
+}
+
+int gpio_dispatcher_open(gpio_dispatcher_t *dispatcher, const gpio_dispatcher_config_t *config) {
+    struct gpio_dispatcher_worker *workers;
+    struct epoll_event ev = {0};
+    size_t queue_size;
+    int epoll_fd, stop_fd;
+
+    if (config->workers == 0 || config->workers > GPIO_DISPATCHER_WORKERS_MAX)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_ARG, 0, "Invalid workers (can be 1 to %d)", GPIO_DISPATCHER_WORKERS_MAX);
+    else if (config->queue_size == 0 || config->queue_size > GPIO_DISPATCHER_QUEUE_MAX)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_ARG, 0, "Invalid queue size (can be 1 to %zu)", GPIO_DISPATCHER_QUEUE_MAX);
+
+    /* Round queue size up to a power of two */
+    queue_size = 1;
+    while (queue_size < config->queue_size)
+        queue_size <<= 1;
+
+    /* Queue indices are cache line aligned */
+    if (posix_memalign((void **)&workers, 64, config->workers * sizeof(struct gpio_dispatcher_worker)) != 0)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, ENOMEM, "Allocating workers");
+
+    memset(workers, 0, config->workers * sizeof(struct gpio_dispatcher_worker));
+    for (unsigned int i = 0; i < config->workers; i++)
+        workers[i].wake_fd = -1;
+
+    for (unsigned int i = 0; i < config->workers; i++) {
+        workers[i].queue.mask = queue_size - 1;
+
+        if ((workers[i].queue.entries = calloc(queue_size, sizeof(struct gpio_dispatcher_entry))) == NULL) {
+            _gpio_dispatcher_free_workers(workers, config->workers);
+            return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, ENOMEM, "Allocating worker queue");
+        }
+
+        if ((workers[i].wake_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+            int errsv = errno;
+            _gpio_dispatcher_free_workers(workers, config->workers);
+            return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, errsv, "Creating worker eventfd");
+        }
+    }
+
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        int errsv = errno;
+        _gpio_dispatcher_free_workers(workers, config->workers);
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, errsv, "Creating epoll instance");
+    }
+
+    if ((stop_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        int errsv = errno;
+        close(epoll_fd);
+        _gpio_dispatcher_free_workers(workers, config->workers);
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, errsv, "Creating stop eventfd");
+    }
+
+    /* Stop eventfd is identified by a NULL slot */
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &ev) < 0) {
+        int errsv = errno;
+        close(stop_fd);
+        close(epoll_fd);
+        _gpio_dispatcher_free_workers(workers, config->workers);
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, errsv, "Adding stop eventfd to epoll instance");
+    }
+
+    memset(dispatcher, 0, sizeof(gpio_dispatcher_t));
+    dispatcher->epoll_fd = epoll_fd;
+    dispatcher->stop_fd = stop_fd;
+    dispatcher->workers = workers;
+    dispatcher->num_workers = config->workers;
+    dispatcher->queue_size = queue_size;
+
+    return 0;
+}
+
+int gpio_dispatcher_add(gpio_dispatcher_t *dispatcher, gpio_t *gpio, gpio_dispatcher_callback_t callback, void *ctx) {
+    struct gpio_dispatcher_slot *slot, **slots;
+    struct gpio_dispatcher_worker *worker;
+    struct epoll_event ev = {0};
+
+    if (dispatcher->workers == NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: dispatcher not open");
+    else if (dispatcher->running)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot add GPIO to running dispatcher");
+
+    if (callback == NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_ARG, 0, "Invalid callback (NULL)");
+
+    if (_gpio_is_sysfs(gpio))
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support dispatcher");
+
+    if (_gpio_dispatcher_find(dispatcher, gpio, NULL) != NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_ARG, 0, "GPIO %u already added to dispatcher", gpio_line(gpio));
+
+    if ((slots = realloc(dispatcher->slots, (dispatcher->count + 1) * sizeof(struct gpio_dispatcher_slot *))) == NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, errno, "Allocating dispatcher slots");
+    dispatcher->slots = slots;
+
+    if ((slot = calloc(1, sizeof(struct gpio_dispatcher_slot))) == NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_OPEN, ENOMEM, "Allocating dispatcher slot");
+
+    /* All events of a line go to one worker, preserving their order. Assign
+     * the worker with the fewest lines. */
+    worker = &dispatcher->workers[0];
+    for (unsigned int i = 1; i < dispatcher->num_workers; i++) {
+        if (dispatcher->workers[i].lines < worker->lines)
+            worker = &dispatcher->workers[i];
+    }
+
+    slot->gpio = gpio;
+    slot->callback = callback;
+    slot->ctx = ctx;
+    slot->worker = worker;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = slot;
+
+    if (epoll_ctl(dispatcher->epoll_fd, EPOLL_CTL_ADD, gpio_fd(gpio), &ev) < 0) {
+        int errsv = errno;
+        free(slot);
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, errsv, "Adding GPIO %u to dispatcher", gpio_line(gpio));
+    }
+
+    worker->lines++;
+    dispatcher->slots[dispatcher->count++] = slot;
+
+    return 0;
+}
+
+int gpio_dispatcher_remove(gpio_dispatcher_t *dispatcher, gpio_t *gpio) {
+    struct gpio_dispatcher_slot *slot;
+    size_t index;
+
+    if (dispatcher->running)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot remove GPIO from running dispatcher");
+
+    if ((slot = _gpio_dispatcher_find(dispatcher, gpio, &index)) == NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_ARG, 0, "GPIO %u not added to dispatcher", gpio_line(gpio));
+
+    /* GPIO may already be removed from epoll instance by a failure */
+    if (epoll_ctl(dispatcher->epoll_fd, EPOLL_CTL_DEL, gpio_fd(gpio), NULL) < 0 && errno != ENOENT)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, errno, "Removing GPIO %u from dispatcher", gpio_line(gpio));
+
+    slot->worker->lines--;
+    free(slot);
+
+    dispatcher->slots[index] = dispatcher->slots[--dispatcher->count];
+
+    return 0;
+}
+
+int gpio_dispatcher_start(gpio_dispatcher_t *dispatcher) {
+    int ret;
+
+    if (dispatcher->running)
+        return 0;
+
+    if (dispatcher->workers == NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: dispatcher not open");
+
+    /* Start workers, then intake thread */
+    for (unsigned int i = 0; i < dispatcher->num_workers; i++) {
+        dispatcher->workers[i].stop = false;
+
+        if ((ret = pthread_create(&dispatcher->workers[i].thread, NULL, _gpio_dispatcher_worker_thread, &dispatcher->workers[i])) != 0) {
+            _gpio_dispatcher_stop_workers(dispatcher, i);
+            return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, ret, "Creating worker thread");
+        }
+    }
+
+    if ((ret = pthread_create(&dispatcher->thread, NULL, _gpio_dispatcher_thread, dispatcher)) != 0) {
+        _gpio_dispatcher_stop_workers(dispatcher, dispatcher->num_workers);
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, ret, "Creating intake thread");
+    }
+
+    dispatcher->running = true;
+
+    return 0;
+}
+
+int gpio_dispatcher_stop(gpio_dispatcher_t *dispatcher) {
+    uint64_t value = 1;
+    int ret;
+
+    if (!dispatcher->running)
+        return 0;
+
+    /* Stop intake thread */
+    if (write(dispatcher->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, errno, "Signaling intake thread");
+
+    if ((ret = pthread_join(dispatcher->thread, NULL)) != 0)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, ret, "Joining intake thread");
+
+    /* Reset stop eventfd */
+    if (read(dispatcher->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, errno, "Resetting stop eventfd");
+
+    dispatcher->running = false;
+
+    /* Stop workers, once they have dispatched their queued events */
+    if ((ret = _gpio_dispatcher_stop_workers(dispatcher, dispatcher->num_workers)) != 0)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CONFIGURE, ret, "Joining worker thread");
+
+    return 0;
+}
+
+int gpio_dispatcher_get_stats(gpio_dispatcher_t *dispatcher, gpio_t *gpio, gpio_dispatcher_stats_t *stats) {
+    struct gpio_dispatcher_slot *slot = NULL;
+    double delay_sum_ns = 0;
+    int code;
+
+    if (gpio && (slot = _gpio_dispatcher_find(dispatcher, gpio, NULL)) == NULL)
+        return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_ARG, 0, "GPIO %u not added to dispatcher", gpio_line(gpio));
+
+    memset(stats, 0, sizeof(gpio_dispatcher_stats_t));
+
+    /* Aggregate one line, or all lines */
+    for (size_t i = 0; i < dispatcher->count; i++) {
+        struct gpio_dispatcher_slot *s = dispatcher->slots[i];
+        uint64_t dispatched, delay_min_ns;
+        double delay_mean_ns;
+
+        if (slot && s != slot)
+            continue;
+
+        dispatched = __atomic_load_n(&s->dispatched, __ATOMIC_RELAXED);
+        delay_min_ns = __atomic_load_n(&s->delay_min_ns, __ATOMIC_RELAXED);
+        __atomic_load(&s->delay_mean_ns, &delay_mean_ns, __ATOMIC_RELAXED);
+
+        stats->events += __atomic_load_n(&s->events, __ATOMIC_RELAXED);
+        stats->dropped += __atomic_load_n(&s->dropped, __ATOMIC_RELAXED);
+
+        if (dispatched == 0)
+            continue;
+
+        if (stats->dispatched == 0 || delay_min_ns < stats->delay_min_ns)
+            stats->delay_min_ns = delay_min_ns;
+        if (__atomic_load_n(&s->delay_max_ns, __ATOMIC_RELAXED) > stats->delay_max_ns)
+            stats->delay_max_ns = __atomic_load_n(&s->delay_max_ns, __ATOMIC_RELAXED);
+
+        stats->dispatched += dispatched;
+        delay_sum_ns += delay_mean_ns * dispatched;
+    }
+
+    if (stats->dispatched)
+        stats->delay_mean_ns = delay_sum_ns / stats->dispatched;
+
+    /* Report intake failure of the line */
+    if (slot && (code = __atomic_load_n(&slot->code, __ATOMIC_ACQUIRE)) < 0)
+        return _gpio_dispatcher_error(dispatcher, code, __atomic_load_n(&slot->c_errno, __ATOMIC_RELAXED), "Reading events of GPIO %u", gpio_line(gpio));
+
+    return 0;
+}
+
+int gpio_dispatcher_close(gpio_dispatcher_t *dispatcher) {
+    int ret;
+
+    if ((ret = gpio_dispatcher_stop(dispatcher)) < 0)
+        return ret;
+
+    for (size_t i = 0; i < dispatcher->count; i++)
+        free(dispatcher->slots[i]);
+
+    free(dispatcher->slots);
+    dispatcher->slots = NULL;
+    dispatcher->count = 0;
+
+    if (dispatcher->workers) {
+        _gpio_dispatcher_free_workers(dispatcher->workers, dispatcher->num_workers);
+        dispatcher->workers = NULL;
+        dispatcher->num_workers = 0;
+    }
+
+    if (dispatcher->stop_fd >= 0) {
+        if (close(dispatcher->stop_fd) < 0)
+            return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CLOSE, errno, "Closing stop eventfd");
+
+        dispatcher->stop_fd = -1;
+    }
+
+    if (dispatcher->epoll_fd >= 0) {
+        if (close(dispatcher->epoll_fd) < 0)
+            return _gpio_dispatcher_error(dispatcher, GPIO_ERROR_CLOSE, errno, "Closing epoll instance");
+
+        dispatcher->epoll_fd = -1;
+    }
+
+    return 0;
+}
+
+size_t gpio_dispatcher_count(gpio_dispatcher_t *dispatcher) {
+    return dispatcher->count;
+}
+
+bool gpio_dispatcher_running(gpio_dispatcher_t *dispatcher) {
+    return dispatcher->running;
+}
+
+int gpio_dispatcher_tostring(gpio_dispatcher_t *dispatcher, char *str, size_t len) {
+    return snprintf(str, len, "GPIO Dispatcher (lines=%zu, workers=%u, queue_size=%zu, running=%s)",
+                    dispatcher->count, dispatcher->num_workers, dispatcher->queue_size, dispatcher->running ? "true" : "false");
+}
+
+int gpio_dispatcher_errno(gpio_dispatcher_t *dispatcher) {
+    return dispatcher->error.c_errno;
+}
+
+const char *gpio_dispatcher_errmsg(gpio_dispatcher_t *dispatcher) {
+    return dispatcher->error.errmsg;
+}
@@ -0,0 +1,69 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_DISPATCHER_H
+#define _PERIPHERY_GPIO_DISPATCHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio.h"
+
+/* Maximum number of worker threads */
+#define GPIO_DISPATCHER_WORKERS_MAX     64
+
+/* Event callback, called from a worker thread */
+typedef void (*gpio_dispatcher_callback_t)(gpio_t *gpio, const gpio_event_t *event, void *ctx);
+
+/* Configuration structure for gpio_dispatcher_open() */
+typedef struct gpio_dispatcher_config {
+    unsigned int workers;   /* Worker threads */
+    size_t queue_size;      /* Event queue size of each worker */
+} gpio_dispatcher_config_t;
+
+/* Dispatcher statistics structure for gpio_dispatcher_get_stats() */
+typedef struct gpio_dispatcher_stats {
+    uint64_t events;            /* Events read from the lines */
+    uint64_t dropped;           /* Events lost to a full worker queue */
+    uint64_t dispatched;        /* Callbacks completed */
+    uint64_t delay_min_ns;      /* Minimum queueing delay */
+    uint64_t delay_max_ns;      /* Maximum queueing delay */
+    double delay_mean_ns;       /* Mean queueing delay */
+} gpio_dispatcher_stats_t;
+
+typedef struct gpio_dispatcher_handle gpio_dispatcher_t;
+
+/* Primary Functions */
+gpio_dispatcher_t *gpio_dispatcher_new(void);
+int gpio_dispatcher_open(gpio_dispatcher_t *dispatcher, const gpio_dispatcher_config_t *config);
+int gpio_dispatcher_add(gpio_dispatcher_t *dispatcher, gpio_t *gpio, gpio_dispatcher_callback_t callback, void *ctx);
+int gpio_dispatcher_remove(gpio_dispatcher_t *dispatcher, gpio_t *gpio);
+int gpio_dispatcher_start(gpio_dispatcher_t *dispatcher);
+int gpio_dispatcher_stop(gpio_dispatcher_t *dispatcher);
+int gpio_dispatcher_get_stats(gpio_dispatcher_t *dispatcher, gpio_t *gpio, gpio_dispatcher_stats_t *stats);
+int gpio_dispatcher_close(gpio_dispatcher_t *dispatcher);
+void gpio_dispatcher_free(gpio_dispatcher_t *dispatcher);
+
+/* Miscellaneous */
+size_t gpio_dispatcher_count(gpio_dispatcher_t *dispatcher);
+bool gpio_dispatcher_running(gpio_dispatcher_t *dispatcher);
+int gpio_dispatcher_tostring(gpio_dispatcher_t *dispatcher, char *str, size_t len);
+
+/* Error Handling */
+int gpio_dispatcher_errno(gpio_dispatcher_t *dispatcher);
+const char *gpio_dispatcher_errmsg(gpio_dispatcher_t *dispatcher);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,345 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <errno.h>
+
+#include "gpio_encoder.h"
+
+/* Maximum number of events read by a single gpio_encoder_update() */
+#define GPIO_ENCODER_EVENTS_BATCH   64
+
+/* Default velocity measurement window */
+#define GPIO_ENCODER_VELOCITY_WINDOW_US_DEFAULT 10000
+
+/* Quadrature state transition table, indexed by (previous state << 2) |
+ * current state, where state is (A << 1) | B. The sequence 00 -> 01 -> 11 ->
+ * 10 -> 00 counts up, and 0 marks illegal transitions. */
+static const int8_t gpio_encoder_table[16] = {
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0,
+};
+
+struct gpio_encoder_handle {
+    gpio_lines_t *lines;
+    unsigned int line_a;
+    unsigned int line_b;
+    gpio_event_clock_t event_clock;
+    bool inverted;
+
+    /* decoder state */
+    unsigned int state;
+    bool synced;
+    bool have_seqno;
+    uint32_t last_seqno;
+
+    /* velocity window */
+    uint64_t velocity_window_ns;
+    bool have_window;
+    uint64_t window_timestamp;
+    int64_t window_position;
+    uint64_t last_timestamp;
+
+    /* published results, read without locking */
+    int64_t position;
+    double velocity;
+    gpio_encoder_stats_t stats;
+
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_encoder_error(gpio_encoder_t *encoder, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    encoder->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(encoder->error.errmsg, sizeof(encoder->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(encoder->error.errmsg+strlen(encoder->error.errmsg), sizeof(encoder->error.errmsg)-strlen(encoder->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static void _gpio_encoder_set_velocity(gpio_encoder_t *encoder, double velocity) {
+    __atomic_store(&encoder->velocity, &velocity, __ATOMIC_RELAXED);
+}
+
+static void _gpio_encoder_event(gpio_encoder_t *encoder, const gpio_event_t *event) {
+    unsigned int bit, state;
+    int delta;
+
+    if (event->line == encoder->line_a)
+        bit = 0x2;
+    else if (event->line == encoder->line_b)
+        bit = 0x1;
+    else
+        return;
+
+    /* Detect events dropped by the kernel from request sequence number gaps */
+    if (event->seqno) {
+        if (encoder->have_seqno && event->seqno != encoder->last_seqno + 1) {
+            __atomic_store_n(&encoder->stats.dropped, encoder->stats.dropped + (uint32_t)(event->seqno - encoder->last_seqno - 1), __ATOMIC_RELAXED);
+            encoder->synced = false;
+        }
+        encoder->have_seqno = true;
+        encoder->last_seqno = event->seqno;
+    }
+
+    if (event->edge == GPIO_EDGE_RISING)
+        state = encoder->state | bit;
+    else if (event->edge == GPIO_EDGE_FALLING)
+        state = encoder->state & ~bit;
+    else
+        return;
+
+    delta = gpio_encoder_table[(encoder->state << 2) | state];
+    encoder->state = state;
+
+    if (delta == 0) {
+        /* Each event changes one line, so an illegal transition is an edge
+         * to the level already held, i.e. the opposite edge was missed,
+         * unless state is being resynchronized */
+        if (encoder->synced)
+            __atomic_store_n(&encoder->stats.errors, encoder->stats.errors + 1, __ATOMIC_RELAXED);
+        encoder->synced = true;
+        return;
+    }
+
+    encoder->synced = true;
+
+    if (encoder->inverted)
+        delta = -delta;
+
+    __atomic_store_n(&encoder->position, encoder->position + delta, __ATOMIC_RELAXED);
+    __atomic_store_n(&encoder->stats.transitions, encoder->stats.transitions + 1, __ATOMIC_RELAXED);
+
+    /* Update velocity at the end of each measurement window */
+    if (!encoder->have_window || event->timestamp < encoder->window_timestamp) {
+        encoder->have_window = true;
+        encoder->window_timestamp = event->timestamp;
+        encoder->window_position = encoder->position;
+    } else if (event->timestamp - encoder->window_timestamp >= encoder->velocity_window_ns) {
+        _gpio_encoder_set_velocity(encoder, (double)(encoder->position - encoder->window_position) * 1e9 /
+                                            (double)(event->timestamp - encoder->window_timestamp));
+        encoder->window_timestamp = event->timestamp;
+        encoder->window_position = encoder->position;
+    }
+
+    encoder->last_timestamp = event->timestamp;
+}
+
+static void _gpio_encoder_check_idle(gpio_encoder_t *encoder) {
+    struct timespec ts;
+    uint64_t now;
+
+    if (!encoder->have_window)
+        return;
+
+    /* Hardware timestamps cannot be compared against a system clock */
+    if (encoder->event_clock == GPIO_EVENT_CLOCK_HTE)
+        return;
+
+    if (clock_gettime(encoder->event_clock == GPIO_EVENT_CLOCK_REALTIME ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts) < 0)
+        return;
+
+    now = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+
+    /* Report zero velocity once a full window passes without transitions */
+    if (now > encoder->last_timestamp && now - encoder->last_timestamp >= encoder->velocity_window_ns) {
+        _gpio_encoder_set_velocity(encoder, 0.0);
+        encoder->have_window = false;
+    }
+}
+
+gpio_encoder_t *gpio_encoder_new(void) {
+    gpio_encoder_t *encoder = calloc(1, sizeof(gpio_encoder_t));
+    if (encoder == NULL)
+        return NULL;
+
+    return encoder;
+}
+
+void gpio_encoder_free(gpio_encoder_t *encoder) {
+    free(encoder);
+}
+
+int gpio_encoder_open(gpio_encoder_t *encoder, const char *path, unsigned int line_a, unsigned int line_b) {
+    gpio_encoder_config_t config = {
+        .bias = GPIO_BIAS_DEFAULT,
+        .event_clock = GPIO_EVENT_CLOCK_MONOTONIC,
+        .debounce_us = 0,
+        .inverted = false,
+        .velocity_window_us = 0,
+        .event_buffer_size = 0,
+        .label = NULL,
+    };
+
+    return gpio_encoder_open_advanced(encoder, path, line_a, line_b, &config);
+}
+
+int gpio_encoder_open_advanced(gpio_encoder_t *encoder, const char *path, unsigned int line_a, unsigned int line_b, const gpio_encoder_config_t *config) {
+    gpio_lines_t *lines = NULL;
+    uint64_t bits = 0;
+    int ret;
+
+    if (line_a == line_b)
+        return _gpio_encoder_error(encoder, GPIO_ERROR_ARG, 0, "Invalid lines (A and B must differ)");
+
+    /* Path is optional, for decoding events fed by the caller */
+    if (path) {
+        unsigned int offsets[2] = {line_a, line_b};
+        gpio_config_t lines_config = {
+            .direction = GPIO_DIR_IN,
+            .edge = GPIO_EDGE_BOTH,
+            .event_clock = config->event_clock,
+            .debounce_us = config->debounce_us,
+            .event_buffer_size = config->event_buffer_size,
+            .bias = config->bias,
+            .drive = GPIO_DRIVE_DEFAULT,
+            .inverted = false,
+            .label = config->label,
+        };
+
+        if ((lines = gpio_lines_new()) == NULL)
+            return _gpio_encoder_error(encoder, GPIO_ERROR_OPEN, ENOMEM, "Allocating GPIO lines handle");
+
+        /* Request both lines together, so their events are ordered in a
+         * single event queue */
+        if ((ret = gpio_lines_open_advanced(lines, path, offsets, 2, &lines_config)) < 0) {
+            _gpio_encoder_error(encoder, ret, gpio_lines_errno(lines), "Opening GPIO lines: %s", gpio_lines_errmsg(lines));
+            gpio_lines_free(lines);
+            return ret;
+        }
+
+        /* Read initial state */
+        if ((ret = gpio_lines_read(lines, 0x3, &bits)) < 0) {
+            _gpio_encoder_error(encoder, ret, gpio_lines_errno(lines), "Reading initial state");
+            gpio_lines_close(lines);
+            gpio_lines_free(lines);
+            return ret;
+        }
+    }
+
+    memset(encoder, 0, sizeof(gpio_encoder_t));
+    encoder->lines = lines;
+    encoder->line_a = line_a;
+    encoder->line_b = line_b;
+    encoder->event_clock = config->event_clock;
+    encoder->inverted = config->inverted;
+    encoder->velocity_window_ns = (uint64_t)(config->velocity_window_us ? config->velocity_window_us : GPIO_ENCODER_VELOCITY_WINDOW_US_DEFAULT) * 1000;
+    encoder->state = ((bits & 0x1) ? 0x2 : 0) | ((bits & 0x2) ? 0x1 : 0);
+
+    /* An edge queued between the line request and the initial state read is
+     * redundant, so resynchronize on the first event */
+    encoder->synced = false;
+
+    return 0;
+}
+
+int gpio_encoder_update(gpio_encoder_t *encoder, int timeout_ms) {
+    gpio_event_t events[GPIO_ENCODER_EVENTS_BATCH];
+    int ret;
+
+    if (encoder->lines == NULL)
+        return _gpio_encoder_error(encoder, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: no GPIO lines to read events from");
+
+    if ((ret = gpio_lines_read_events(encoder->lines, events, GPIO_ENCODER_EVENTS_BATCH, timeout_ms)) < 0)
+        return _gpio_encoder_error(encoder, ret, gpio_lines_errno(encoder->lines), "Reading GPIO lines events");
+
+    if (ret == 0) {
+        _gpio_encoder_check_idle(encoder);
+        return 0;
+    }
+
+    return gpio_encoder_feed(encoder, events, ret);
+}
+
+int gpio_encoder_feed(gpio_encoder_t *encoder, const gpio_event_t *events, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        _gpio_encoder_event(encoder, &events[i]);
+
+    return count;
+}
+
+int64_t gpio_encoder_get_position(gpio_encoder_t *encoder) {
+    return __atomic_load_n(&encoder->position, __ATOMIC_RELAXED);
+}
+
+double gpio_encoder_get_velocity(gpio_encoder_t *encoder) {
+    double velocity;
+
+    __atomic_load(&encoder->velocity, &velocity, __ATOMIC_RELAXED);
+
+    return velocity;
+}
+
+int gpio_encoder_get_stats(gpio_encoder_t *encoder, gpio_encoder_stats_t *stats) {
+    stats->transitions = __atomic_load_n(&encoder->stats.transitions, __ATOMIC_RELAXED);
+    stats->errors = __atomic_load_n(&encoder->stats.errors, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&encoder->stats.dropped, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+void gpio_encoder_set_position(gpio_encoder_t *encoder, int64_t position) {
+    __atomic_store_n(&encoder->position, position, __ATOMIC_RELAXED);
+    encoder->have_window = false;
+}
+
+int gpio_encoder_close(gpio_encoder_t *encoder) {
+    int ret;
+
+    if (encoder->lines == NULL)
+        return 0;
+
+    if ((ret = gpio_lines_close(encoder->lines)) < 0)
+        return _gpio_encoder_error(encoder, ret, gpio_lines_errno(encoder->lines), "Closing GPIO lines");
+
+    gpio_lines_free(encoder->lines);
+    encoder->lines = NULL;
+
+    return 0;
+}
+
+int gpio_encoder_fd(gpio_encoder_t *encoder) {
+    return encoder->lines ? gpio_lines_fd(encoder->lines) : -1;
+}
+
+int gpio_encoder_tostring(gpio_encoder_t *encoder, char *str, size_t len) {
+    gpio_encoder_stats_t stats;
+
+    gpio_encoder_get_stats(encoder, &stats);
+
+    return snprintf(str, len, "GPIO Encoder (line_a=%u, line_b=%u, fd=%d, position=%" PRId64 ", velocity=%.3f, transitions=%" PRIu64 ", errors=%" PRIu64 ", dropped=%" PRIu64 ")",
+                    encoder->line_a, encoder->line_b, gpio_encoder_fd(encoder), gpio_encoder_get_position(encoder),
+                    gpio_encoder_get_velocity(encoder), stats.transitions, stats.errors, stats.dropped);
+}
+
+int gpio_encoder_errno(gpio_encoder_t *encoder) {
+    return encoder->error.c_errno;
+}
+
+const char *gpio_encoder_errmsg(gpio_encoder_t *encoder) {
+    return encoder->error.errmsg;
+}
+
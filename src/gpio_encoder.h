@@ -0,0 +1,66 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_ENCODER_H
+#define _PERIPHERY_GPIO_ENCODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio.h"
+
+/* Configuration structure for gpio_encoder_open_advanced() */
+typedef struct gpio_encoder_config {
+    gpio_bias_t bias;
+    gpio_event_clock_t event_clock;
+    uint32_t debounce_us;           /* Debounce period, can be 0 to disable */
+    bool inverted;                  /* Reverse counting direction */
+    uint32_t velocity_window_us;    /* Velocity measurement window, can be 0 for default (10 ms) */
+    uint32_t event_buffer_size;     /* Kernel event buffer size, can be 0 for default */
+    const char *label;              /* Can be NULL for default consumer label */
+} gpio_encoder_config_t;
+
+/* Encoder statistics structure for gpio_encoder_get_stats() */
+typedef struct gpio_encoder_stats {
+    uint64_t transitions;   /* Valid state transitions */
+    uint64_t errors;        /* Illegal state transitions */
+    uint64_t dropped;       /* Events dropped by the kernel */
+} gpio_encoder_stats_t;
+
+typedef struct gpio_encoder_handle gpio_encoder_t;
+
+/* Primary Functions */
+gpio_encoder_t *gpio_encoder_new(void);
+int gpio_encoder_open(gpio_encoder_t *encoder, const char *path, unsigned int line_a, unsigned int line_b);
+int gpio_encoder_open_advanced(gpio_encoder_t *encoder, const char *path, unsigned int line_a, unsigned int line_b, const gpio_encoder_config_t *config);
+int gpio_encoder_update(gpio_encoder_t *encoder, int timeout_ms);
+int gpio_encoder_feed(gpio_encoder_t *encoder, const gpio_event_t *events, size_t count);
+int64_t gpio_encoder_get_position(gpio_encoder_t *encoder);
+double gpio_encoder_get_velocity(gpio_encoder_t *encoder);
+int gpio_encoder_get_stats(gpio_encoder_t *encoder, gpio_encoder_stats_t *stats);
+void gpio_encoder_set_position(gpio_encoder_t *encoder, int64_t position);
+int gpio_encoder_close(gpio_encoder_t *encoder);
+void gpio_encoder_free(gpio_encoder_t *encoder);
+
+/* Miscellaneous */
+int gpio_encoder_fd(gpio_encoder_t *encoder);
+int gpio_encoder_tostring(gpio_encoder_t *encoder, char *str, size_t len);
+
+/* Error Handling */
+int gpio_encoder_errno(gpio_encoder_t *encoder);
+const char *gpio_encoder_errmsg(gpio_encoder_t *encoder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,529 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "gpio_i2c.h"
+#include "gpio_internal.h"
+
+/* Line masks of the line request */
+#define GPIO_I2C_SCL    0x1
+#define GPIO_I2C_SDA    0x2
+
+/* Clock frequency and clock stretching timeout of gpio_i2c_open() */
+#define GPIO_I2C_FREQUENCY_DEFAULT          100000
+#define GPIO_I2C_STRETCH_TIMEOUT_US_DEFAULT 25000
+
+struct gpio_i2c_handle {
+    /* SCL and SDA share an open drain request, so both are sampled with a
+     * single ioctl */
+    gpio_lines_t *lines;
+    unsigned int scl;
+    unsigned int sda;
+    uint32_t frequency;
+    uint64_t stretch_timeout_ns;
+
+    /* direct MMIO access, if configured */
+    bool mmio;
+    struct gpio_mmio_line mmio_scl;
+    struct gpio_mmio_line mmio_sda;
+
+    /* transfer state */
+    uint64_t half_period_ns;
+    uint64_t last_edge;
+    bool sda_value;
+
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_i2c_error(gpio_i2c_t *i2c, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    i2c->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(i2c->error.errmsg, sizeof(i2c->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(i2c->error.errmsg+strlen(i2c->error.errmsg), sizeof(i2c->error.errmsg)-strlen(i2c->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static uint64_t _gpio_i2c_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/* Busy wait until half a clock period after the previous edge */
+static void _gpio_i2c_delay(gpio_i2c_t *i2c) {
+    uint64_t now;
+
+    if (i2c->half_period_ns == 0)
+        return;
+
+    while ((now = _gpio_i2c_now()) < i2c->last_edge + i2c->half_period_ns)
+        ;
+
+    i2c->last_edge = now;
+}
+
+static int _gpio_i2c_write(gpio_i2c_t *i2c, uint64_t mask, uint64_t bits) {
+    int ret;
+
+    if (i2c->mmio) {
+        if (mask & GPIO_I2C_SDA)
+            _gpio_mmio_line_set(&i2c->mmio_sda, bits & GPIO_I2C_SDA);
+        if (mask & GPIO_I2C_SCL)
+            _gpio_mmio_line_set(&i2c->mmio_scl, bits & GPIO_I2C_SCL);
+        return 0;
+    }
+
+    if ((ret = gpio_lines_write(i2c->lines, mask, bits)) < 0)
+        return _gpio_i2c_error(i2c, ret, gpio_lines_errno(i2c->lines), "Writing GPIO lines");
+
+    return 0;
+}
+
+static int _gpio_i2c_read(gpio_i2c_t *i2c, uint64_t *bits) {
+    int ret;
+
+    if (i2c->mmio) {
+        *bits = (_gpio_mmio_line_get(&i2c->mmio_scl) ? GPIO_I2C_SCL : 0) |
+                (_gpio_mmio_line_get(&i2c->mmio_sda) ? GPIO_I2C_SDA : 0);
+        return 0;
+    }
+
+    if ((ret = gpio_lines_read(i2c->lines, GPIO_I2C_SCL | GPIO_I2C_SDA, bits)) < 0)
+        return _gpio_i2c_error(i2c, ret, gpio_lines_errno(i2c->lines), "Reading GPIO lines");
+
+    return 0;
+}
+
+/* Drive SDA, skipping the write if SDA is unchanged */
+static int _gpio_i2c_sda(gpio_i2c_t *i2c, bool value) {
+    int ret;
+
+    if (value == i2c->sda_value)
+        return 0;
+
+    if ((ret = _gpio_i2c_write(i2c, GPIO_I2C_SDA, value ? GPIO_I2C_SDA : 0)) < 0)
+        return ret;
+
+    i2c->sda_value = value;
+
+    return 0;
+}
+
+static int _gpio_i2c_scl_low(gpio_i2c_t *i2c) {
+    return _gpio_i2c_write(i2c, GPIO_I2C_SCL, 0);
+}
+
+/* Release SCL and wait for slaves stretching the clock. If bits is not NULL,
+ * both lines are sampled once SCL is high, which doubles as the clock
+ * stretching check. */
+static int _gpio_i2c_scl_high(gpio_i2c_t *i2c, uint64_t *bits) {
+    uint64_t value, deadline = 0;
+    int ret;
+
+    if ((ret = _gpio_i2c_write(i2c, GPIO_I2C_SCL, GPIO_I2C_SCL)) < 0)
+        return ret;
+
+    if (i2c->stretch_timeout_ns == 0 && bits == NULL)
+        return 0;
+
+    while (true) {
+        if ((ret = _gpio_i2c_read(i2c, &value)) < 0)
+            return ret;
+
+        if ((value & GPIO_I2C_SCL) || i2c->stretch_timeout_ns == 0)
+            break;
+
+        /* Clock stretched, restart the high period once released */
+        if (deadline == 0)
+            deadline = _gpio_i2c_now() + i2c->stretch_timeout_ns;
+        else if (_gpio_i2c_now() > deadline)
+            return _gpio_i2c_error(i2c, GPIO_ERROR_IO, ETIMEDOUT, "Clock stretching timeout");
+
+        i2c->last_edge = _gpio_i2c_now();
+    }
+
+    if (bits)
+        *bits = value;
+
+    return 0;
+}
+
+static int _gpio_i2c_write_bit(gpio_i2c_t *i2c, bool bit) {
+    int ret;
+
+    if ((ret = _gpio_i2c_sda(i2c, bit)) < 0)
+        return ret;
+
+    _gpio_i2c_delay(i2c);
+
+    if ((ret = _gpio_i2c_scl_high(i2c, NULL)) < 0)
+        return ret;
+
+    _gpio_i2c_delay(i2c);
+
+    return _gpio_i2c_scl_low(i2c);
+}
+
+static int _gpio_i2c_read_bit(gpio_i2c_t *i2c, bool *bit) {
+    uint64_t bits;
+    int ret;
+
+    if ((ret = _gpio_i2c_sda(i2c, true)) < 0)
+        return ret;
+
+    _gpio_i2c_delay(i2c);
+
+    if ((ret = _gpio_i2c_scl_high(i2c, &bits)) < 0)
+        return ret;
+
+    *bit = (bits & GPIO_I2C_SDA) != 0;
+
+    _gpio_i2c_delay(i2c);
+
+    return _gpio_i2c_scl_low(i2c);
+}
+
+static int _gpio_i2c_write_byte(gpio_i2c_t *i2c, uint8_t byte, bool *ack) {
+    bool nak;
+    int ret;
+
+    for (int b = 7; b >= 0; b--) {
+        if ((ret = _gpio_i2c_write_bit(i2c, (byte >> b) & 0x1)) < 0)
+            return ret;
+    }
+
+    if ((ret = _gpio_i2c_read_bit(i2c, &nak)) < 0)
+        return ret;
+
+    *ack = !nak;
+
+    return 0;
+}
+
+static int _gpio_i2c_read_byte(gpio_i2c_t *i2c, uint8_t *byte) {
+    bool bit;
+    int ret;
+
+    *byte = 0;
+
+    for (unsigned int b = 0; b < 8; b++) {
+        if ((ret = _gpio_i2c_read_bit(i2c, &bit)) < 0)
+            return ret;
+
+        *byte = (uint8_t)((*byte << 1) | bit);
+    }
+
+    return 0;
+}
+
+/* Start or repeated start condition, leaving SCL low */
+static int _gpio_i2c_start(gpio_i2c_t *i2c, bool repeated) {
+    int ret;
+
+    if (repeated) {
+        if ((ret = _gpio_i2c_sda(i2c, true)) < 0)
+            return ret;
+
+        _gpio_i2c_delay(i2c);
+
+        if ((ret = _gpio_i2c_scl_high(i2c, NULL)) < 0)
+            return ret;
+
+        _gpio_i2c_delay(i2c);
+    }
+
+    if ((ret = _gpio_i2c_sda(i2c, false)) < 0)
+        return ret;
+
+    _gpio_i2c_delay(i2c);
+
+    return _gpio_i2c_scl_low(i2c);
+}
+
+/* Stop condition, leaving the bus idle */
+static int _gpio_i2c_stop(gpio_i2c_t *i2c) {
+    int ret;
+
+    if ((ret = _gpio_i2c_sda(i2c, false)) < 0)
+        return ret;
+
+    _gpio_i2c_delay(i2c);
+
+    if ((ret = _gpio_i2c_scl_high(i2c, NULL)) < 0)
+        return ret;
+
+    _gpio_i2c_delay(i2c);
+
+    if ((ret = _gpio_i2c_sda(i2c, true)) < 0)
+        return ret;
+
+    _gpio_i2c_delay(i2c);
+
+    return 0;
+}
+
+gpio_i2c_t *gpio_i2c_new(void) {
+    return calloc(1, sizeof(gpio_i2c_t));
+}
+
+void gpio_i2c_free(gpio_i2c_t *i2c) {
+    free(i2c);
+}
+
+int gpio_i2c_open(gpio_i2c_t *i2c, const char *path, unsigned int scl, unsigned int sda) {
+    gpio_i2c_config_t config = {
+        .frequency = GPIO_I2C_FREQUENCY_DEFAULT,
+        .stretch_timeout_us = GPIO_I2C_STRETCH_TIMEOUT_US_DEFAULT,
+        .bias = GPIO_BIAS_DEFAULT,
+        .mmio = NULL,
+        .label = NULL,
+    };
+
+    return gpio_i2c_open_advanced(i2c, path, scl, sda, &config);
+}
+
+int gpio_i2c_open_advanced(gpio_i2c_t *i2c, const char *path, unsigned int scl, unsigned int sda, const gpio_i2c_config_t *config) {
+    gpio_lines_t *lines;
+    struct gpio_mmio_line mmio_scl, mmio_sda;
+    unsigned int offsets[2] = {scl, sda};
+    int ret;
+
+    if (scl == sda)
+        return _gpio_i2c_error(i2c, GPIO_ERROR_ARG, 0, "Invalid lines (SCL and SDA must differ)");
+
+    /* Check MMIO registers before requesting the lines */
+    if (config->mmio) {
+        if (!_gpio_mmio_line_resolve(config->mmio, scl, &mmio_scl))
+            return _gpio_i2c_error(i2c, GPIO_ERROR_ARG, 0, "Invalid MMIO registers for line %u (out of bounds or misaligned)", scl);
+        else if (!_gpio_mmio_line_resolve(config->mmio, sda, &mmio_sda))
+            return _gpio_i2c_error(i2c, GPIO_ERROR_ARG, 0, "Invalid MMIO registers for line %u (out of bounds or misaligned)", sda);
+    }
+
+    gpio_config_t lines_config = {
+        .direction = GPIO_DIR_OUT_HIGH,
+        .edge = GPIO_EDGE_NONE,
+        .event_clock = GPIO_EVENT_CLOCK_MONOTONIC,
+        .debounce_us = 0,
+        .event_buffer_size = 0,
+        .bias = config->bias,
+        .drive = GPIO_DRIVE_OPEN_DRAIN,
+        .inverted = false,
+        .label = config->label,
+    };
+
+    if ((lines = gpio_lines_new()) == NULL)
+        return _gpio_i2c_error(i2c, GPIO_ERROR_OPEN, ENOMEM, "Allocating GPIO lines handle");
+
+    /* Request both lines released */
+    if ((ret = gpio_lines_open_advanced(lines, path, offsets, 2, &lines_config)) < 0) {
+        _gpio_i2c_error(i2c, ret, gpio_lines_errno(lines), "Opening GPIO lines: %s", gpio_lines_errmsg(lines));
+        gpio_lines_free(lines);
+        return ret;
+    }
+
+    memset(i2c, 0, sizeof(gpio_i2c_t));
+    i2c->lines = lines;
+    i2c->scl = scl;
+    i2c->sda = sda;
+    i2c->frequency = config->frequency;
+    i2c->stretch_timeout_ns = (uint64_t)config->stretch_timeout_us * 1000;
+    i2c->half_period_ns = config->frequency ? (500000000ULL + config->frequency - 1) / config->frequency : 0;
+    i2c->sda_value = true;
+
+    /* Lines are still claimed and configured open drain through the line
+     * request above, while values go through the registers */
+    if (config->mmio) {
+        i2c->mmio = true;
+        i2c->mmio_scl = mmio_scl;
+        i2c->mmio_sda = mmio_sda;
+    }
+
+    return 0;
+}
+
+static int _gpio_i2c_address(gpio_i2c_t *i2c, const struct i2c_msg *msg, bool repeated) {
+    bool ignore_nak = (msg->flags & I2C_M_IGNORE_NAK) != 0;
+    bool rd = ((msg->flags & I2C_M_RD) != 0) != ((msg->flags & I2C_M_REV_DIR_ADDR) != 0);
+    bool ack;
+    int ret;
+
+    if ((ret = _gpio_i2c_start(i2c, repeated)) < 0)
+        return ret;
+
+    if (msg->flags & I2C_M_TEN) {
+        /* 11110 A9 A8 W, A7..A0, and for reads, repeated start and 11110 A9
+         * A8 R */
+        uint8_t addr1 = (uint8_t)(0xf0 | ((msg->addr >> 7) & 0x6));
+
+        if ((ret = _gpio_i2c_write_byte(i2c, addr1, &ack)) < 0)
+            return ret;
+        if (!ack && !ignore_nak)
+            return _gpio_i2c_error(i2c, GPIO_ERROR_IO, ENXIO, "No acknowledge of address 0x%03x", msg->addr);
+
+        if ((ret = _gpio_i2c_write_byte(i2c, (uint8_t)(msg->addr & 0xff), &ack)) < 0)
+            return ret;
+        if (!ack && !ignore_nak)
+            return _gpio_i2c_error(i2c, GPIO_ERROR_IO, ENXIO, "No acknowledge of address 0x%03x", msg->addr);
+
+        if (rd) {
+            if ((ret = _gpio_i2c_start(i2c, true)) < 0)
+                return ret;
+
+            if ((ret = _gpio_i2c_write_byte(i2c, addr1 | 0x1, &ack)) < 0)
+                return ret;
+            if (!ack && !ignore_nak)
+                return _gpio_i2c_error(i2c, GPIO_ERROR_IO, ENXIO, "No acknowledge of address 0x%03x", msg->addr);
+        }
+    } else {
+        if ((ret = _gpio_i2c_write_byte(i2c, (uint8_t)((msg->addr << 1) | rd), &ack)) < 0)
+            return ret;
+        if (!ack && !ignore_nak)
+            return _gpio_i2c_error(i2c, GPIO_ERROR_IO, ENXIO, "No acknowledge of address 0x%02x", msg->addr);
+    }
+
+    return 0;
+}
+
+static int _gpio_i2c_transfer_msg(gpio_i2c_t *i2c, const struct i2c_msg *msg, size_t index) {
+    bool ack;
+    int ret;
+
+    for (size_t i = 0; i < msg->len; i++) {
+        if (msg->flags & I2C_M_RD) {
+            if ((ret = _gpio_i2c_read_byte(i2c, &msg->buf[i])) < 0)
+                return ret;
+
+            /* Acknowledge all but the last byte */
+            if (!(msg->flags & I2C_M_NO_RD_ACK)) {
+                if ((ret = _gpio_i2c_write_bit(i2c, i == (size_t)msg->len - 1)) < 0)
+                    return ret;
+            }
+        } else {
+            if ((ret = _gpio_i2c_write_byte(i2c, msg->buf[i], &ack)) < 0)
+                return ret;
+
+            if (!ack && !(msg->flags & I2C_M_IGNORE_NAK))
+                return _gpio_i2c_error(i2c, GPIO_ERROR_IO, EIO, "No acknowledge of byte %zu of message %zu", i, index);
+        }
+    }
+
+    return 0;
+}
+
+int gpio_i2c_transfer(gpio_i2c_t *i2c, struct i2c_msg *msgs, size_t count) {
+    bool started = false;
+    uint64_t bits;
+    int ret;
+
+    if (i2c->lines == NULL)
+        return _gpio_i2c_error(i2c, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: I2C not open");
+
+    for (size_t i = 0; i < count; i++) {
+        if (msgs[i].flags & I2C_M_RECV_LEN)
+            return _gpio_i2c_error(i2c, GPIO_ERROR_UNSUPPORTED, 0, "Unsupported message flag I2C_M_RECV_LEN");
+        else if (msgs[i].addr > ((msgs[i].flags & I2C_M_TEN) ? 0x3ff : 0x7f))
+            return _gpio_i2c_error(i2c, GPIO_ERROR_ARG, 0, "Invalid address 0x%x of message %zu", msgs[i].addr, i);
+    }
+
+    /* Check the bus is idle */
+    if ((ret = _gpio_i2c_read(i2c, &bits)) < 0)
+        return ret;
+    if (bits != (GPIO_I2C_SCL | GPIO_I2C_SDA))
+        return _gpio_i2c_error(i2c, GPIO_ERROR_IO, EBUSY, "Bus not idle (SCL %s, SDA %s)",
+                               (bits & GPIO_I2C_SCL) ? "high" : "low", (bits & GPIO_I2C_SDA) ? "high" : "low");
+
+    i2c->last_edge = _gpio_i2c_now();
+
+    for (size_t i = 0; i < count; i++) {
+        if (!started || !(msgs[i].flags & I2C_M_NOSTART)) {
+            if ((ret = _gpio_i2c_address(i2c, &msgs[i], started)) < 0)
+                goto fail;
+
+            started = true;
+        }
+
+        if ((ret = _gpio_i2c_transfer_msg(i2c, &msgs[i], i)) < 0)
+            goto fail;
+
+        if ((msgs[i].flags & I2C_M_STOP) && i < count - 1) {
+            if ((ret = _gpio_i2c_stop(i2c)) < 0)
+                return ret;
+
+            started = false;
+        }
+    }
+
+    return _gpio_i2c_stop(i2c);
+
+fail:
+    /* Release the bus after a missing acknowledge or a clock stretching
+     * timeout, keeping the original error */
+    if (i2c->error.c_errno == ENXIO || i2c->error.c_errno == EIO || i2c->error.c_errno == ETIMEDOUT) {
+        char errmsg[sizeof(i2c->error.errmsg)];
+        int c_errno = i2c->error.c_errno;
+
+        memcpy(errmsg, i2c->error.errmsg, sizeof(errmsg));
+        _gpio_i2c_stop(i2c);
+        memcpy(i2c->error.errmsg, errmsg, sizeof(errmsg));
+        i2c->error.c_errno = c_errno;
+    }
+
+    return ret;
+}
+
+int gpio_i2c_close(gpio_i2c_t *i2c) {
+    int ret;
+
+    if (i2c->lines == NULL)
+        return 0;
+
+    if ((ret = gpio_lines_close(i2c->lines)) < 0)
+        return _gpio_i2c_error(i2c, ret, gpio_lines_errno(i2c->lines), "Closing GPIO lines");
+
+    gpio_lines_free(i2c->lines);
+    i2c->lines = NULL;
+
+    return 0;
+}
+
+int gpio_i2c_tostring(gpio_i2c_t *i2c, char *str, size_t len) {
+    if (i2c->lines == NULL)
+        return snprintf(str, len, "GPIO I2C (closed)");
+
+    return snprintf(str, len, "GPIO I2C (scl=%u, sda=%u, frequency=%u, stretch_timeout_us=%u, mmio=%s)",
+                    i2c->scl, i2c->sda, i2c->frequency, (unsigned int)(i2c->stretch_timeout_ns / 1000),
+                    i2c->mmio ? "true" : "false");
+}
+
+int gpio_i2c_errno(gpio_i2c_t *i2c) {
+    return i2c->error.c_errno;
+}
+
+const char *gpio_i2c_errmsg(gpio_i2c_t *i2c) {
+    return i2c->error.errmsg;
+}
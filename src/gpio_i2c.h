@@ -0,0 +1,52 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_I2C_H
+#define _PERIPHERY_GPIO_I2C_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio.h"
+#include "i2c.h"
+
+/* Configuration structure for gpio_i2c_open_advanced() */
+typedef struct gpio_i2c_config {
+    uint32_t frequency;             /* Clock frequency in Hz, can be 0 for as fast as possible */
+    uint32_t stretch_timeout_us;    /* Clock stretching timeout, can be 0 to not check SCL */
+    gpio_bias_t bias;
+    const gpio_mmio_regs_t *mmio;   /* Direct MMIO registers, can be NULL to use the line request */
+    const char *label;              /* Can be NULL for default consumer label */
+} gpio_i2c_config_t;
+
+typedef struct gpio_i2c_handle gpio_i2c_t;
+
+/* Primary Functions */
+gpio_i2c_t *gpio_i2c_new(void);
+int gpio_i2c_open(gpio_i2c_t *i2c, const char *path, unsigned int scl, unsigned int sda);
+int gpio_i2c_open_advanced(gpio_i2c_t *i2c, const char *path, unsigned int scl, unsigned int sda, const gpio_i2c_config_t *config);
+int gpio_i2c_transfer(gpio_i2c_t *i2c, struct i2c_msg *msgs, size_t count);
+int gpio_i2c_close(gpio_i2c_t *i2c);
+void gpio_i2c_free(gpio_i2c_t *i2c);
+
+/* Miscellaneous */
+int gpio_i2c_tostring(gpio_i2c_t *i2c, char *str, size_t len);
+
+/* Error Handling */
+int gpio_i2c_errno(gpio_i2c_t *i2c);
+const char *gpio_i2c_errmsg(gpio_i2c_t *i2c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,88 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_INLINE_H
+#define _PERIPHERY_GPIO_INLINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "gpio.h"
+
+/* Static inline line accessors of a gpio_inline_t from gpio_get_inline().
+ * Each access is a single line request ioctl, without the library call, the
+ * backend lookup, or error message formatting. On failure, these return a
+ * negative GPIO error code and leave errno set. */
+
+static inline int gpio_inline_read(const gpio_inline_t *inl, bool *value) {
+#ifdef GPIO_V2_LINE_GET_VALUES_IOCTL
+    if (inl->abi == 2) {
+        struct gpio_v2_line_values line_values = {0, 1};
+
+        if (ioctl(inl->line_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &line_values) < 0)
+            return GPIO_ERROR_IO;
+
+        *value = line_values.bits & 0x1;
+
+        return 0;
+    }
+#else
+    if (inl->abi != 1)
+        return GPIO_ERROR_UNSUPPORTED;
+#endif
+
+    struct gpiohandle_data data = {{0}};
+
+    if (ioctl(inl->line_fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0)
+        return GPIO_ERROR_IO;
+
+    *value = data.values[0];
+
+    return 0;
+}
+
+static inline int gpio_inline_write(const gpio_inline_t *inl, bool value) {
+    if (!inl->output)
+        return GPIO_ERROR_INVALID_OPERATION;
+
+#ifdef GPIO_V2_LINE_SET_VALUES_IOCTL
+    if (inl->abi == 2) {
+        struct gpio_v2_line_values line_values = {0, 1};
+
+        line_values.bits = value & 0x1;
+
+        if (ioctl(inl->line_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &line_values) < 0)
+            return GPIO_ERROR_IO;
+
+        return 0;
+    }
+#else
+    if (inl->abi != 1)
+        return GPIO_ERROR_UNSUPPORTED;
+#endif
+
+    struct gpiohandle_data data = {{0}};
+
+    data.values[0] = value;
+
+    if (ioctl(inl->line_fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) < 0)
+        return GPIO_ERROR_IO;
+
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
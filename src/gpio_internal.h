@@ -8,8 +8,41 @@
 #define _PERIPHERY_GPIO_INTERNAL_H
 
 #include <stdarg.h>
+#include <string.h>
 
 #include "gpio.h"
+#include "mmio.h"
+
+#if PERIPHERY_GPIO_CDEV_ONLY && !PERIPHERY_GPIO_CDEV_SUPPORT
+#error "PERIPHERY_GPIO_CDEV_ONLY requires character device GPIO support"
+#endif
+
+/*********************************************************************************/
+/* Direct MMIO line access */
+/*********************************************************************************/
+
+struct gpio_mmio_line {
+    volatile uint32_t *level;
+    volatile uint32_t *set;     /* NULL for read-modify-write of data */
+    volatile uint32_t *clear;   /* NULL for read-modify-write of data */
+    volatile uint32_t *data;    /* NULL for set and clear registers */
+    uint32_t bit;
+};
+
+/*********************************************************************************/
+/* Line info event queue */
+/*********************************************************************************/
+
+#define GPIO_LINE_INFO_QUEUE_SIZE   16
+
+/* Line info events read from a chip fd, e.g. to refresh cached line info,
+ * that are pending for gpio_read_line_info_event(). The oldest event is
+ * dropped when the queue is full. */
+struct gpio_line_info_queue {
+    gpio_line_info_event_t events[GPIO_LINE_INFO_QUEUE_SIZE];
+    unsigned int head;
+    unsigned int count;
+};
 
 /*********************************************************************************/
 /* Operations table and handle structure */
@@ -19,6 +52,9 @@ struct gpio_ops {
     int (*read)(gpio_t *gpio, bool *value);
     int (*write)(gpio_t *gpio, bool value);
     int (*read_event)(gpio_t *gpio, gpio_edge_t *edge, uint64_t *timestamp);
+    int (*read_events)(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms);
+    int (*get_event_stats)(gpio_t *gpio, gpio_event_stats_t *stats);
+    int (*read_line_info_event)(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms);
     int (*poll)(gpio_t *gpio, int timeout_ms);
     int (*close)(gpio_t *gpio);
     int (*get_direction)(gpio_t *gpio, gpio_direction_t *direction);
@@ -35,6 +71,7 @@ struct gpio_ops {
     int (*set_bias)(gpio_t *gpio, gpio_bias_t bias);
     int (*set_drive)(gpio_t *gpio, gpio_drive_t drive);
     int (*set_inverted)(gpio_t *gpio, bool inverted);
+    int (*set_config)(gpio_t *gpio, const gpio_config_t *config);
     unsigned int (*line)(gpio_t *gpio);
     int (*fd)(gpio_t *gpio);
     int (*name)(gpio_t *gpio, char *str, size_t len);
@@ -53,22 +90,189 @@ struct gpio_handle {
             unsigned int line;
             int line_fd;
             int chip_fd;
+            gpio_chip_t *chip; /* NULL if chip fd is owned */
             gpio_direction_t direction;
             gpio_edge_t edge;
             gpio_event_clock_t event_clock;
             uint32_t debounce_us;
+            uint32_t event_buffer_size;
             gpio_bias_t bias;
             gpio_drive_t drive;
             bool inverted;
             char label[32];
+            /* event accounting, stats updated atomically */
+            uint32_t last_line_seqno;
+            gpio_event_stats_t event_stats;
+            /* cached line and chip info, line info cached only if the
+             * line is watched, and stale if line info events may have
+             * been dropped */
+            bool line_info_cached;
+            bool line_info_stale;
+            char line_name[32];
+            char line_consumer[32];
+            bool chip_info_cached;
+            char chip_name[32];
+            char chip_label[32];
+            /* line info events of an owned chip fd */
+            struct gpio_line_info_queue line_info_queue;
+            /* next GPIO watching a line of the shared chip */
+            gpio_t *chip_next;
         } cdev;
         struct {
             unsigned int line;
             int line_fd;
+            int direction_fd;   /* -1 if attribute is absent */
+            int edge_fd;        /* -1 if attribute is absent */
+            int active_low_fd;
             bool exported;
         } sysfs;
+        struct {
+            unsigned int line;
+            int event_fd;
+            gpio_direction_t direction;
+            gpio_edge_t edge;
+            gpio_event_clock_t event_clock;
+            uint32_t debounce_us;
+            gpio_bias_t bias;
+            gpio_drive_t drive;
+            bool inverted;
+            bool value;         /* logical line value, updated atomically */
+            char label[32];
+            struct gpio_event_ring *ring;
+            /* wakeup state, see gpio_mock.c */
+            bool armed;         /* set by consumer, cleared by producer */
+            bool armed_local;   /* consumer armed, or wakeup pending if armed was cleared */
+            /* producer state */
+            uint32_t seqno;
+            /* event accounting, updated atomically */
+            gpio_event_stats_t event_stats;
+        } mock;
     } u;
 
+    /* direct MMIO line access of the mmio backend, which shares the cdev
+     * state above for everything but reads and writes */
+    struct gpio_mmio_line mmio;
+
+    /* line fd generation, incremented by backends that replace the line fd
+     * on reconfiguration, so that event sets register the new fd */
+    unsigned int fd_generation;
+
+    /* low latency wait state */
+    struct {
+        uint32_t spin_us;
+        gpio_wait_stats_t stats;
+    } wait;
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+/* Backend operations tables. With PERIPHERY_GPIO_CDEV_ONLY, only the
+ * character device backend is built, and the cdev read and write are called
+ * directly. */
+#if PERIPHERY_GPIO_CDEV_SUPPORT
+extern const struct gpio_ops gpio_cdev_ops;
+int gpio_cdev_read(gpio_t *gpio, bool *value);
+int gpio_cdev_write(gpio_t *gpio, bool value);
+#endif
+#if !PERIPHERY_GPIO_CDEV_ONLY
+extern const struct gpio_ops gpio_sysfs_ops;
+#endif
+#if PERIPHERY_GPIO_CDEV_SUPPORT && !PERIPHERY_GPIO_CDEV_ONLY
+extern const struct gpio_ops gpio_mmio_ops;
+#endif
+#if !PERIPHERY_GPIO_CDEV_ONLY
+extern const struct gpio_ops gpio_mock_ops;
+#endif
+
+inline static bool _gpio_is_sysfs(gpio_t *gpio) {
+#if PERIPHERY_GPIO_CDEV_ONLY
+    (void)gpio;
+    return false;
+#else
+    return gpio->ops == &gpio_sysfs_ops;
+#endif
+}
+
+inline static bool _gpio_is_mmio(gpio_t *gpio) {
+#if PERIPHERY_GPIO_CDEV_SUPPORT && !PERIPHERY_GPIO_CDEV_ONLY
+    return gpio->ops == &gpio_mmio_ops;
+#else
+    (void)gpio;
+    return false;
+#endif
+}
+
+inline static bool _gpio_is_mock(gpio_t *gpio) {
+#if PERIPHERY_GPIO_CDEV_ONLY
+    (void)gpio;
+    return false;
+#else
+    return gpio->ops == &gpio_mock_ops;
+#endif
+}
+
+struct gpio_chip_handle {
+    int fd;
+    bool opened;
+    char path[64];
+    char name[32];
+    char label[32];
+    unsigned int num_lines;
+
+    /* GPIOs watching lines on the chip fd, and their line info events */
+    gpio_t *gpios;
+    struct gpio_line_info_queue line_info_queue;
+
+    /* reference counts. The chip and the GPIOs opened from it are not
+     * thread-safe, and should be opened, closed, and freed by one thread. */
+    unsigned int refcount;      /* handle and GPIOs, frees handle on zero */
+    unsigned int fd_refcount;   /* open chip and GPIOs, closes fd on zero */
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+struct gpio_lines_handle {
+    unsigned int lines[GPIO_LINES_MAX];
+    size_t count;
+    int line_fd;
+    int chip_fd;
+    gpio_direction_t direction;
+    gpio_edge_t edge;
+    gpio_event_clock_t event_clock;
+    uint32_t debounce_us;
+    gpio_bias_t bias;
+    gpio_drive_t drive;
+    bool inverted;
+    char label[32];
+    /* output values last written, for masked writes with the cdev v1 ABI,
+     * which sets all lines of a handle at once */
+    uint64_t values;
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+struct gpio_event_set_member {
+    gpio_t *gpio;
+    unsigned int fd_generation; /* line fd generation registered with epoll */
+};
+
+struct gpio_event_set_handle {
+    int epoll_fd;
+    struct gpio_event_set_member *members;
+    size_t count;
+
     /* error state */
     struct {
         int c_errno;
@@ -76,6 +280,122 @@ struct gpio_handle {
     } error;
 };
 
+/*********************************************************************************/
+/* GPIO chip reference counting */
+/*********************************************************************************/
+
+void _gpio_chip_ref(gpio_chip_t *chip);
+int _gpio_chip_unref(gpio_chip_t *chip);
+
+/*********************************************************************************/
+/* Multiple lines helpers */
+/*********************************************************************************/
+
+inline static uint64_t _gpio_lines_mask(size_t count) {
+    return (count >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1);
+}
+
+/*********************************************************************************/
+/* Direct MMIO line access helpers */
+/*********************************************************************************/
+
+/* Resolve the registers of a line, checking alignment and bounds once, so
+ * each access is a single volatile load or store. Returns false if the
+ * registers lie outside of the MMIO mapping, or are not 32-bit aligned in
+ * it, e.g. with a MMIO handle opened at an unaligned base. */
+inline static bool _gpio_mmio_line_resolve(const gpio_mmio_regs_t *regs, unsigned int line, struct gpio_mmio_line *mline) {
+    uintptr_t offsets[3] = {regs->level_offset, regs->rmw ? regs->data_offset : regs->set_offset, regs->rmw ? regs->data_offset : regs->clear_offset};
+    uintptr_t bank = (uintptr_t)(line / 32) * regs->bank_stride;
+    volatile uint8_t *ptr = mmio_ptr(regs->mmio);
+
+    if (line >= 32 && regs->bank_stride == 0)
+        return false;
+
+    for (unsigned int i = 0; i < 3; i++) {
+        if (((uintptr_t)ptr + offsets[i] + bank) % 4 != 0 || offsets[i] + bank + 4 > mmio_size(regs->mmio))
+            return false;
+    }
+
+    memset(mline, 0, sizeof(*mline));
+    mline->level = (volatile uint32_t *)(ptr + regs->level_offset + bank);
+    if (regs->rmw) {
+        mline->data = (volatile uint32_t *)(ptr + regs->data_offset + bank);
+    } else {
+        mline->set = (volatile uint32_t *)(ptr + regs->set_offset + bank);
+        mline->clear = (volatile uint32_t *)(ptr + regs->clear_offset + bank);
+    }
+    mline->bit = (uint32_t)1 << (line % 32);
+
+    return true;
+}
+
+inline static bool _gpio_mmio_line_get(const struct gpio_mmio_line *mline) {
+    return (*mline->level & mline->bit) != 0;
+}
+
+inline static void _gpio_mmio_line_set(const struct gpio_mmio_line *mline, bool value) {
+    if (mline->data)
+        *mline->data = value ? (*mline->data | mline->bit) : (*mline->data & ~mline->bit);
+    else if (value)
+        *mline->set = mline->bit;
+    else
+        *mline->clear = mline->bit;
+}
+
+/*********************************************************************************/
+/* Single-producer single-consumer rings */
+/*********************************************************************************/
+
+/* Define struct gpio_<name>_ring of type elements in member field, with
+ * _gpio_<name>_ring_push() and _gpio_<name>_ring_pop(). The capacity is a
+ * power of two, with mask set to capacity - 1. Producer and consumer indices
+ * are on separate cache lines. */
+#define GPIO_RING_DEFINE(name, type, field) \
+struct gpio_##name##_ring { \
+    type *field; \
+    size_t mask; \
+    size_t head __attribute__((aligned(64))); \
+    size_t tail __attribute__((aligned(64))); \
+}; \
+\
+/* Push up to count elements, returning the number of elements pushed. \
+ * Called only by the producer. */ \
+inline static size_t _gpio_##name##_ring_push(struct gpio_##name##_ring *ring, const type *elements, size_t count) { \
+    size_t head = ring->head; \
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE); \
+    size_t space = ring->mask + 1 - (head - tail); \
+\
+    if (count > space) \
+        count = space; \
+\
+    for (size_t i = 0; i < count; i++) \
+        ring->field[(head + i) & ring->mask] = elements[i]; \
+\
+    __atomic_store_n(&ring->head, head + count, __ATOMIC_RELEASE); \
+\
+    return count; \
+} \
+\
+/* Pop up to max elements, returning the number of elements popped. Called \
+ * only by the consumer. */ \
+inline static size_t _gpio_##name##_ring_pop(struct gpio_##name##_ring *ring, type *elements, size_t max) { \
+    size_t tail = ring->tail; \
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE); \
+    size_t count = head - tail; \
+\
+    if (count > max) \
+        count = max; \
+\
+    for (size_t i = 0; i < count; i++) \
+        elements[i] = ring->field[(tail + i) & ring->mask]; \
+\
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE); \
+\
+    return count; \
+}
+
+GPIO_RING_DEFINE(event, gpio_event_t, events)
+
 /*********************************************************************************/
 /* Common error formatting function */
 /*********************************************************************************/
@@ -99,5 +419,62 @@ inline static int _gpio_error(gpio_t *gpio, int code, int c_errno, const char *f
     return code;
 }
 
+inline static int _gpio_chip_error(gpio_chip_t *chip, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    chip->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(chip->error.errmsg, sizeof(chip->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(chip->error.errmsg+strlen(chip->error.errmsg), sizeof(chip->error.errmsg)-strlen(chip->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+inline static int _gpio_lines_error(gpio_lines_t *lines, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    lines->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(lines->error.errmsg, sizeof(lines->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(lines->error.errmsg+strlen(lines->error.errmsg), sizeof(lines->error.errmsg)-strlen(lines->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+inline static int _gpio_event_set_error(gpio_event_set_t *set, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    set->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(set->error.errmsg, sizeof(set->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(set->error.errmsg+strlen(set->error.errmsg), sizeof(set->error.errmsg)-strlen(set->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
 #endif
 
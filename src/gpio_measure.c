@@ -0,0 +1,237 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "gpio_measure.h"
+
+/* Maximum number of events read by a single gpio_measure_update() */
+#define GPIO_MEASURE_EVENTS_BATCH   64
+
+struct gpio_measure_handle {
+    gpio_t *gpio;
+    bool period_on_falling;
+
+    /* pulse width histogram */
+    uint64_t histogram_bin_ns;
+    unsigned int histogram_bins;
+    uint64_t histogram[GPIO_MEASURE_HISTOGRAM_MAX];
+
+    /* edge state */
+    gpio_edge_t last_edge;
+    uint64_t last_timestamp;
+    uint32_t last_line_seqno;
+    bool have_rising;
+    uint64_t last_rising;
+    bool have_falling;
+    uint64_t last_falling;
+
+    gpio_measure_result_t result;
+
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_measure_error(gpio_measure_t *measure, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    measure->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(measure->error.errmsg, sizeof(measure->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(measure->error.errmsg+strlen(measure->error.errmsg), sizeof(measure->error.errmsg)-strlen(measure->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static void _gpio_measure_stats_add(gpio_measure_stats_t *stats, uint64_t interval_ns) {
+    stats->count++;
+    stats->last_ns = interval_ns;
+
+    if (stats->count == 1 || interval_ns < stats->min_ns)
+        stats->min_ns = interval_ns;
+    if (interval_ns > stats->max_ns)
+        stats->max_ns = interval_ns;
+
+    /* Incremental mean */
+    stats->mean_ns += ((double)interval_ns - stats->mean_ns) / stats->count;
+}
+
+static void _gpio_measure_edge(gpio_measure_t *measure, const gpio_event_t *event) {
+    uint64_t timestamp = event->timestamp;
+
+    if (event->edge != GPIO_EDGE_RISING && event->edge != GPIO_EDGE_FALLING)
+        return;
+
+    measure->result.edges++;
+
+    /* Restart interval measurement across dropped edges, detected from line
+     * sequence number gaps, and across timestamps going backwards, e.g. on a
+     * realtime clock step */
+    if (measure->last_edge != GPIO_EDGE_NONE &&
+            ((event->line_seqno && measure->last_line_seqno && event->line_seqno != measure->last_line_seqno + 1) ||
+             timestamp < measure->last_timestamp)) {
+        measure->result.discontinuities++;
+        measure->last_edge = GPIO_EDGE_NONE;
+        measure->have_rising = false;
+        measure->have_falling = false;
+    }
+
+    if (event->edge == GPIO_EDGE_RISING) {
+        if (measure->have_rising && !measure->period_on_falling)
+            _gpio_measure_stats_add(&measure->result.period, timestamp - measure->last_rising);
+        if (measure->have_falling && measure->last_edge == GPIO_EDGE_FALLING)
+            _gpio_measure_stats_add(&measure->result.low, timestamp - measure->last_falling);
+
+        measure->have_rising = true;
+        measure->last_rising = timestamp;
+    } else {
+        if (measure->have_falling && measure->period_on_falling)
+            _gpio_measure_stats_add(&measure->result.period, timestamp - measure->last_falling);
+        if (measure->have_rising && measure->last_edge == GPIO_EDGE_RISING) {
+            uint64_t width_ns = timestamp - measure->last_rising;
+
+            _gpio_measure_stats_add(&measure->result.high, width_ns);
+
+            if (measure->histogram_bins) {
+                uint64_t bin = width_ns / measure->histogram_bin_ns;
+                measure->histogram[(bin < measure->histogram_bins) ? bin : measure->histogram_bins - 1]++;
+            }
+        }
+
+        measure->have_falling = true;
+        measure->last_falling = timestamp;
+    }
+
+    measure->last_edge = event->edge;
+    measure->last_timestamp = timestamp;
+    measure->last_line_seqno = event->line_seqno;
+}
+
+gpio_measure_t *gpio_measure_new(void) {
+    gpio_measure_t *measure = calloc(1, sizeof(gpio_measure_t));
+    if (measure == NULL)
+        return NULL;
+
+    return measure;
+}
+
+void gpio_measure_free(gpio_measure_t *measure) {
+    free(measure);
+}
+
+int gpio_measure_open(gpio_measure_t *measure, gpio_t *gpio, const gpio_measure_config_t *config) {
+    gpio_direction_t direction;
+    gpio_edge_t edge = GPIO_EDGE_BOTH;
+
+    if (config && config->histogram_bin_ns && (config->histogram_bins == 0 || config->histogram_bins > GPIO_MEASURE_HISTOGRAM_MAX))
+        return _gpio_measure_error(measure, GPIO_ERROR_ARG, 0, "Invalid histogram bins (can be 1 to %d)", GPIO_MEASURE_HISTOGRAM_MAX);
+
+    /* GPIO is optional, for measuring events fed by the caller */
+    if (gpio) {
+        if (gpio_get_direction(gpio, &direction) < 0 || gpio_get_edge(gpio, &edge) < 0)
+            return _gpio_measure_error(measure, GPIO_ERROR_QUERY, gpio_errno(gpio), "Querying GPIO configuration");
+
+        if (direction != GPIO_DIR_IN || edge == GPIO_EDGE_NONE)
+            return _gpio_measure_error(measure, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO must be an input with an edge configured");
+    }
+
+    memset(measure, 0, sizeof(gpio_measure_t));
+    measure->gpio = gpio;
+    measure->period_on_falling = (edge == GPIO_EDGE_FALLING);
+
+    if (config && config->histogram_bin_ns) {
+        measure->histogram_bin_ns = config->histogram_bin_ns;
+        measure->histogram_bins = config->histogram_bins;
+    }
+
+    return 0;
+}
+
+int gpio_measure_update(gpio_measure_t *measure, int timeout_ms) {
+    gpio_event_t events[GPIO_MEASURE_EVENTS_BATCH];
+    int ret;
+
+    if (measure->gpio == NULL)
+        return _gpio_measure_error(measure, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: no GPIO to read events from");
+
+    if ((ret = gpio_read_events(measure->gpio, events, GPIO_MEASURE_EVENTS_BATCH, timeout_ms)) < 0)
+        return _gpio_measure_error(measure, ret, gpio_errno(measure->gpio), "Reading GPIO events");
+
+    return gpio_measure_feed(measure, events, ret);
+}
+
+int gpio_measure_feed(gpio_measure_t *measure, const gpio_event_t *events, size_t count) {
+    gpio_measure_result_t *result = &measure->result;
+
+    for (size_t i = 0; i < count; i++)
+        _gpio_measure_edge(measure, &events[i]);
+
+    /* Update derived results, so queries are a copy */
+    result->frequency_hz = (result->period.count && result->period.mean_ns > 0) ? 1e9 / result->period.mean_ns : 0.0;
+    result->duty_cycle = (result->high.count && result->low.count) ?
+                            result->high.mean_ns / (result->high.mean_ns + result->low.mean_ns) : 0.0;
+
+    return count;
+}
+
+int gpio_measure_get_result(gpio_measure_t *measure, gpio_measure_result_t *result) {
+    *result = measure->result;
+    return 0;
+}
+
+int gpio_measure_get_histogram(gpio_measure_t *measure, uint64_t *bins, size_t len) {
+    if (len > measure->histogram_bins)
+        len = measure->histogram_bins;
+
+    memcpy(bins, measure->histogram, len * sizeof(uint64_t));
+
+    return len;
+}
+
+void gpio_measure_reset(gpio_measure_t *measure) {
+    memset(measure->histogram, 0, sizeof(measure->histogram));
+    memset(&measure->result, 0, sizeof(measure->result));
+    measure->last_edge = GPIO_EDGE_NONE;
+    measure->last_timestamp = 0;
+    measure->last_line_seqno = 0;
+    measure->have_rising = false;
+    measure->have_falling = false;
+}
+
+int gpio_measure_close(gpio_measure_t *measure) {
+    measure->gpio = NULL;
+    return 0;
+}
+
+int gpio_measure_tostring(gpio_measure_t *measure, char *str, size_t len) {
+    const gpio_measure_result_t *result = &measure->result;
+
+    return snprintf(str, len, "GPIO Measure (gpio_line=%d, edges=%" PRIu64 ", period_mean_ns=%.0f, high_mean_ns=%.0f, low_mean_ns=%.0f, frequency_hz=%.3f, duty_cycle=%.3f)",
+                    measure->gpio ? (int)gpio_line(measure->gpio) : -1, result->edges, result->period.mean_ns,
+                    result->high.mean_ns, result->low.mean_ns, result->frequency_hz, result->duty_cycle);
+}
+
+int gpio_measure_errno(gpio_measure_t *measure) {
+    return measure->error.c_errno;
+}
+
+const char *gpio_measure_errmsg(gpio_measure_t *measure) {
+    return measure->error.errmsg;
+}
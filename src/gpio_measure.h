@@ -0,0 +1,74 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_MEASURE_H
+#define _PERIPHERY_GPIO_MEASURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio.h"
+
+/* Maximum number of pulse width histogram bins */
+#define GPIO_MEASURE_HISTOGRAM_MAX  64
+
+/* Configuration structure for gpio_measure_open() */
+typedef struct gpio_measure_config {
+    uint64_t histogram_bin_ns;      /* Width of pulse width histogram bins, can be 0 to disable histogram */
+    unsigned int histogram_bins;    /* Number of pulse width histogram bins */
+} gpio_measure_config_t;
+
+/* Interval statistics structure */
+typedef struct gpio_measure_stats {
+    uint64_t count;         /* Number of intervals */
+    uint64_t last_ns;       /* Last interval */
+    uint64_t min_ns;        /* Minimum interval */
+    uint64_t max_ns;        /* Maximum interval */
+    double mean_ns;         /* Mean interval */
+} gpio_measure_stats_t;
+
+/* Measurement result structure for gpio_measure_get_result() */
+typedef struct gpio_measure_result {
+    uint64_t edges;                 /* Edges processed */
+    uint64_t discontinuities;       /* Dropped or out of order edges */
+    gpio_measure_stats_t period;    /* Period */
+    gpio_measure_stats_t high;      /* High pulse width */
+    gpio_measure_stats_t low;       /* Low pulse width */
+    double frequency_hz;            /* Frequency from mean period */
+    double duty_cycle;              /* Duty cycle from mean pulse widths, 0.0 to 1.0 */
+} gpio_measure_result_t;
+
+typedef struct gpio_measure_handle gpio_measure_t;
+
+/* Primary Functions */
+gpio_measure_t *gpio_measure_new(void);
+int gpio_measure_open(gpio_measure_t *measure, gpio_t *gpio, const gpio_measure_config_t *config);
+int gpio_measure_update(gpio_measure_t *measure, int timeout_ms);
+int gpio_measure_feed(gpio_measure_t *measure, const gpio_event_t *events, size_t count);
+int gpio_measure_get_result(gpio_measure_t *measure, gpio_measure_result_t *result);
+int gpio_measure_get_histogram(gpio_measure_t *measure, uint64_t *bins, size_t len);
+void gpio_measure_reset(gpio_measure_t *measure);
+int gpio_measure_close(gpio_measure_t *measure);
+void gpio_measure_free(gpio_measure_t *measure);
+
+/* Miscellaneous */
+int gpio_measure_tostring(gpio_measure_t *measure, char *str, size_t len);
+
+/* Error Handling */
+int gpio_measure_errno(gpio_measure_t *measure);
+const char *gpio_measure_errmsg(gpio_measure_t *measure);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
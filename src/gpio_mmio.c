@@ -0,0 +1,269 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "gpio.h"
+#include "gpio_internal.h"
+
+/*********************************************************************************/
+/* Direct MMIO implementation */
+/*********************************************************************************/
+
+/* The mmio backend claims the line through the character device, and shares
+ * its state and operations for everything but reads and writes, which access
+ * the GPIO controller registers directly. */
+
+#if PERIPHERY_GPIO_CDEV_SUPPORT && !PERIPHERY_GPIO_CDEV_ONLY
+
+static int gpio_mmio_read(gpio_t *gpio, bool *value) {
+    *value = _gpio_mmio_line_get(&gpio->mmio) ^ gpio->u.cdev.inverted;
+
+    return 0;
+}
+
+static int gpio_mmio_write(gpio_t *gpio, bool value) {
+    if (gpio->u.cdev.direction != GPIO_DIR_OUT)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot write to input GPIO");
+
+    _gpio_mmio_line_set(&gpio->mmio, value ^ gpio->u.cdev.inverted);
+
+    return 0;
+}
+
+/* Everything else is handled by the cdev backend */
+
+static int gpio_mmio_read_event(gpio_t *gpio, gpio_edge_t *edge, uint64_t *timestamp) {
+    return gpio_cdev_ops.read_event(gpio, edge, timestamp);
+}
+
+static int gpio_mmio_read_events(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms) {
+    return gpio_cdev_ops.read_events(gpio, events, max, timeout_ms);
+}
+
+static int gpio_mmio_get_event_stats(gpio_t *gpio, gpio_event_stats_t *stats) {
+    return gpio_cdev_ops.get_event_stats(gpio, stats);
+}
+
+static int gpio_mmio_read_line_info_event(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms) {
+    return gpio_cdev_ops.read_line_info_event(gpio, event, timeout_ms);
+}
+
+static int gpio_mmio_poll(gpio_t *gpio, int timeout_ms) {
+    return gpio_cdev_ops.poll(gpio, timeout_ms);
+}
+
+static int gpio_mmio_get_direction(gpio_t *gpio, gpio_direction_t *direction) {
+    return gpio_cdev_ops.get_direction(gpio, direction);
+}
+
+static int gpio_mmio_get_edge(gpio_t *gpio, gpio_edge_t *edge) {
+    return gpio_cdev_ops.get_edge(gpio, edge);
+}
+
+static int gpio_mmio_get_event_clock(gpio_t *gpio, gpio_event_clock_t *event_clock) {
+    return gpio_cdev_ops.get_event_clock(gpio, event_clock);
+}
+
+static int gpio_mmio_get_debounce_us(gpio_t *gpio, uint32_t *debounce_us) {
+    return gpio_cdev_ops.get_debounce_us(gpio, debounce_us);
+}
+
+static int gpio_mmio_get_bias(gpio_t *gpio, gpio_bias_t *bias) {
+    return gpio_cdev_ops.get_bias(gpio, bias);
+}
+
+static int gpio_mmio_get_drive(gpio_t *gpio, gpio_drive_t *drive) {
+    return gpio_cdev_ops.get_drive(gpio, drive);
+}
+
+static int gpio_mmio_get_inverted(gpio_t *gpio, bool *inverted) {
+    return gpio_cdev_ops.get_inverted(gpio, inverted);
+}
+
+static int gpio_mmio_set_direction(gpio_t *gpio, gpio_direction_t direction) {
+    return gpio_cdev_ops.set_direction(gpio, direction);
+}
+
+static int gpio_mmio_set_edge(gpio_t *gpio, gpio_edge_t edge) {
+    return gpio_cdev_ops.set_edge(gpio, edge);
+}
+
+static int gpio_mmio_set_event_clock(gpio_t *gpio, gpio_event_clock_t event_clock) {
+    return gpio_cdev_ops.set_event_clock(gpio, event_clock);
+}
+
+static int gpio_mmio_set_debounce_us(gpio_t *gpio, uint32_t debounce_us) {
+    return gpio_cdev_ops.set_debounce_us(gpio, debounce_us);
+}
+
+static int gpio_mmio_set_bias(gpio_t *gpio, gpio_bias_t bias) {
+    return gpio_cdev_ops.set_bias(gpio, bias);
+}
+
+static int gpio_mmio_set_drive(gpio_t *gpio, gpio_drive_t drive) {
+    return gpio_cdev_ops.set_drive(gpio, drive);
+}
+
+static int gpio_mmio_set_inverted(gpio_t *gpio, bool inverted) {
+    return gpio_cdev_ops.set_inverted(gpio, inverted);
+}
+
+static int gpio_mmio_set_config(gpio_t *gpio, const gpio_config_t *config) {
+    return gpio_cdev_ops.set_config(gpio, config);
+}
+
+static unsigned int gpio_mmio_line(gpio_t *gpio) {
+    return gpio_cdev_ops.line(gpio);
+}
+
+static int gpio_mmio_fd(gpio_t *gpio) {
+    return gpio_cdev_ops.fd(gpio);
+}
+
+static int gpio_mmio_name(gpio_t *gpio, char *str, size_t len) {
+    return gpio_cdev_ops.name(gpio, str, len);
+}
+
+static int gpio_mmio_label(gpio_t *gpio, char *str, size_t len) {
+    return gpio_cdev_ops.label(gpio, str, len);
+}
+
+static int gpio_mmio_chip_fd(gpio_t *gpio) {
+    return gpio_cdev_ops.chip_fd(gpio);
+}
+
+static int gpio_mmio_chip_name(gpio_t *gpio, char *str, size_t len) {
+    return gpio_cdev_ops.chip_name(gpio, str, len);
+}
+
+static int gpio_mmio_chip_label(gpio_t *gpio, char *str, size_t len) {
+    return gpio_cdev_ops.chip_label(gpio, str, len);
+}
+
+static int gpio_mmio_close(gpio_t *gpio) {
+    int ret;
+
+    if ((ret = gpio_cdev_ops.close(gpio)) < 0)
+        return ret;
+
+    /* Fall back to the cdev backend, so a closed handle never touches the
+     * registers */
+    gpio->ops = &gpio_cdev_ops;
+    memset(&gpio->mmio, 0, sizeof(gpio->mmio));
+
+    return 0;
+}
+
+static int gpio_mmio_tostring(gpio_t *gpio, char *str, size_t len) {
+    char buf[512];
+    char *type;
+
+    gpio_cdev_ops.tostring(gpio, buf, sizeof(buf));
+
+    /* Replace the backend type of the cdev description */
+    if ((type = strstr(buf, "type=cdev)")) != NULL)
+        *type = '\0';
+
+    return snprintf(str, len, "%slevel=%p, bit=0x%08" PRIx32 ", rmw=%s, type=mmio)",
+                    buf, (void *)gpio->mmio.level, gpio->mmio.bit, gpio->mmio.data ? "true" : "false");
+}
+
+const struct gpio_ops gpio_mmio_ops = {
+    .read = gpio_mmio_read,
+    .write = gpio_mmio_write,
+    .read_event = gpio_mmio_read_event,
+    .read_events = gpio_mmio_read_events,
+    .get_event_stats = gpio_mmio_get_event_stats,
+    .read_line_info_event = gpio_mmio_read_line_info_event,
+    .poll = gpio_mmio_poll,
+    .close = gpio_mmio_close,
+    .get_direction = gpio_mmio_get_direction,
+    .get_edge = gpio_mmio_get_edge,
+    .get_event_clock = gpio_mmio_get_event_clock,
+    .get_debounce_us = gpio_mmio_get_debounce_us,
+    .get_bias = gpio_mmio_get_bias,
+    .get_drive = gpio_mmio_get_drive,
+    .get_inverted = gpio_mmio_get_inverted,
+    .set_direction = gpio_mmio_set_direction,
+    .set_edge = gpio_mmio_set_edge,
+    .set_event_clock = gpio_mmio_set_event_clock,
+    .set_debounce_us = gpio_mmio_set_debounce_us,
+    .set_bias = gpio_mmio_set_bias,
+    .set_drive = gpio_mmio_set_drive,
+    .set_inverted = gpio_mmio_set_inverted,
+    .set_config = gpio_mmio_set_config,
+    .line = gpio_mmio_line,
+    .fd = gpio_mmio_fd,
+    .name = gpio_mmio_name,
+    .label = gpio_mmio_label,
+    .chip_fd = gpio_mmio_chip_fd,
+    .chip_name = gpio_mmio_chip_name,
+    .chip_label = gpio_mmio_chip_label,
+    .tostring = gpio_mmio_tostring,
+};
+
+int gpio_open_mmio_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config, const gpio_mmio_regs_t *regs) {
+    struct gpio_mmio_line mline;
+    int ret;
+
+    /* Validate registers before claiming the line */
+    if (regs == NULL || regs->mmio == NULL)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid MMIO registers (MMIO handle is NULL)");
+    else if (!_gpio_mmio_line_resolve(regs, line, &mline))
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid MMIO registers (line %u registers out of bounds or misaligned)", line);
+
+    /* Claim line through the character device */
+    if ((ret = gpio_open_advanced(gpio, path, line, config)) < 0)
+        return ret;
+
+    gpio->ops = &gpio_mmio_ops;
+    gpio->mmio = mline;
+
+    return 0;
+}
+
+int gpio_open_mmio(gpio_t *gpio, const char *path, unsigned int line, gpio_direction_t direction, const gpio_mmio_regs_t *regs) {
+    gpio_config_t config = {
+        .direction = direction,
+        .edge = GPIO_EDGE_NONE,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+
+    return gpio_open_mmio_advanced(gpio, path, line, &config, regs);
+}
+
+#else
+
+#if PERIPHERY_GPIO_CDEV_ONLY
+#define GPIO_MMIO_UNSUPPORTED   "c-periphery library built with character device GPIO backend only."
+#else
+#define GPIO_MMIO_UNSUPPORTED   "c-periphery library built without character device GPIO support."
+#endif
+
+int gpio_open_mmio(gpio_t *gpio, const char *path, unsigned int line, gpio_direction_t direction, const gpio_mmio_regs_t *regs) {
+    (void)path;
+    (void)line;
+    (void)direction;
+    (void)regs;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, GPIO_MMIO_UNSUPPORTED);
+}
+
+int gpio_open_mmio_advanced(gpio_t *gpio, const char *path, unsigned int line, const gpio_config_t *config, const gpio_mmio_regs_t *regs) {
+    (void)path;
+    (void)line;
+    (void)config;
+    (void)regs;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, GPIO_MMIO_UNSUPPORTED);
+}
+
+#endif
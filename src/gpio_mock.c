@@ -0,0 +1,717 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+
+#include "gpio.h"
+#include "gpio_internal.h"
+
+/*********************************************************************************/
+/* Mock implementation */
+/*********************************************************************************/
+
+/* The mock backend keeps the line value and an event queue in memory, so the
+ * library overhead above the kernel can be profiled, and event consumers
+ * load tested, without hardware or a kernel GPIO simulator. Events are
+ * injected by one producer thread into a single-producer single-consumer
+ * ring, and read by one consumer thread.
+ *
+ * The eventfd returned by gpio_fd() is readable when events are queued, so
+ * the mock works with gpio_poll(), event sets, the background reader and the
+ * dispatcher. To keep injection free of syscalls while the consumer keeps
+ * up, the consumer arms a wakeup when it finds the ring empty, and only the
+ * first push after that writes the eventfd. The consumer consumes the wakeup
+ * when it finds the ring empty again, so the eventfd is never left readable
+ * with an empty ring. */
+
+#if !PERIPHERY_GPIO_CDEV_ONLY
+
+/* Default and maximum event buffer size */
+#define GPIO_MOCK_EVENT_BUFFER_DEFAULT  16
+#define GPIO_MOCK_EVENT_BUFFER_MAX      ((size_t)1 << 24)
+
+static const char *_gpio_mock_check_config(const gpio_config_t *config) {
+    if (config->direction != GPIO_DIR_IN && config->direction != GPIO_DIR_OUT && config->direction != GPIO_DIR_OUT_LOW && config->direction != GPIO_DIR_OUT_HIGH)
+        return "Invalid GPIO direction (can be in, out, low, high)";
+
+    if (config->edge != GPIO_EDGE_NONE && config->edge != GPIO_EDGE_RISING && config->edge != GPIO_EDGE_FALLING && config->edge != GPIO_EDGE_BOTH)
+        return "Invalid GPIO interrupt edge (can be none, rising, falling, both)";
+
+    if (config->event_clock != GPIO_EVENT_CLOCK_REALTIME && config->event_clock != GPIO_EVENT_CLOCK_MONOTONIC && config->event_clock != GPIO_EVENT_CLOCK_HTE)
+        return "Invalid GPIO event clock (can be realtime, monotonic, hte)";
+
+    if (config->direction != GPIO_DIR_IN && config->edge != GPIO_EDGE_NONE)
+        return "Invalid GPIO edge for output GPIO";
+
+    if (config->direction != GPIO_DIR_IN && config->debounce_us != 0)
+        return "Invalid GPIO debounce for output GPIO";
+
+    if (config->bias != GPIO_BIAS_DEFAULT && config->bias != GPIO_BIAS_PULL_UP && config->bias != GPIO_BIAS_PULL_DOWN && config->bias != GPIO_BIAS_DISABLE)
+        return "Invalid GPIO line bias (can be default, pull_up, pull_down, disable)";
+
+    if (config->drive != GPIO_DRIVE_DEFAULT && config->drive != GPIO_DRIVE_OPEN_DRAIN && config->drive != GPIO_DRIVE_OPEN_SOURCE)
+        return "Invalid GPIO line drive (can be default, open_drain, open_source)";
+
+    if (config->direction == GPIO_DIR_IN && config->drive != GPIO_DRIVE_DEFAULT)
+        return "Invalid GPIO line drive for input GPIO";
+
+    if (config->event_buffer_size > GPIO_MOCK_EVENT_BUFFER_MAX)
+        return "Invalid GPIO event buffer size (can be 0 to 16777216)";
+
+    return NULL;
+}
+
+static void _gpio_mock_configure(gpio_t *gpio, const gpio_config_t *config) {
+    /* Outputs are initialized when switched to output, or explicitly */
+    if ((config->direction == GPIO_DIR_OUT && gpio->u.mock.direction != GPIO_DIR_OUT) || config->direction == GPIO_DIR_OUT_LOW)
+        __atomic_store_n(&gpio->u.mock.value, false, __ATOMIC_RELAXED);
+    else if (config->direction == GPIO_DIR_OUT_HIGH)
+        __atomic_store_n(&gpio->u.mock.value, true, __ATOMIC_RELAXED);
+
+    gpio->u.mock.direction = (config->direction == GPIO_DIR_IN) ? GPIO_DIR_IN : GPIO_DIR_OUT;
+    gpio->u.mock.edge = config->edge;
+    gpio->u.mock.event_clock = config->event_clock;
+    gpio->u.mock.debounce_us = config->debounce_us;
+    gpio->u.mock.bias = config->bias;
+    gpio->u.mock.drive = config->drive;
+    gpio->u.mock.inverted = config->inverted;
+}
+
+static uint64_t _gpio_mock_now(gpio_event_clock_t event_clock) {
+    struct timespec ts;
+
+    /* HTE timestamps are taken from the monotonic clock */
+    clock_gettime((event_clock == GPIO_EVENT_CLOCK_REALTIME) ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool _gpio_mock_ring_empty(struct gpio_event_ring *ring) {
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail;
+}
+
+/* Signal the eventfd on behalf of the consumer, leaving a wakeup pending */
+static int _gpio_mock_signal(gpio_t *gpio) {
+    uint64_t token = 1;
+
+    while (write(gpio->u.mock.event_fd, &token, sizeof(token)) < 0) {
+        if (errno != EINTR)
+            return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Signaling mock GPIO eventfd");
+    }
+
+    gpio->u.mock.armed_local = true;
+
+    return 1;
+}
+
+/* Settle the consumer wakeup state after popping events. Returns 1 if events
+ * are queued and the eventfd is (or is about to be) readable, 0 if the ring
+ * is empty and a wakeup is armed for the next push. Called only by the
+ * consumer. */
+static int _gpio_mock_settle(gpio_t *gpio) {
+    struct gpio_event_ring *ring = gpio->u.mock.ring;
+    uint64_t token;
+
+    while (gpio->u.mock.armed_local) {
+        /* Still armed, so no push has consumed the wakeup yet. A push racing
+         * with this check sees the wakeup armed and signals. */
+        if (__atomic_load_n(&gpio->u.mock.armed, __ATOMIC_ACQUIRE))
+            return _gpio_mock_ring_empty(ring) ? 0 : 1;
+
+        /* Wakeup pending, keep the eventfd readable while events are queued */
+        if (!_gpio_mock_ring_empty(ring))
+            return 1;
+
+        /* Consume the wakeup, which the producer has signaled or is about
+         * to signal */
+        while (read(gpio->u.mock.event_fd, &token, sizeof(token)) < 0) {
+            if (errno != EINTR)
+                return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Clearing mock GPIO eventfd");
+        }
+
+        gpio->u.mock.armed_local = false;
+    }
+
+    if (!_gpio_mock_ring_empty(ring))
+        return _gpio_mock_signal(gpio);
+
+    /* Arm the wakeup, then check for a push that missed it */
+    __atomic_store_n(&gpio->u.mock.armed, true, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    gpio->u.mock.armed_local = true;
+
+    if (_gpio_mock_ring_empty(ring))
+        return 0;
+
+    /* Disarm, or leave the wakeup to the push that consumed it */
+    if (__atomic_exchange_n(&gpio->u.mock.armed, false, __ATOMIC_ACQ_REL)) {
+        gpio->u.mock.armed_local = false;
+        return _gpio_mock_signal(gpio);
+    }
+
+    return 1;
+}
+
+static int gpio_mock_read(gpio_t *gpio, bool *value) {
+    if (gpio->u.mock.event_fd < 0)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO is not open");
+
+    *value = __atomic_load_n(&gpio->u.mock.value, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+static int gpio_mock_write(gpio_t *gpio, bool value) {
+    if (gpio->u.mock.event_fd < 0)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO is not open");
+    else if (gpio->u.mock.direction != GPIO_DIR_OUT)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot write to input GPIO");
+
+    __atomic_store_n(&gpio->u.mock.value, value, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+static int gpio_mock_poll(gpio_t *gpio, int timeout_ms) {
+    struct pollfd fds[1];
+    int ret;
+
+    if (gpio->u.mock.event_fd < 0)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO is not open");
+    else if (gpio->u.mock.direction != GPIO_DIR_IN)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot poll output GPIO");
+
+    if ((ret = _gpio_mock_settle(gpio)) != 0 || timeout_ms == 0)
+        return ret;
+
+    fds[0].fd = gpio->u.mock.event_fd;
+    fds[0].events = POLLIN;
+    if ((ret = poll(fds, 1, timeout_ms)) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Polling GPIO line");
+
+    return ret > 0;
+}
+
+static int gpio_mock_read_events(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms) {
+    size_t count = 0;
+    int ret;
+
+    if (gpio->u.mock.event_fd < 0)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO is not open");
+    else if (gpio->u.mock.direction != GPIO_DIR_IN)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot read event of output GPIO");
+    else if (gpio->u.mock.edge == GPIO_EDGE_NONE)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO edge not set");
+
+    if (max == 0)
+        return 0;
+
+    while (true) {
+        count += _gpio_event_ring_pop(gpio->u.mock.ring, events + count, max - count);
+
+        if ((ret = _gpio_mock_settle(gpio)) < 0)
+            return ret;
+
+        /* Return a full batch, or what was read once the ring is empty */
+        if (count == max || (ret == 0 && (count > 0 || timeout_ms == 0)))
+            break;
+        else if (ret == 1)
+            continue;
+
+        /* Wait for the armed wakeup */
+        if ((ret = gpio_mock_poll(gpio, timeout_ms)) <= 0)
+            return ret;
+    }
+
+    __atomic_store_n(&gpio->u.mock.event_stats.events, gpio->u.mock.event_stats.events + count, __ATOMIC_RELAXED);
+
+    return count;
+}
+
+static int gpio_mock_read_event(gpio_t *gpio, gpio_edge_t *edge, uint64_t *timestamp) {
+    gpio_event_t event;
+    int ret;
+
+    if ((ret = gpio_mock_read_events(gpio, &event, 1, -1)) < 0)
+        return ret;
+
+    if (edge)
+        *edge = event.edge;
+    if (timestamp)
+        *timestamp = event.timestamp;
+
+    return 0;
+}
+
+static int gpio_mock_get_event_stats(gpio_t *gpio, gpio_event_stats_t *stats) {
+    stats->events = __atomic_load_n(&gpio->u.mock.event_stats.events, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&gpio->u.mock.event_stats.dropped, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static int gpio_mock_read_line_info_event(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms) {
+    (void)event;
+    (void)timeout_ms;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type mock does not support line info events");
+}
+
+static int gpio_mock_close(gpio_t *gpio) {
+    if (gpio->u.mock.event_fd >= 0) {
+        if (close(gpio->u.mock.event_fd) < 0)
+            return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing mock GPIO eventfd");
+
+        gpio->u.mock.event_fd = -1;
+    }
+
+    if (gpio->u.mock.ring) {
+        free(gpio->u.mock.ring->events);
+        free(gpio->u.mock.ring);
+        gpio->u.mock.ring = NULL;
+    }
+
+    gpio->u.mock.edge = GPIO_EDGE_NONE;
+    gpio->u.mock.direction = GPIO_DIR_IN;
+
+    return 0;
+}
+
+static int gpio_mock_get_direction(gpio_t *gpio, gpio_direction_t *direction) {
+    *direction = gpio->u.mock.direction;
+    return 0;
+}
+
+static int gpio_mock_get_edge(gpio_t *gpio, gpio_edge_t *edge) {
+    *edge = gpio->u.mock.edge;
+    return 0;
+}
+
+static int gpio_mock_get_event_clock(gpio_t *gpio, gpio_event_clock_t *event_clock) {
+    *event_clock = gpio->u.mock.event_clock;
+    return 0;
+}
+
+static int gpio_mock_get_debounce_us(gpio_t *gpio, uint32_t *debounce_us) {
+    *debounce_us = gpio->u.mock.debounce_us;
+    return 0;
+}
+
+static int gpio_mock_get_bias(gpio_t *gpio, gpio_bias_t *bias) {
+    *bias = gpio->u.mock.bias;
+    return 0;
+}
+
+static int gpio_mock_get_drive(gpio_t *gpio, gpio_drive_t *drive) {
+    *drive = gpio->u.mock.drive;
+    return 0;
+}
+
+static int gpio_mock_get_inverted(gpio_t *gpio, bool *inverted) {
+    *inverted = gpio->u.mock.inverted;
+    return 0;
+}
+
+static int gpio_mock_set_config(gpio_t *gpio, const gpio_config_t *config) {
+    const char *errmsg;
+
+    if ((errmsg = _gpio_mock_check_config(config)) != NULL)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "%s", errmsg);
+
+    if (config->inverted != gpio->u.mock.inverted)
+        __atomic_store_n(&gpio->u.mock.value, !__atomic_load_n(&gpio->u.mock.value, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+    _gpio_mock_configure(gpio, config);
+
+    return 0;
+}
+
+static gpio_config_t _gpio_mock_config(gpio_t *gpio) {
+    gpio_config_t config = {
+        .direction = gpio->u.mock.direction,
+        .edge = gpio->u.mock.edge,
+        .event_clock = gpio->u.mock.event_clock,
+        .debounce_us = gpio->u.mock.debounce_us,
+        .bias = gpio->u.mock.bias,
+        .drive = gpio->u.mock.drive,
+        .inverted = gpio->u.mock.inverted,
+    };
+
+    return config;
+}
+
+static int gpio_mock_set_direction(gpio_t *gpio, gpio_direction_t direction) {
+    gpio_config_t config = _gpio_mock_config(gpio);
+
+    if (direction != GPIO_DIR_IN && direction != GPIO_DIR_OUT && direction != GPIO_DIR_OUT_LOW && direction != GPIO_DIR_OUT_HIGH)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
+
+    if (gpio->u.mock.direction == direction)
+        return 0;
+
+    config.direction = direction;
+    config.edge = GPIO_EDGE_NONE;
+    config.debounce_us = (direction == GPIO_DIR_IN) ? config.debounce_us : 0;
+    config.drive = (direction == GPIO_DIR_IN) ? GPIO_DRIVE_DEFAULT : config.drive;
+
+    return gpio_mock_set_config(gpio, &config);
+}
+
+static int gpio_mock_set_edge(gpio_t *gpio, gpio_edge_t edge) {
+    gpio_config_t config = _gpio_mock_config(gpio);
+
+    if (edge != GPIO_EDGE_NONE && edge != GPIO_EDGE_RISING && edge != GPIO_EDGE_FALLING && edge != GPIO_EDGE_BOTH)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO interrupt edge (can be none, rising, falling, both)");
+
+    if (gpio->u.mock.direction != GPIO_DIR_IN)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot set edge on output GPIO");
+
+    config.edge = edge;
+
+    return gpio_mock_set_config(gpio, &config);
+}
+
+static int gpio_mock_set_event_clock(gpio_t *gpio, gpio_event_clock_t event_clock) {
+    gpio_config_t config = _gpio_mock_config(gpio);
+
+    config.event_clock = event_clock;
+
+    return gpio_mock_set_config(gpio, &config);
+}
+
+static int gpio_mock_set_debounce_us(gpio_t *gpio, uint32_t debounce_us) {
+    gpio_config_t config = _gpio_mock_config(gpio);
+
+    config.debounce_us = debounce_us;
+
+    return gpio_mock_set_config(gpio, &config);
+}
+
+static int gpio_mock_set_bias(gpio_t *gpio, gpio_bias_t bias) {
+    gpio_config_t config = _gpio_mock_config(gpio);
+
+    config.bias = bias;
+
+    return gpio_mock_set_config(gpio, &config);
+}
+
+static int gpio_mock_set_drive(gpio_t *gpio, gpio_drive_t drive) {
+    gpio_config_t config = _gpio_mock_config(gpio);
+
+    config.drive = drive;
+
+    return gpio_mock_set_config(gpio, &config);
+}
+
+static int gpio_mock_set_inverted(gpio_t *gpio, bool inverted) {
+    gpio_config_t config = _gpio_mock_config(gpio);
+
+    config.inverted = inverted;
+
+    return gpio_mock_set_config(gpio, &config);
+}
+
+static unsigned int gpio_mock_line(gpio_t *gpio) {
+    return gpio->u.mock.line;
+}
+
+static int gpio_mock_fd(gpio_t *gpio) {
+    return gpio->u.mock.event_fd;
+}
+
+static int gpio_mock_name(gpio_t *gpio, char *str, size_t len) {
+    (void)gpio;
+
+    if (len)
+        str[0] = '\0';
+
+    return 0;
+}
+
+static int gpio_mock_label(gpio_t *gpio, char *str, size_t len) {
+    if (!len)
+        return 0;
+
+    strncpy(str, gpio->u.mock.label, len - 1);
+    str[len - 1] = '\0';
+
+    return 0;
+}
+
+static int gpio_mock_chip_fd(gpio_t *gpio) {
+    (void)gpio;
+    return -1;
+}
+
+static int gpio_mock_chip_name(gpio_t *gpio, char *str, size_t len) {
+    (void)gpio;
+
+    if (!len)
+        return 0;
+
+    strncpy(str, "mock", len - 1);
+    str[len - 1] = '\0';
+
+    return 0;
+}
+
+static int gpio_mock_chip_label(gpio_t *gpio, char *str, size_t len) {
+    (void)gpio;
+
+    if (len)
+        str[0] = '\0';
+
+    return 0;
+}
+
+static int gpio_mock_tostring(gpio_t *gpio, char *str, size_t len) {
+    const char *direction_str, *edge_str, *event_clock_str, *bias_str, *drive_str;
+
+    direction_str = (gpio->u.mock.direction == GPIO_DIR_IN) ? "in" :
+                    (gpio->u.mock.direction == GPIO_DIR_OUT) ? "out" : "unknown";
+
+    edge_str = (gpio->u.mock.edge == GPIO_EDGE_NONE) ? "none" :
+               (gpio->u.mock.edge == GPIO_EDGE_RISING) ? "rising" :
+               (gpio->u.mock.edge == GPIO_EDGE_FALLING) ? "falling" :
+               (gpio->u.mock.edge == GPIO_EDGE_BOTH) ? "both" : "unknown";
+
+    event_clock_str = (gpio->u.mock.event_clock == GPIO_EVENT_CLOCK_REALTIME) ? "realtime" :
+                      (gpio->u.mock.event_clock == GPIO_EVENT_CLOCK_MONOTONIC) ? "monotonic" :
+                      (gpio->u.mock.event_clock == GPIO_EVENT_CLOCK_HTE) ? "hte" : "unknown";
+
+    bias_str = (gpio->u.mock.bias == GPIO_BIAS_DEFAULT) ? "default" :
+               (gpio->u.mock.bias == GPIO_BIAS_PULL_UP) ? "pull_up" :
+               (gpio->u.mock.bias == GPIO_BIAS_PULL_DOWN) ? "pull_down" :
+               (gpio->u.mock.bias == GPIO_BIAS_DISABLE) ? "disable" : "unknown";
+
+    drive_str = (gpio->u.mock.drive == GPIO_DRIVE_DEFAULT) ? "default" :
+                (gpio->u.mock.drive == GPIO_DRIVE_OPEN_DRAIN) ? "open_drain" :
+                (gpio->u.mock.drive == GPIO_DRIVE_OPEN_SOURCE) ? "open_source" : "unknown";
+
+    return snprintf(str, len, "GPIO %u (label=\"%s\", fd=%d, direction=%s, edge=%s, event_clock=%s, debounce_us=%u, bias=%s, drive=%s, inverted=%s, event_buffer_size=%zu, type=mock)",
+                    gpio->u.mock.line, gpio->u.mock.label, gpio->u.mock.event_fd, direction_str, edge_str, event_clock_str, gpio->u.mock.debounce_us,
+                    bias_str, drive_str, gpio->u.mock.inverted ? "true" : "false", gpio->u.mock.ring ? gpio->u.mock.ring->mask + 1 : 0);
+}
+
+const struct gpio_ops gpio_mock_ops = {
+    .read = gpio_mock_read,
+    .write = gpio_mock_write,
+    .read_event = gpio_mock_read_event,
+    .read_events = gpio_mock_read_events,
+    .get_event_stats = gpio_mock_get_event_stats,
+    .read_line_info_event = gpio_mock_read_line_info_event,
+    .poll = gpio_mock_poll,
+    .close = gpio_mock_close,
+    .get_direction = gpio_mock_get_direction,
+    .get_edge = gpio_mock_get_edge,
+    .get_event_clock = gpio_mock_get_event_clock,
+    .get_debounce_us = gpio_mock_get_debounce_us,
+    .get_bias = gpio_mock_get_bias,
+    .get_drive = gpio_mock_get_drive,
+    .get_inverted = gpio_mock_get_inverted,
+    .set_direction = gpio_mock_set_direction,
+    .set_edge = gpio_mock_set_edge,
+    .set_event_clock = gpio_mock_set_event_clock,
+    .set_debounce_us = gpio_mock_set_debounce_us,
+    .set_bias = gpio_mock_set_bias,
+    .set_drive = gpio_mock_set_drive,
+    .set_inverted = gpio_mock_set_inverted,
+    .set_config = gpio_mock_set_config,
+    .line = gpio_mock_line,
+    .fd = gpio_mock_fd,
+    .name = gpio_mock_name,
+    .label = gpio_mock_label,
+    .chip_fd = gpio_mock_chip_fd,
+    .chip_name = gpio_mock_chip_name,
+    .chip_label = gpio_mock_chip_label,
+    .tostring = gpio_mock_tostring,
+};
+
+int gpio_open_mock_advanced(gpio_t *gpio, unsigned int line, const gpio_config_t *config) {
+    struct gpio_event_ring *ring;
+    const char *errmsg;
+    size_t capacity;
+    int event_fd;
+
+    if ((errmsg = _gpio_mock_check_config(config)) != NULL)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "%s", errmsg);
+
+    /* Round event buffer size up to a power of two */
+    for (capacity = 1; capacity < (config->event_buffer_size ? config->event_buffer_size : GPIO_MOCK_EVENT_BUFFER_DEFAULT); capacity <<= 1)
+        ;
+
+    /* Ring indices are kept on separate cache lines */
+    if (posix_memalign((void **)&ring, 64, sizeof(struct gpio_event_ring)) != 0)
+        return _gpio_error(gpio, GPIO_ERROR_OPEN, ENOMEM, "Allocating mock GPIO event ring");
+
+    memset(ring, 0, sizeof(struct gpio_event_ring));
+    ring->mask = capacity - 1;
+
+    if ((ring->events = calloc(capacity, sizeof(gpio_event_t))) == NULL) {
+        free(ring);
+        return _gpio_error(gpio, GPIO_ERROR_OPEN, ENOMEM, "Allocating mock GPIO event ring");
+    }
+
+    if ((event_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        int errsv = errno;
+        free(ring->events);
+        free(ring);
+        return _gpio_error(gpio, GPIO_ERROR_OPEN, errsv, "Creating mock GPIO eventfd");
+    }
+
+    memset(gpio, 0, sizeof(gpio_t));
+    gpio->ops = &gpio_mock_ops;
+    gpio->u.mock.line = line;
+    gpio->u.mock.event_fd = event_fd;
+    gpio->u.mock.ring = ring;
+    strncpy(gpio->u.mock.label, config->label ? config->label : "periphery", sizeof(gpio->u.mock.label) - 1);
+    gpio->u.mock.label[sizeof(gpio->u.mock.label) - 1] = '\0';
+
+    /* Inverted lines idle high */
+    gpio->u.mock.value = config->inverted;
+    _gpio_mock_configure(gpio, config);
+
+    /* Arm the first wakeup */
+    gpio->u.mock.armed = true;
+    gpio->u.mock.armed_local = true;
+
+    return 0;
+}
+
+int gpio_open_mock(gpio_t *gpio, unsigned int line, gpio_direction_t direction) {
+    gpio_config_t config = {
+        .direction = direction,
+        .edge = GPIO_EDGE_NONE,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+
+    return gpio_open_mock_advanced(gpio, line, &config);
+}
+
+int gpio_mock_inject_events(gpio_t *gpio, const gpio_event_t *events, size_t count) {
+    struct gpio_event_ring *ring;
+    size_t head, tail, space, queued, i;
+    uint64_t now = 0;
+    gpio_edge_t edge;
+
+    if (!_gpio_is_mock(gpio))
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO is not of type mock");
+    else if (gpio->u.mock.event_fd < 0)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: GPIO is not open");
+    else if (gpio->u.mock.direction != GPIO_DIR_IN)
+        return _gpio_error(gpio, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot inject edge into output GPIO");
+
+    for (i = 0; i < count; i++) {
+        if (events[i].edge != GPIO_EDGE_RISING && events[i].edge != GPIO_EDGE_FALLING)
+            return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO event edge (can be rising, falling)");
+    }
+
+    if (count == 0)
+        return 0;
+
+    ring = gpio->u.mock.ring;
+    edge = gpio->u.mock.edge;
+
+    /* Queue matching edges directly into the ring, as a single push */
+    head = ring->head;
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    space = ring->mask + 1 - (head - tail);
+
+    for (i = 0, queued = 0; i < count; i++) {
+        gpio_event_t *event;
+
+        if (edge != GPIO_EDGE_BOTH && edge != events[i].edge)
+            continue;
+
+        /* Dropped events still take a sequence number, like the kernel's */
+        gpio->u.mock.seqno++;
+
+        if (queued == space) {
+            __atomic_fetch_add(&gpio->u.mock.event_stats.dropped, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        if (events[i].timestamp == 0 && now == 0)
+            now = _gpio_mock_now(gpio->u.mock.event_clock);
+
+        event = &ring->events[(head + queued++) & ring->mask];
+        event->edge = events[i].edge;
+        event->timestamp = events[i].timestamp ? events[i].timestamp : now;
+        event->line = gpio->u.mock.line;
+        event->seqno = gpio->u.mock.seqno;
+        event->line_seqno = gpio->u.mock.seqno;
+    }
+
+    __atomic_store_n(&gpio->u.mock.value, events[count - 1].edge == GPIO_EDGE_RISING, __ATOMIC_RELAXED);
+
+    if (queued == 0)
+        return 0;
+
+    __atomic_store_n(&ring->head, head + queued, __ATOMIC_RELEASE);
+
+    /* Signal the consumer if it armed a wakeup */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&gpio->u.mock.armed, __ATOMIC_RELAXED) && __atomic_exchange_n(&gpio->u.mock.armed, false, __ATOMIC_ACQ_REL)) {
+        uint64_t token = 1;
+
+        while (write(gpio->u.mock.event_fd, &token, sizeof(token)) < 0) {
+            if (errno != EINTR)
+                return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Signaling mock GPIO eventfd");
+        }
+    }
+
+    return queued;
+}
+
+int gpio_mock_inject_edge(gpio_t *gpio, gpio_edge_t edge, uint64_t timestamp) {
+    gpio_event_t event = {0};
+
+    event.edge = edge;
+    event.timestamp = timestamp;
+
+    return gpio_mock_inject_events(gpio, &event, 1);
+}
+
+#else
+
+/* Mock GPIOs reach reads and writes through the operations table, which a
+ * character device only build bypasses */
+#define GPIO_MOCK_UNSUPPORTED "c-periphery library built with character device GPIO backend only."
+
+int gpio_open_mock_advanced(gpio_t *gpio, unsigned int line, const gpio_config_t *config) {
+    (void)line;
+    (void)config;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, GPIO_MOCK_UNSUPPORTED);
+}
+
+int gpio_open_mock(gpio_t *gpio, unsigned int line, gpio_direction_t direction) {
+    (void)line;
+    (void)direction;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, GPIO_MOCK_UNSUPPORTED);
+}
+
+int gpio_mock_inject_events(gpio_t *gpio, const gpio_event_t *events, size_t count) {
+    (void)events;
+    (void)count;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, GPIO_MOCK_UNSUPPORTED);
+}
+
+int gpio_mock_inject_edge(gpio_t *gpio, gpio_edge_t edge, uint64_t timestamp) {
+    (void)edge;
+    (void)timestamp;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, GPIO_MOCK_UNSUPPORTED);
+}
+
+#endif
@@ -0,0 +1,379 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+
+#include "gpio.h"
+#include "gpio_internal.h"
+
+/* Maximum number of ready GPIOs collected by a single epoll_wait() */
+#define GPIO_READER_READY_MAX   16
+
+/* Maximum number of events drained from a GPIO per wakeup */
+#define GPIO_READER_BATCH       64
+
+struct gpio_reader_slot {
+    gpio_t *gpio;
+    struct gpio_event_ring ring;
+
+    /* updated by reader thread */
+    uint64_t events;
+    uint64_t dropped;
+    int code;
+    int c_errno;
+};
+
+struct gpio_reader_handle {
+    int epoll_fd;
+    int stop_fd;
+    size_t ring_size;
+    struct gpio_reader_slot **slots;
+    size_t count;
+    bool running;
+    pthread_t thread;
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_reader_error(gpio_reader_t *reader, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    reader->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(reader->error.errmsg, sizeof(reader->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(reader->error.errmsg+strlen(reader->error.errmsg), sizeof(reader->error.errmsg)-strlen(reader->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static struct gpio_reader_slot *_gpio_reader_find(gpio_reader_t *reader, gpio_t *gpio, size_t *index) {
+    for (size_t i = 0; i < reader->count; i++) {
+        if (reader->slots[i]->gpio == gpio) {
+            if (index)
+                *index = i;
+            return reader->slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void _gpio_reader_slot_fail(gpio_reader_t *reader, struct gpio_reader_slot *slot, int code, int c_errno) {
+    /* Stop watching the GPIO and publish the failure to the consumer */
+    epoll_ctl(reader->epoll_fd, EPOLL_CTL_DEL, gpio_fd(slot->gpio), NULL);
+
+    __atomic_store_n(&slot->c_errno, c_errno, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->code, code, __ATOMIC_RELEASE);
+}
+
+static void *_gpio_reader_thread(void *arg) {
+    gpio_reader_t *reader = (gpio_reader_t *)arg;
+    struct epoll_event ready[GPIO_READER_READY_MAX];
+    gpio_event_t events[GPIO_READER_BATCH];
+
+    while (true) {
+        int n;
+
+        if ((n = epoll_wait(reader->epoll_fd, ready, GPIO_READER_READY_MAX, -1)) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            /* Fail all GPIOs */
+            int errsv = errno;
+            for (size_t i = 0; i < reader->count; i++)
+                _gpio_reader_slot_fail(reader, reader->slots[i], GPIO_ERROR_IO, errsv);
+
+            return NULL;
+        }
+
+        for (int i = 0; i < n; i++) {
+            struct gpio_reader_slot *slot = (struct gpio_reader_slot *)ready[i].data.ptr;
+            size_t pushed;
+            int ret;
+
+            /* Stop requested */
+            if (slot == NULL)
+                return NULL;
+
+            if (!(ready[i].events & EPOLLIN)) {
+                _gpio_reader_slot_fail(reader, slot, GPIO_ERROR_IO, 0);
+                continue;
+            }
+
+            /* Drain a batch of events into the ring. The backend updates the
+             * event stats of the GPIO atomically, and its error state only on
+             * failure, which is published to the consumer by the slot. */
+            if ((ret = slot->gpio->ops->read_events(slot->gpio, events, GPIO_READER_BATCH, -1)) < 0) {
+                _gpio_reader_slot_fail(reader, slot, ret, slot->gpio->error.c_errno);
+                continue;
+            }
+
+            pushed = _gpio_event_ring_push(&slot->ring, events, ret);
+
+            __atomic_add_fetch(&slot->events, pushed, __ATOMIC_RELAXED);
+            if (pushed < (size_t)ret)
+                __atomic_add_fetch(&slot->dropped, ret - pushed, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+gpio_reader_t *gpio_reader_new(void) {
+    gpio_reader_t *reader = calloc(1, sizeof(gpio_reader_t));
+    if (reader == NULL)
+        return NULL;
+
+    reader->epoll_fd = -1;
+    reader->stop_fd = -1;
+
+    return reader;
+}
+
+void gpio_reader_free(gpio_reader_t *reader) {
+    free(reader);
+}
+
+int gpio_reader_open(gpio_reader_t *reader, size_t ring_size) {
+    struct epoll_event ev = {0};
+    int epoll_fd, stop_fd, ret;
+
+    if (ring_size == 0 || ring_size > ((size_t)1 << 24))
+        return _gpio_reader_error(reader, GPIO_ERROR_ARG, 0, "Invalid ring size (can be 1 to %zu)", (size_t)1 << 24);
+
+    /* Stop the thread, and release the GPIOs and fds of a previous open */
+    if ((ret = gpio_reader_close(reader)) < 0)
+        return ret;
+
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        return _gpio_reader_error(reader, GPIO_ERROR_OPEN, errno, "Creating epoll instance");
+
+    if ((stop_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        int errsv = errno;
+        close(epoll_fd);
+        return _gpio_reader_error(reader, GPIO_ERROR_OPEN, errsv, "Creating stop eventfd");
+    }
+
+    /* Stop eventfd is identified by a NULL slot */
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &ev) < 0) {
+        int errsv = errno;
+        close(stop_fd);
+        close(epoll_fd);
+        return _gpio_reader_error(reader, GPIO_ERROR_OPEN, errsv, "Adding stop eventfd to epoll instance");
+    }
+
+    memset(reader, 0, sizeof(gpio_reader_t));
+    reader->epoll_fd = epoll_fd;
+    reader->stop_fd = stop_fd;
+
+    /* Round ring size up to a power of two */
+    reader->ring_size = 1;
+    while (reader->ring_size < ring_size)
+        reader->ring_size <<= 1;
+
+    return 0;
+}
+
+int gpio_reader_add(gpio_reader_t *reader, gpio_t *gpio) {
+    struct gpio_reader_slot *slot, **slots;
+    struct epoll_event ev = {0};
+
+    if (reader->running)
+        return _gpio_reader_error(reader, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot add GPIO to running reader");
+
+    if (_gpio_is_sysfs(gpio))
+        return _gpio_reader_error(reader, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support background reader");
+
+    if (_gpio_reader_find(reader, gpio, NULL) != NULL)
+        return _gpio_reader_error(reader, GPIO_ERROR_ARG, 0, "GPIO %u already added to reader", gpio_line(gpio));
+
+    if ((slots = realloc(reader->slots, (reader->count + 1) * sizeof(struct gpio_reader_slot *))) == NULL)
+        return _gpio_reader_error(reader, GPIO_ERROR_OPEN, errno, "Allocating reader slots");
+    reader->slots = slots;
+
+    if (posix_memalign((void **)&slot, 64, sizeof(struct gpio_reader_slot)) != 0)
+        return _gpio_reader_error(reader, GPIO_ERROR_OPEN, ENOMEM, "Allocating reader slot");
+
+    memset(slot, 0, sizeof(struct gpio_reader_slot));
+    slot->gpio = gpio;
+    slot->ring.mask = reader->ring_size - 1;
+
+    if ((slot->ring.events = calloc(reader->ring_size, sizeof(gpio_event_t))) == NULL) {
+        free(slot);
+        return _gpio_reader_error(reader, GPIO_ERROR_OPEN, ENOMEM, "Allocating reader ring");
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = slot;
+
+    if (epoll_ctl(reader->epoll_fd, EPOLL_CTL_ADD, gpio_fd(gpio), &ev) < 0) {
+        int errsv = errno;
+        free(slot->ring.events);
+        free(slot);
+        return _gpio_reader_error(reader, GPIO_ERROR_CONFIGURE, errsv, "Adding GPIO %u to reader", gpio_line(gpio));
+    }
+
+    reader->slots[reader->count++] = slot;
+
+    return 0;
+}
+
+int gpio_reader_remove(gpio_reader_t *reader, gpio_t *gpio) {
+    struct gpio_reader_slot *slot;
+    size_t index;
+
+    if (reader->running)
+        return _gpio_reader_error(reader, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: cannot remove GPIO from running reader");
+
+    if ((slot = _gpio_reader_find(reader, gpio, &index)) == NULL)
+        return _gpio_reader_error(reader, GPIO_ERROR_ARG, 0, "GPIO %u not added to reader", gpio_line(gpio));
+
+    /* GPIO may already be removed from epoll instance by a failure */
+    if (epoll_ctl(reader->epoll_fd, EPOLL_CTL_DEL, gpio_fd(gpio), NULL) < 0 && errno != ENOENT)
+        return _gpio_reader_error(reader, GPIO_ERROR_CONFIGURE, errno, "Removing GPIO %u from reader", gpio_line(gpio));
+
+    free(slot->ring.events);
+    free(slot);
+
+    reader->slots[index] = reader->slots[--reader->count];
+
+    return 0;
+}
+
+int gpio_reader_start(gpio_reader_t *reader) {
+    int ret;
+
+    if (reader->running)
+        return 0;
+
+    if ((ret = pthread_create(&reader->thread, NULL, _gpio_reader_thread, reader)) != 0)
+        return _gpio_reader_error(reader, GPIO_ERROR_CONFIGURE, ret, "Creating reader thread");
+
+    reader->running = true;
+
+    return 0;
+}
+
+int gpio_reader_stop(gpio_reader_t *reader) {
+    uint64_t value = 1;
+    int ret;
+
+    if (!reader->running)
+        return 0;
+
+    if (write(reader->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_reader_error(reader, GPIO_ERROR_CONFIGURE, errno, "Signaling reader thread");
+
+    if ((ret = pthread_join(reader->thread, NULL)) != 0)
+        return _gpio_reader_error(reader, GPIO_ERROR_CONFIGURE, ret, "Joining reader thread");
+
+    /* Reset stop eventfd */
+    if (read(reader->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_reader_error(reader, GPIO_ERROR_CONFIGURE, errno, "Resetting stop eventfd");
+
+    reader->running = false;
+
+    return 0;
+}
+
+int gpio_reader_dequeue(gpio_reader_t *reader, gpio_t *gpio, gpio_event_t *events, size_t max) {
+    struct gpio_reader_slot *slot;
+    size_t count;
+    int code;
+
+    if ((slot = _gpio_reader_find(reader, gpio, NULL)) == NULL)
+        return _gpio_reader_error(reader, GPIO_ERROR_ARG, 0, "GPIO %u not added to reader", gpio_line(gpio));
+
+    if ((count = _gpio_event_ring_pop(&slot->ring, events, max)) > 0)
+        return count;
+
+    /* Report reader thread failure once ring is drained */
+    if ((code = __atomic_load_n(&slot->code, __ATOMIC_ACQUIRE)) < 0)
+        return _gpio_reader_error(reader, code, __atomic_load_n(&slot->c_errno, __ATOMIC_RELAXED), "Reading events of GPIO %u", gpio_line(gpio));
+
+    return 0;
+}
+
+int gpio_reader_get_stats(gpio_reader_t *reader, gpio_t *gpio, gpio_event_stats_t *stats) {
+    struct gpio_reader_slot *slot;
+
+    if ((slot = _gpio_reader_find(reader, gpio, NULL)) == NULL)
+        return _gpio_reader_error(reader, GPIO_ERROR_ARG, 0, "GPIO %u not added to reader", gpio_line(gpio));
+
+    stats->events = __atomic_load_n(&slot->events, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&slot->dropped, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+int gpio_reader_close(gpio_reader_t *reader) {
+    int ret;
+
+    if ((ret = gpio_reader_stop(reader)) < 0)
+        return ret;
+
+    for (size_t i = 0; i < reader->count; i++) {
+        free(reader->slots[i]->ring.events);
+        free(reader->slots[i]);
+    }
+
+    free(reader->slots);
+    reader->slots = NULL;
+    reader->count = 0;
+
+    if (reader->stop_fd >= 0) {
+        if (close(reader->stop_fd) < 0)
+            return _gpio_reader_error(reader, GPIO_ERROR_CLOSE, errno, "Closing stop eventfd");
+
+        reader->stop_fd = -1;
+    }
+
+    if (reader->epoll_fd >= 0) {
+        if (close(reader->epoll_fd) < 0)
+            return _gpio_reader_error(reader, GPIO_ERROR_CLOSE, errno, "Closing epoll instance");
+
+        reader->epoll_fd = -1;
+    }
+
+    return 0;
+}
+
+size_t gpio_reader_count(gpio_reader_t *reader) {
+    return reader->count;
+}
+
+bool gpio_reader_running(gpio_reader_t *reader) {
+    return reader->running;
+}
+
+int gpio_reader_errno(gpio_reader_t *reader) {
+    return reader->error.c_errno;
+}
+
+const char *gpio_reader_errmsg(gpio_reader_t *reader) {
+    return reader->error.errmsg;
+}
@@ -0,0 +1,466 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <errno.h>
+
+#include "gpio_sampler.h"
+#include "gpio_internal.h"
+
+/* Maximum ring size */
+#define GPIO_SAMPLER_RING_MAX   ((size_t)1 << 24)
+
+GPIO_RING_DEFINE(sample, gpio_sample_t, samples)
+
+struct gpio_sampler_handle {
+    gpio_lines_t *lines;
+    uint64_t lines_mask;
+    uint64_t period_ns;
+    gpio_sampler_pacing_t pacing;
+    size_t ring_size;
+    unsigned int filter_samples;
+
+    struct gpio_sample_ring samples;
+    struct gpio_event_ring events;
+
+    /* filter state, owned by sampler thread */
+    uint64_t history[GPIO_LINES_MAX];
+    uint64_t filtered;
+    bool primed;
+    uint32_t seqno;
+    uint32_t line_seqno[GPIO_LINES_MAX];
+
+    int stop_fd;
+    bool stop;
+    bool running;
+    pthread_t thread;
+
+    /* updated by sampler thread */
+    gpio_sampler_stats_t stats;
+    int code;
+    int c_errno;
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_sampler_error(gpio_sampler_t *sampler, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    sampler->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(sampler->error.errmsg, sizeof(sampler->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(sampler->error.errmsg+strlen(sampler->error.errmsg), sizeof(sampler->error.errmsg)-strlen(sampler->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static uint64_t _gpio_sampler_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void _gpio_sampler_ns_to_timespec(uint64_t ns, struct timespec *ts) {
+    ts->tv_sec = ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+static void _gpio_sampler_fail(gpio_sampler_t *sampler, int code, int c_errno) {
+    __atomic_store_n(&sampler->c_errno, c_errno, __ATOMIC_RELAXED);
+    __atomic_store_n(&sampler->code, code, __ATOMIC_RELEASE);
+}
+
+static void _gpio_sampler_account(gpio_sampler_t *sampler, uint64_t latency_ns, uint64_t missed) {
+    gpio_sampler_stats_t *stats = &sampler->stats;
+    uint64_t samples = stats->samples + 1;
+    double mean = stats->jitter_mean_ns + ((double)latency_ns - stats->jitter_mean_ns) / samples;
+
+    if (samples == 1 || latency_ns < stats->jitter_min_ns)
+        __atomic_store_n(&stats->jitter_min_ns, latency_ns, __ATOMIC_RELAXED);
+    if (latency_ns > stats->jitter_max_ns)
+        __atomic_store_n(&stats->jitter_max_ns, latency_ns, __ATOMIC_RELAXED);
+    if (missed)
+        __atomic_store_n(&stats->missed, stats->missed + missed, __ATOMIC_RELAXED);
+
+    __atomic_store(&stats->jitter_mean_ns, &mean, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->samples, samples, __ATOMIC_RELAXED);
+}
+
+static void _gpio_sampler_filter(gpio_sampler_t *sampler, uint64_t timestamp, uint64_t bits) {
+    gpio_event_t events[GPIO_LINES_MAX];
+    uint64_t window_mask = ((uint64_t)1 << sampler->filter_samples) - 1;
+    size_t count = 0, pushed;
+
+    /* Prime history with first sample */
+    if (!sampler->primed) {
+        for (size_t i = 0; i < gpio_lines_count(sampler->lines); i++)
+            sampler->history[i] = ((bits >> i) & 1) ? window_mask : 0;
+
+        sampler->filtered = bits;
+        sampler->primed = true;
+        return;
+    }
+
+    for (size_t i = 0; i < gpio_lines_count(sampler->lines); i++) {
+        bool level;
+
+        sampler->history[i] = ((sampler->history[i] << 1) | ((bits >> i) & 1)) & window_mask;
+
+        /* Majority of the last filter_samples samples */
+        level = (unsigned int)__builtin_popcountll(sampler->history[i]) > sampler->filter_samples / 2;
+        if (level == (bool)((sampler->filtered >> i) & 1))
+            continue;
+
+        sampler->filtered ^= (uint64_t)1 << i;
+
+        events[count].edge = level ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING;
+        events[count].timestamp = timestamp;
+        events[count].line = gpio_lines_line(sampler->lines, i);
+        events[count].seqno = ++sampler->seqno;
+        events[count].line_seqno = ++sampler->line_seqno[i];
+        count++;
+    }
+
+    if (count == 0)
+        return;
+
+    pushed = _gpio_event_ring_push(&sampler->events, events, count);
+
+    __atomic_store_n(&sampler->stats.events, sampler->stats.events + pushed, __ATOMIC_RELAXED);
+    if (pushed < count)
+        __atomic_store_n(&sampler->stats.events_dropped, sampler->stats.events_dropped + (count - pushed), __ATOMIC_RELAXED);
+}
+
+static void *_gpio_sampler_thread(void *arg) {
+    gpio_sampler_t *sampler = (gpio_sampler_t *)arg;
+    uint64_t deadline = _gpio_sampler_now() + sampler->period_ns;
+    struct itimerspec spec = {{0, 0}, {0, 0}};
+    struct pollfd fds[2];
+    int timer_fd;
+
+    /* Both pacings wait on a timerfd together with the stop eventfd, so
+     * that gpio_sampler_stop() does not wait out the sampling period */
+    if ((timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+        _gpio_sampler_fail(sampler, GPIO_ERROR_CONFIGURE, errno);
+        return NULL;
+    }
+
+    if (sampler->pacing == GPIO_SAMPLER_PACING_TIMERFD) {
+        _gpio_sampler_ns_to_timespec(deadline, &spec.it_value);
+        _gpio_sampler_ns_to_timespec(sampler->period_ns, &spec.it_interval);
+
+        if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+            _gpio_sampler_fail(sampler, GPIO_ERROR_CONFIGURE, errno);
+            close(timer_fd);
+            return NULL;
+        }
+    }
+
+    fds[0].fd = timer_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = sampler->stop_fd;
+    fds[1].events = POLLIN;
+
+    while (!__atomic_load_n(&sampler->stop, __ATOMIC_ACQUIRE)) {
+        uint64_t missed = 0, now, latency, bits, expirations;
+        gpio_sample_t sample;
+        int ret;
+
+        /* Arm a one-shot timer for the next deadline */
+        if (sampler->pacing == GPIO_SAMPLER_PACING_ONESHOT) {
+            _gpio_sampler_ns_to_timespec(deadline, &spec.it_value);
+
+            if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+                _gpio_sampler_fail(sampler, GPIO_ERROR_IO, errno);
+                break;
+            }
+        }
+
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            _gpio_sampler_fail(sampler, GPIO_ERROR_IO, errno);
+            break;
+        }
+
+        /* Stop requested */
+        if (fds[1].revents)
+            break;
+
+        if (read(timer_fd, &expirations, sizeof(expirations)) < (ssize_t)sizeof(expirations)) {
+            if (errno == EAGAIN)
+                continue;
+
+            _gpio_sampler_fail(sampler, GPIO_ERROR_IO, errno);
+            break;
+        }
+
+        /* Skip to the latest expired tick of the periodic timer */
+        if (sampler->pacing == GPIO_SAMPLER_PACING_TIMERFD) {
+            missed = expirations - 1;
+            deadline += missed * sampler->period_ns;
+        }
+
+        now = _gpio_sampler_now();
+        latency = (now > deadline) ? now - deadline : 0;
+
+        /* Skip ticks that already passed, rather than sampling in a burst */
+        if (sampler->pacing == GPIO_SAMPLER_PACING_ONESHOT && latency >= sampler->period_ns) {
+            missed = latency / sampler->period_ns;
+            deadline += missed * sampler->period_ns;
+            latency -= missed * sampler->period_ns;
+        }
+
+        /* Sample all lines with a single ioctl */
+        if ((ret = gpio_lines_read(sampler->lines, sampler->lines_mask, &bits)) < 0) {
+            _gpio_sampler_fail(sampler, ret, gpio_lines_errno(sampler->lines));
+            break;
+        }
+
+        sample.timestamp = now;
+        sample.bits = bits;
+
+        if (_gpio_sample_ring_push(&sampler->samples, &sample, 1) == 0)
+            __atomic_store_n(&sampler->stats.samples_dropped, sampler->stats.samples_dropped + 1, __ATOMIC_RELAXED);
+
+        if (sampler->filter_samples)
+            _gpio_sampler_filter(sampler, now, bits);
+
+        _gpio_sampler_account(sampler, latency, missed);
+
+        deadline += sampler->period_ns;
+    }
+
+    close(timer_fd);
+
+    return NULL;
+}
+
+gpio_sampler_t *gpio_sampler_new(void) {
+    gpio_sampler_t *sampler;
+
+    /* Ring indices are cache line aligned */
+    if (posix_memalign((void **)&sampler, 64, sizeof(gpio_sampler_t)) != 0)
+        return NULL;
+
+    memset(sampler, 0, sizeof(gpio_sampler_t));
+    sampler->stop_fd = -1;
+
+    return sampler;
+}
+
+void gpio_sampler_free(gpio_sampler_t *sampler) {
+    free(sampler);
+}
+
+int gpio_sampler_open(gpio_sampler_t *sampler, gpio_lines_t *lines, const gpio_sampler_config_t *config) {
+    gpio_sample_t *samples;
+    gpio_event_t *events = NULL;
+    size_t ring_size, count;
+    int stop_fd;
+
+    if ((count = gpio_lines_count(lines)) == 0)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_ARG, 0, "Invalid GPIO lines (not open)");
+    else if (config->period_ns == 0)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_ARG, 0, "Invalid sampling period (can be at least 1 ns)");
+    else if (config->pacing != GPIO_SAMPLER_PACING_TIMERFD && config->pacing != GPIO_SAMPLER_PACING_ONESHOT)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_ARG, 0, "Invalid sampler pacing (can be timerfd, oneshot)");
+    else if (config->ring_size == 0 || config->ring_size > GPIO_SAMPLER_RING_MAX)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_ARG, 0, "Invalid ring size (can be 1 to %zu)", GPIO_SAMPLER_RING_MAX);
+    else if (config->filter_samples > GPIO_SAMPLER_FILTER_MAX || (config->filter_samples && config->filter_samples % 2 == 0))
+        return _gpio_sampler_error(sampler, GPIO_ERROR_ARG, 0, "Invalid filter samples (can be 0, or odd up to %d)", GPIO_SAMPLER_FILTER_MAX);
+
+    /* Round ring size up to a power of two */
+    ring_size = 1;
+    while (ring_size < config->ring_size)
+        ring_size <<= 1;
+
+    if ((samples = calloc(ring_size, sizeof(gpio_sample_t))) == NULL)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_OPEN, ENOMEM, "Allocating sample ring");
+
+    if (config->filter_samples && (events = calloc(ring_size, sizeof(gpio_event_t))) == NULL) {
+        free(samples);
+        return _gpio_sampler_error(sampler, GPIO_ERROR_OPEN, ENOMEM, "Allocating event ring");
+    }
+
+    if ((stop_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        int errsv = errno;
+        free(events);
+        free(samples);
+        return _gpio_sampler_error(sampler, GPIO_ERROR_OPEN, errsv, "Creating stop eventfd");
+    }
+
+    memset(sampler, 0, sizeof(gpio_sampler_t));
+    sampler->lines = lines;
+    sampler->lines_mask = (count == 64) ? UINT64_MAX : (((uint64_t)1 << count) - 1);
+    sampler->period_ns = config->period_ns;
+    sampler->pacing = config->pacing;
+    sampler->ring_size = ring_size;
+    sampler->filter_samples = config->filter_samples;
+    sampler->samples.samples = samples;
+    sampler->samples.mask = ring_size - 1;
+    sampler->events.events = events;
+    sampler->events.mask = ring_size - 1;
+    sampler->stop_fd = stop_fd;
+
+    return 0;
+}
+
+int gpio_sampler_start(gpio_sampler_t *sampler) {
+    int ret;
+
+    if (sampler->running)
+        return 0;
+
+    if (sampler->lines == NULL)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: sampler not open");
+
+    /* Reprime filter, as lines may have changed while stopped */
+    sampler->primed = false;
+    sampler->stop = false;
+    sampler->code = 0;
+
+    if ((ret = pthread_create(&sampler->thread, NULL, _gpio_sampler_thread, sampler)) != 0)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_CONFIGURE, ret, "Creating sampler thread");
+
+    sampler->running = true;
+
+    return 0;
+}
+
+int gpio_sampler_stop(gpio_sampler_t *sampler) {
+    uint64_t value = 1;
+    int ret;
+
+    if (!sampler->running)
+        return 0;
+
+    __atomic_store_n(&sampler->stop, true, __ATOMIC_RELEASE);
+
+    if (write(sampler->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_CONFIGURE, errno, "Signaling sampler thread");
+
+    if ((ret = pthread_join(sampler->thread, NULL)) != 0)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_CONFIGURE, ret, "Joining sampler thread");
+
+    /* Reset stop eventfd */
+    if (read(sampler->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_CONFIGURE, errno, "Resetting stop eventfd");
+
+    sampler->running = false;
+
+    /* Report sampler thread failure */
+    if ((ret = __atomic_load_n(&sampler->code, __ATOMIC_ACQUIRE)) < 0)
+        return _gpio_sampler_error(sampler, ret, __atomic_load_n(&sampler->c_errno, __ATOMIC_RELAXED), "Sampling GPIO lines");
+
+    return 0;
+}
+
+int gpio_sampler_dequeue(gpio_sampler_t *sampler, gpio_sample_t *samples, size_t max) {
+    size_t count;
+    int code;
+
+    if (sampler->lines == NULL)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: sampler not open");
+
+    if ((count = _gpio_sample_ring_pop(&sampler->samples, samples, max)) > 0)
+        return count;
+
+    /* Report sampler thread failure once ring is drained */
+    if ((code = __atomic_load_n(&sampler->code, __ATOMIC_ACQUIRE)) < 0)
+        return _gpio_sampler_error(sampler, code, __atomic_load_n(&sampler->c_errno, __ATOMIC_RELAXED), "Sampling GPIO lines");
+
+    return 0;
+}
+
+int gpio_sampler_read_events(gpio_sampler_t *sampler, gpio_event_t *events, size_t max) {
+    if (sampler->lines == NULL)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: sampler not open");
+    else if (sampler->filter_samples == 0)
+        return _gpio_sampler_error(sampler, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: sampler filter disabled");
+
+    return _gpio_event_ring_pop(&sampler->events, events, max);
+}
+
+int gpio_sampler_get_stats(gpio_sampler_t *sampler, gpio_sampler_stats_t *stats) {
+    stats->samples = __atomic_load_n(&sampler->stats.samples, __ATOMIC_RELAXED);
+    stats->samples_dropped = __atomic_load_n(&sampler->stats.samples_dropped, __ATOMIC_RELAXED);
+    stats->events = __atomic_load_n(&sampler->stats.events, __ATOMIC_RELAXED);
+    stats->events_dropped = __atomic_load_n(&sampler->stats.events_dropped, __ATOMIC_RELAXED);
+    stats->missed = __atomic_load_n(&sampler->stats.missed, __ATOMIC_RELAXED);
+    stats->jitter_min_ns = __atomic_load_n(&sampler->stats.jitter_min_ns, __ATOMIC_RELAXED);
+    stats->jitter_max_ns = __atomic_load_n(&sampler->stats.jitter_max_ns, __ATOMIC_RELAXED);
+    __atomic_load(&sampler->stats.jitter_mean_ns, &stats->jitter_mean_ns, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+int gpio_sampler_close(gpio_sampler_t *sampler) {
+    int ret;
+
+    if ((ret = gpio_sampler_stop(sampler)) < 0)
+        return ret;
+
+    free(sampler->samples.samples);
+    sampler->samples.samples = NULL;
+    free(sampler->events.events);
+    sampler->events.events = NULL;
+    sampler->lines = NULL;
+
+    if (sampler->stop_fd >= 0) {
+        if (close(sampler->stop_fd) < 0)
+            return _gpio_sampler_error(sampler, GPIO_ERROR_CLOSE, errno, "Closing stop eventfd");
+
+        sampler->stop_fd = -1;
+    }
+
+    return 0;
+}
+
+bool gpio_sampler_running(gpio_sampler_t *sampler) {
+    return sampler->running;
+}
+
+int gpio_sampler_tostring(gpio_sampler_t *sampler, char *str, size_t len) {
+    return snprintf(str, len, "GPIO Sampler (lines=%zu, period_ns=%" PRIu64 ", pacing=%s, ring_size=%zu, filter_samples=%u, running=%s)",
+                    sampler->lines ? gpio_lines_count(sampler->lines) : 0, sampler->period_ns,
+                    (sampler->pacing == GPIO_SAMPLER_PACING_TIMERFD) ? "timerfd" : "oneshot",
+                    sampler->ring_size, sampler->filter_samples, sampler->running ? "true" : "false");
+}
+
+int gpio_sampler_errno(gpio_sampler_t *sampler) {
+    return sampler->error.c_errno;
+}
+
+const char *gpio_sampler_errmsg(gpio_sampler_t *sampler) {
+    return sampler->error.errmsg;
+}
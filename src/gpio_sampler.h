@@ -0,0 +1,80 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_SAMPLER_H
+#define _PERIPHERY_GPIO_SAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio.h"
+
+/* Maximum number of samples of the majority filter */
+#define GPIO_SAMPLER_FILTER_MAX     63
+
+typedef enum gpio_sampler_pacing {
+    GPIO_SAMPLER_PACING_TIMERFD,    /* Periodic timerfd */
+    GPIO_SAMPLER_PACING_ONESHOT,    /* One-shot absolute timerfd per deadline */
+} gpio_sampler_pacing_t;
+
+/* Configuration structure for gpio_sampler_open() */
+typedef struct gpio_sampler_config {
+    uint64_t period_ns;             /* Sampling period */
+    gpio_sampler_pacing_t pacing;
+    size_t ring_size;               /* Sample and event ring size */
+    unsigned int filter_samples;    /* Majority filter samples, odd, can be 0 to disable filter */
+} gpio_sampler_config_t;
+
+/* Sample structure for gpio_sampler_dequeue() */
+typedef struct gpio_sample {
+    uint64_t timestamp;     /* CLOCK_MONOTONIC timestamp in ns */
+    uint64_t bits;          /* Line values, bit i is line index i */
+} gpio_sample_t;
+
+/* Sampler statistics structure for gpio_sampler_get_stats() */
+typedef struct gpio_sampler_stats {
+    uint64_t samples;           /* Samples taken */
+    uint64_t samples_dropped;   /* Samples lost to a full sample ring */
+    uint64_t events;            /* Filtered edge events emitted */
+    uint64_t events_dropped;    /* Events lost to a full event ring */
+    uint64_t missed;            /* Sampling ticks missed */
+    uint64_t jitter_min_ns;     /* Minimum wakeup latency */
+    uint64_t jitter_max_ns;     /* Maximum wakeup latency */
+    double jitter_mean_ns;      /* Mean wakeup latency */
+} gpio_sampler_stats_t;
+
+typedef struct gpio_sampler_handle gpio_sampler_t;
+
+/* Primary Functions */
+gpio_sampler_t *gpio_sampler_new(void);
+int gpio_sampler_open(gpio_sampler_t *sampler, gpio_lines_t *lines, const gpio_sampler_config_t *config);
+int gpio_sampler_start(gpio_sampler_t *sampler);
+int gpio_sampler_stop(gpio_sampler_t *sampler);
+int gpio_sampler_dequeue(gpio_sampler_t *sampler, gpio_sample_t *samples, size_t max);
+int gpio_sampler_read_events(gpio_sampler_t *sampler, gpio_event_t *events, size_t max);
+int gpio_sampler_get_stats(gpio_sampler_t *sampler, gpio_sampler_stats_t *stats);
+int gpio_sampler_close(gpio_sampler_t *sampler);
+void gpio_sampler_free(gpio_sampler_t *sampler);
+
+/* Miscellaneous */
+bool gpio_sampler_running(gpio_sampler_t *sampler);
+int gpio_sampler_tostring(gpio_sampler_t *sampler, char *str, size_t len);
+
+/* Error Handling */
+int gpio_sampler_errno(gpio_sampler_t *sampler);
+const char *gpio_sampler_errmsg(gpio_sampler_t *sampler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
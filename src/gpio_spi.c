@@ -0,0 +1,438 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "gpio_spi.h"
+#include "gpio_internal.h"
+
+/* Signal index of line offsets and MMIO lines */
+enum {
+    GPIO_SPI_SCLK,
+    GPIO_SPI_MOSI,
+    GPIO_SPI_MISO,
+    GPIO_SPI_CS,
+};
+
+struct gpio_spi_handle {
+    /* SCLK and MOSI share a request, so a clock edge and a data change cost a
+     * single ioctl */
+    gpio_lines_t *lines_out;
+    gpio_lines_t *lines_in;     /* NULL without MISO */
+    gpio_lines_t *lines_cs;     /* NULL without CS */
+    unsigned int lines[4];
+    unsigned int mode;
+    uint32_t max_speed;
+    spi_bit_order_t bit_order;
+    bool cs_high;
+
+    /* direct MMIO access, if configured */
+    bool mmio;
+    struct gpio_mmio_line mmio_lines[4];
+
+    /* transfer state */
+    uint64_t half_period_ns;
+    uint64_t last_edge;
+    bool selected;
+
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_spi_error(gpio_spi_t *spi, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    spi->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(spi->error.errmsg, sizeof(spi->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(spi->error.errmsg+strlen(spi->error.errmsg), sizeof(spi->error.errmsg)-strlen(spi->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static uint64_t _gpio_spi_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/* Busy wait until delay_ns after the previous edge. Time spent in the write
+ * of the previous edge counts towards the delay, so at low clock periods the
+ * wait is free. */
+static void _gpio_spi_delay(gpio_spi_t *spi, uint64_t delay_ns) {
+    uint64_t now;
+
+    if (delay_ns == 0)
+        return;
+
+    /* Edges are not timestamped without a clock period */
+    if (spi->half_period_ns == 0)
+        spi->last_edge = _gpio_spi_now();
+
+    while ((now = _gpio_spi_now()) < spi->last_edge + delay_ns)
+        ;
+
+    spi->last_edge = now;
+}
+
+/* Write SCLK (bit 0) and MOSI (bit 1) */
+static int _gpio_spi_write(gpio_spi_t *spi, uint64_t mask, uint64_t bits) {
+    int ret;
+
+    if (spi->mmio) {
+        if (mask & 0x2)
+            _gpio_mmio_line_set(&spi->mmio_lines[GPIO_SPI_MOSI], bits & 0x2);
+        if (mask & 0x1)
+            _gpio_mmio_line_set(&spi->mmio_lines[GPIO_SPI_SCLK], bits & 0x1);
+        return 0;
+    }
+
+    if ((ret = gpio_lines_write(spi->lines_out, mask, bits)) < 0)
+        return _gpio_spi_error(spi, ret, gpio_lines_errno(spi->lines_out), "Writing GPIO lines");
+
+    return 0;
+}
+
+static int _gpio_spi_read(gpio_spi_t *spi, bool *value) {
+    uint64_t bits;
+    int ret;
+
+    if (spi->mmio) {
+        *value = _gpio_mmio_line_get(&spi->mmio_lines[GPIO_SPI_MISO]);
+        return 0;
+    }
+
+    if ((ret = gpio_lines_read(spi->lines_in, 0x1, &bits)) < 0)
+        return _gpio_spi_error(spi, ret, gpio_lines_errno(spi->lines_in), "Reading GPIO lines");
+
+    *value = bits & 0x1;
+
+    return 0;
+}
+
+static int _gpio_spi_select(gpio_spi_t *spi, bool selected) {
+    bool value = (selected == spi->cs_high);
+    int ret;
+
+    spi->selected = selected;
+
+    if (spi->lines_cs == NULL)
+        return 0;
+
+    if (spi->mmio) {
+        _gpio_mmio_line_set(&spi->mmio_lines[GPIO_SPI_CS], value);
+        return 0;
+    }
+
+    if ((ret = gpio_lines_write(spi->lines_cs, 0x1, value ? 0x1 : 0x0)) < 0)
+        return _gpio_spi_error(spi, ret, gpio_lines_errno(spi->lines_cs), "Writing GPIO chip select line");
+
+    return 0;
+}
+
+static void _gpio_spi_release(gpio_lines_t *lines_out, gpio_lines_t *lines_in, gpio_lines_t *lines_cs) {
+    gpio_lines_t *lines[3] = {lines_out, lines_in, lines_cs};
+
+    for (unsigned int i = 0; i < 3; i++) {
+        if (lines[i]) {
+            gpio_lines_close(lines[i]);
+            gpio_lines_free(lines[i]);
+        }
+    }
+}
+
+gpio_spi_t *gpio_spi_new(void) {
+    return calloc(1, sizeof(gpio_spi_t));
+}
+
+void gpio_spi_free(gpio_spi_t *spi) {
+    free(spi);
+}
+
+int gpio_spi_open(gpio_spi_t *spi, const char *path, unsigned int sclk, unsigned int mosi, unsigned int miso, unsigned int cs, unsigned int mode, uint32_t max_speed) {
+    gpio_spi_config_t config = {
+        .mode = mode,
+        .max_speed = max_speed,
+        .bit_order = MSB_FIRST,
+        .cs_high = false,
+        .mmio = NULL,
+        .label = NULL,
+    };
+
+    return gpio_spi_open_advanced(spi, path, sclk, mosi, miso, cs, &config);
+}
+
+int gpio_spi_open_advanced(gpio_spi_t *spi, const char *path, unsigned int sclk, unsigned int mosi, unsigned int miso, unsigned int cs, const gpio_spi_config_t *config) {
+    gpio_lines_t *lines_out = NULL, *lines_in = NULL, *lines_cs = NULL;
+    struct gpio_mmio_line mmio_lines[4];
+    unsigned int offsets[4] = {sclk, mosi, miso, cs};
+    int ret;
+
+    if (config->mode & ~0x3)
+        return _gpio_spi_error(spi, GPIO_ERROR_ARG, 0, "Invalid mode (can be 0,1,2,3)");
+    else if (config->bit_order != MSB_FIRST && config->bit_order != LSB_FIRST)
+        return _gpio_spi_error(spi, GPIO_ERROR_ARG, 0, "Invalid bit order (can be MSB_FIRST,LSB_FIRST)");
+    else if (sclk == GPIO_SPI_LINE_NONE || mosi == GPIO_SPI_LINE_NONE)
+        return _gpio_spi_error(spi, GPIO_ERROR_ARG, 0, "Invalid lines (SCLK and MOSI are required)");
+
+    for (unsigned int i = 0; i < 4; i++) {
+        for (unsigned int j = i + 1; j < 4; j++) {
+            if (offsets[i] != GPIO_SPI_LINE_NONE && offsets[i] == offsets[j])
+                return _gpio_spi_error(spi, GPIO_ERROR_ARG, 0, "Invalid lines (line %u used twice)", offsets[i]);
+        }
+    }
+
+    /* Check MMIO registers before requesting any lines */
+    if (config->mmio) {
+        for (unsigned int i = 0; i < 4; i++) {
+            if (offsets[i] != GPIO_SPI_LINE_NONE && !_gpio_mmio_line_resolve(config->mmio, offsets[i], &mmio_lines[i]))
+                return _gpio_spi_error(spi, GPIO_ERROR_ARG, 0, "Invalid MMIO registers for line %u (out of bounds or misaligned)", offsets[i]);
+        }
+    }
+
+    gpio_config_t lines_config = {
+        .direction = (config->mode & 0x2) ? GPIO_DIR_OUT_HIGH : GPIO_DIR_OUT_LOW,
+        .edge = GPIO_EDGE_NONE,
+        .event_clock = GPIO_EVENT_CLOCK_MONOTONIC,
+        .debounce_us = 0,
+        .event_buffer_size = 0,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = config->label,
+    };
+
+    /* Request SCLK and MOSI at the clock idle level */
+    if ((lines_out = gpio_lines_new()) == NULL)
+        return _gpio_spi_error(spi, GPIO_ERROR_OPEN, ENOMEM, "Allocating GPIO lines handle");
+
+    if ((ret = gpio_lines_open_advanced(lines_out, path, offsets, 2, &lines_config)) < 0) {
+        _gpio_spi_error(spi, ret, gpio_lines_errno(lines_out), "Opening GPIO lines: %s", gpio_lines_errmsg(lines_out));
+        gpio_lines_free(lines_out);
+        return ret;
+    }
+
+    /* Request MISO */
+    if (miso != GPIO_SPI_LINE_NONE) {
+        lines_config.direction = GPIO_DIR_IN;
+
+        if ((lines_in = gpio_lines_new()) == NULL) {
+            _gpio_spi_release(lines_out, NULL, NULL);
+            return _gpio_spi_error(spi, GPIO_ERROR_OPEN, ENOMEM, "Allocating GPIO lines handle");
+        }
+
+        if ((ret = gpio_lines_open_advanced(lines_in, path, &miso, 1, &lines_config)) < 0) {
+            _gpio_spi_error(spi, ret, gpio_lines_errno(lines_in), "Opening GPIO MISO line: %s", gpio_lines_errmsg(lines_in));
+            gpio_lines_free(lines_in);
+            _gpio_spi_release(lines_out, NULL, NULL);
+            return ret;
+        }
+    }
+
+    /* Request CS deselected, in its own request so it does not glitch when
+     * the clock idles at the active level */
+    if (cs != GPIO_SPI_LINE_NONE) {
+        lines_config.direction = config->cs_high ? GPIO_DIR_OUT_LOW : GPIO_DIR_OUT_HIGH;
+
+        if ((lines_cs = gpio_lines_new()) == NULL) {
+            _gpio_spi_release(lines_out, lines_in, NULL);
+            return _gpio_spi_error(spi, GPIO_ERROR_OPEN, ENOMEM, "Allocating GPIO lines handle");
+        }
+
+        if ((ret = gpio_lines_open_advanced(lines_cs, path, &cs, 1, &lines_config)) < 0) {
+            _gpio_spi_error(spi, ret, gpio_lines_errno(lines_cs), "Opening GPIO chip select line: %s", gpio_lines_errmsg(lines_cs));
+            gpio_lines_free(lines_cs);
+            _gpio_spi_release(lines_out, lines_in, NULL);
+            return ret;
+        }
+    }
+
+    memset(spi, 0, sizeof(gpio_spi_t));
+    spi->lines_out = lines_out;
+    spi->lines_in = lines_in;
+    spi->lines_cs = lines_cs;
+    memcpy(spi->lines, offsets, sizeof(offsets));
+    spi->mode = config->mode;
+    spi->max_speed = config->max_speed;
+    spi->bit_order = config->bit_order;
+    spi->cs_high = config->cs_high;
+    spi->half_period_ns = config->max_speed ? (500000000ULL + config->max_speed - 1) / config->max_speed : 0;
+
+    /* Lines are still claimed through the line requests above, which also
+     * configure their direction, while values go through the registers */
+    if (config->mmio) {
+        spi->mmio = true;
+        memcpy(spi->mmio_lines, mmio_lines, sizeof(mmio_lines));
+    }
+
+    return 0;
+}
+
+static int _gpio_spi_transfer_msg(gpio_spi_t *spi, const spi_msg_t *msg, bool last) {
+    /* The first write of each bit shifts out data, together with the trailing
+     * clock edge of the previous bit for CPHA=0, or the leading clock edge for
+     * CPHA=1. The second write is the sampling clock edge. */
+    uint64_t sclk_shift = (((spi->mode >> 1) ^ spi->mode) & 0x1);
+    uint64_t sclk_sample = sclk_shift ^ 0x1;
+    int ret;
+
+    for (size_t i = 0; i < msg->len; i++) {
+        uint8_t tx = msg->txbuf ? msg->txbuf[i] : 0;
+        uint8_t rx = 0;
+
+        for (unsigned int b = 0; b < 8; b++) {
+            unsigned int shift = (spi->bit_order == MSB_FIRST) ? (7 - b) : b;
+
+            if ((ret = _gpio_spi_write(spi, 0x3, sclk_shift | ((uint64_t)((tx >> shift) & 0x1) << 1))) < 0)
+                return ret;
+
+            _gpio_spi_delay(spi, spi->half_period_ns);
+
+            if ((ret = _gpio_spi_write(spi, 0x1, sclk_sample)) < 0)
+                return ret;
+
+            /* Reading MISO is skipped for transmit only transfers */
+            if (msg->rxbuf) {
+                bool value = false;
+
+                if ((ret = _gpio_spi_read(spi, &value)) < 0)
+                    return ret;
+
+                rx |= (uint8_t)value << shift;
+            }
+
+            if (b == 7 && i < msg->len - 1)
+                _gpio_spi_delay(spi, spi->half_period_ns + (uint64_t)msg->word_delay_us * 1000);
+            else
+                _gpio_spi_delay(spi, spi->half_period_ns);
+        }
+
+        /* Store after shifting out, so txbuf and rxbuf may be the same */
+        if (msg->rxbuf)
+            msg->rxbuf[i] = rx;
+    }
+
+    /* Return the clock to idle for CPHA=0 */
+    if (!(spi->mode & 0x1) && msg->len > 0) {
+        if ((ret = _gpio_spi_write(spi, 0x1, sclk_shift)) < 0)
+            return ret;
+    }
+
+    _gpio_spi_delay(spi, (uint64_t)msg->deselect_delay_us * 1000);
+
+    /* Like spidev, deselect after the last message unless deselect is set,
+     * and between messages only if deselect is set */
+    if (last ? !msg->deselect : msg->deselect) {
+        _gpio_spi_delay(spi, spi->half_period_ns);
+
+        if ((ret = _gpio_spi_select(spi, false)) < 0)
+            return ret;
+
+        _gpio_spi_delay(spi, spi->half_period_ns);
+    }
+
+    return 0;
+}
+
+int gpio_spi_transfer(gpio_spi_t *spi, const uint8_t *txbuf, uint8_t *rxbuf, size_t len) {
+    spi_msg_t msg = {
+        .txbuf = txbuf,
+        .rxbuf = rxbuf,
+        .len = len,
+        .deselect = false,
+        .deselect_delay_us = 0,
+        .word_delay_us = 0,
+    };
+
+    return gpio_spi_transfer_advanced(spi, &msg, 1);
+}
+
+int gpio_spi_transfer_advanced(gpio_spi_t *spi, const spi_msg_t *msgs, size_t count) {
+    int ret;
+
+    if (spi->lines_out == NULL)
+        return _gpio_spi_error(spi, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: SPI not open");
+
+    for (size_t i = 0; i < count; i++) {
+        if (msgs[i].rxbuf && spi->lines_in == NULL)
+            return _gpio_spi_error(spi, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: no MISO line to receive message %zu", i);
+    }
+
+    spi->last_edge = _gpio_spi_now();
+
+    for (size_t i = 0; i < count; i++) {
+        if (!spi->selected) {
+            if ((ret = _gpio_spi_select(spi, true)) < 0)
+                return ret;
+
+            _gpio_spi_delay(spi, spi->half_period_ns);
+        }
+
+        if ((ret = _gpio_spi_transfer_msg(spi, &msgs[i], i == count - 1)) < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+int gpio_spi_close(gpio_spi_t *spi) {
+    gpio_lines_t *lines[3] = {spi->lines_out, spi->lines_in, spi->lines_cs};
+    int ret;
+
+    if (spi->lines_out == NULL)
+        return 0;
+
+    for (unsigned int i = 0; i < 3; i++) {
+        if (lines[i] && (ret = gpio_lines_close(lines[i])) < 0)
+            return _gpio_spi_error(spi, ret, gpio_lines_errno(lines[i]), "Closing GPIO lines");
+    }
+
+    for (unsigned int i = 0; i < 3; i++)
+        gpio_lines_free(lines[i]);
+
+    spi->lines_out = NULL;
+    spi->lines_in = NULL;
+    spi->lines_cs = NULL;
+
+    return 0;
+}
+
+int gpio_spi_tostring(gpio_spi_t *spi, char *str, size_t len) {
+    if (spi->lines_out == NULL)
+        return snprintf(str, len, "GPIO SPI (closed)");
+
+    return snprintf(str, len, "GPIO SPI (sclk=%u, mosi=%u, miso=%d, cs=%d, mode=%u, max_speed=%u, bit_order=%s, cs_high=%s, mmio=%s)",
+                    spi->lines[GPIO_SPI_SCLK], spi->lines[GPIO_SPI_MOSI],
+                    spi->lines_in ? (int)spi->lines[GPIO_SPI_MISO] : -1,
+                    spi->lines_cs ? (int)spi->lines[GPIO_SPI_CS] : -1,
+                    spi->mode, spi->max_speed, (spi->bit_order == MSB_FIRST) ? "MSB first" : "LSB first",
+                    spi->cs_high ? "true" : "false", spi->mmio ? "true" : "false");
+}
+
+int gpio_spi_errno(gpio_spi_t *spi) {
+    return spi->error.c_errno;
+}
+
+const char *gpio_spi_errmsg(gpio_spi_t *spi) {
+    return spi->error.errmsg;
+}
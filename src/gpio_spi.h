@@ -0,0 +1,58 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_SPI_H
+#define _PERIPHERY_GPIO_SPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include "gpio.h"
+#include "spi.h"
+
+/* Unused MISO or CS line */
+#define GPIO_SPI_LINE_NONE  UINT_MAX
+
+/* Configuration structure for gpio_spi_open_advanced() */
+typedef struct gpio_spi_config {
+    unsigned int mode;              /* SPI mode 0 to 3 */
+    uint32_t max_speed;             /* Clock frequency in Hz, can be 0 for as fast as possible */
+    spi_bit_order_t bit_order;
+    bool cs_high;                   /* Active high chip select */
+    const gpio_mmio_regs_t *mmio;   /* Direct MMIO registers, can be NULL to use the line requests */
+    const char *label;              /* Can be NULL for default consumer label */
+} gpio_spi_config_t;
+
+typedef struct gpio_spi_handle gpio_spi_t;
+
+/* Primary Functions */
+gpio_spi_t *gpio_spi_new(void);
+int gpio_spi_open(gpio_spi_t *spi, const char *path, unsigned int sclk, unsigned int mosi, unsigned int miso, unsigned int cs, unsigned int mode, uint32_t max_speed);
+int gpio_spi_open_advanced(gpio_spi_t *spi, const char *path, unsigned int sclk, unsigned int mosi, unsigned int miso, unsigned int cs, const gpio_spi_config_t *config);
+int gpio_spi_transfer(gpio_spi_t *spi, const uint8_t *txbuf, uint8_t *rxbuf, size_t len);
+int gpio_spi_transfer_advanced(gpio_spi_t *spi, const spi_msg_t *msgs, size_t count);
+int gpio_spi_close(gpio_spi_t *spi);
+void gpio_spi_free(gpio_spi_t *spi);
+
+/* Miscellaneous */
+int gpio_spi_tostring(gpio_spi_t *spi, char *str, size_t len);
+
+/* Error Handling */
+int gpio_spi_errno(gpio_spi_t *spi);
+const char *gpio_spi_errmsg(gpio_spi_t *spi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
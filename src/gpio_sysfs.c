@@ -4,16 +4,18 @@
  * License: MIT
  */
 
-#define _XOPEN_SOURCE   600 /* for usleep() */
+#define _XOPEN_SOURCE   600 /* for pread(), pwrite(), clock_gettime() */
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <sys/stat.h>
+#include <sys/inotify.h>
 #include <errno.h>
 
 #include "gpio.h"
@@ -23,12 +25,54 @@
 /* sysfs implementation */
 /*********************************************************************************/
 
+#if !PERIPHERY_GPIO_CDEV_ONLY
+
 #define P_PATH_MAX  256
 
-/* Delay between checks for successful GPIO export (100ms) */
-#define GPIO_SYSFS_OPEN_DELAY      100000
-/* Number of retries to check for successful GPIO exports */
-#define GPIO_SYSFS_OPEN_RETRIES    10
+/* Timeout for exported GPIOs to become ready, restarted whenever one of
+ * the GPIOs being waited on becomes ready (1s) */
+#define GPIO_SYSFS_OPEN_TIMEOUT    1000
+/* Interval to recheck exported GPIOs without an inotify event, as sysfs
+ * does not report entries created by the kernel (10ms) */
+#define GPIO_SYSFS_OPEN_RECHECK    10
+
+static int _gpio_sysfs_attr_open(unsigned int line, const char *attr) {
+    char gpio_path[P_PATH_MAX];
+    int fd;
+
+    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/%s", line, attr);
+
+    /* Fall back to read-only for attributes we may only query */
+    if ((fd = open(gpio_path, O_RDWR)) < 0 && errno == EACCES)
+        fd = open(gpio_path, O_RDONLY);
+
+    return fd;
+}
+
+static int _gpio_sysfs_attr_read(int fd, char *buf, size_t len) {
+    ssize_t ret;
+
+    if (fd < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    if ((ret = pread(fd, buf, len - 1, 0)) < 0)
+        return -1;
+
+    buf[ret] = '\0';
+
+    return 0;
+}
+
+static int _gpio_sysfs_attr_write(int fd, const char *buf) {
+    if (fd < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    return pwrite(fd, buf, strlen(buf), 0) < 0 ? -1 : 0;
+}
 
 static int gpio_sysfs_close(gpio_t *gpio) {
     char buf[16];
@@ -37,6 +81,22 @@ static int gpio_sysfs_close(gpio_t *gpio) {
     if (gpio->u.sysfs.line_fd < 0)
         return 0;
 
+    /* Close attribute fds */
+    if (gpio->u.sysfs.direction_fd >= 0 && close(gpio->u.sysfs.direction_fd) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO 'direction'");
+
+    gpio->u.sysfs.direction_fd = -1;
+
+    if (gpio->u.sysfs.edge_fd >= 0 && close(gpio->u.sysfs.edge_fd) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO 'edge'");
+
+    gpio->u.sysfs.edge_fd = -1;
+
+    if (gpio->u.sysfs.active_low_fd >= 0 && close(gpio->u.sysfs.active_low_fd) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO 'active_low'");
+
+    gpio->u.sysfs.active_low_fd = -1;
+
     /* Close fd */
     if (close(gpio->u.sysfs.line_fd) < 0)
         return _gpio_error(gpio, GPIO_ERROR_CLOSE, errno, "Closing GPIO 'value'");
@@ -68,14 +128,10 @@ static int gpio_sysfs_close(gpio_t *gpio) {
 static int gpio_sysfs_read(gpio_t *gpio, bool *value) {
     char buf[2];
 
-    /* Read fd */
-    if (read(gpio->u.sysfs.line_fd, buf, 2) < 0)
+    /* Read value at offset 0, without rewinding */
+    if (pread(gpio->u.sysfs.line_fd, buf, 2, 0) < 0)
         return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Reading GPIO 'value'");
 
-    /* Rewind */
-    if (lseek(gpio->u.sysfs.line_fd, 0, SEEK_SET) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Rewinding GPIO 'value'");
-
     if (buf[0] == '0')
         *value = false;
     else if (buf[0] == '1')
@@ -89,14 +145,10 @@ static int gpio_sysfs_read(gpio_t *gpio, bool *value) {
 static int gpio_sysfs_write(gpio_t *gpio, bool value) {
     static const char *value_str[2] = {"0\n", "1\n"};
 
-    /* Write fd */
-    if (write(gpio->u.sysfs.line_fd, value_str[value], 2) < 0)
+    /* Write value at offset 0, without rewinding */
+    if (pwrite(gpio->u.sysfs.line_fd, value_str[value], 2, 0) < 0)
         return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Writing GPIO 'value'");
 
-    /* Rewind */
-    if (lseek(gpio->u.sysfs.line_fd, 0, SEEK_SET) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Rewinding GPIO 'value'");
-
     return 0;
 }
 
@@ -106,6 +158,24 @@ static int gpio_sysfs_read_event(gpio_t *gpio, gpio_edge_t *edge, uint64_t *time
     return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support read event");
 }
 
+static int gpio_sysfs_read_events(gpio_t *gpio, gpio_event_t *events, size_t max, int timeout_ms) {
+    (void)events;
+    (void)max;
+    (void)timeout_ms;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support read events");
+}
+
+static int gpio_sysfs_get_event_stats(gpio_t *gpio, gpio_event_stats_t *stats) {
+    (void)stats;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support event statistics");
+}
+
+static int gpio_sysfs_read_line_info_event(gpio_t *gpio, gpio_line_info_event_t *event, int timeout_ms) {
+    (void)event;
+    (void)timeout_ms;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support line info events");
+}
+
 static int gpio_sysfs_poll(gpio_t *gpio, int timeout_ms) {
     struct pollfd fds[1];
     int ret;
@@ -117,22 +187,15 @@ static int gpio_sysfs_poll(gpio_t *gpio, int timeout_ms) {
         return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Polling GPIO 'value'");
 
     /* GPIO edge interrupt occurred */
-    if (ret) {
-        /* Rewind */
-        if (lseek(gpio->u.sysfs.line_fd, 0, SEEK_SET) < 0)
-            return _gpio_error(gpio, GPIO_ERROR_IO, errno, "Rewinding GPIO 'value'");
-
+    if (ret)
         return 1;
-    }
 
     /* Timed out */
     return 0;
 }
 
 static int gpio_sysfs_set_direction(gpio_t *gpio, gpio_direction_t direction) {
-    char gpio_path[P_PATH_MAX];
     const char *buf;
-    int fd;
 
     if (direction == GPIO_DIR_IN)
         buf = "in\n";
@@ -145,45 +208,38 @@ static int gpio_sysfs_set_direction(gpio_t *gpio, gpio_direction_t direction) {
     else
         return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
 
-    /* Write direction */
-    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/direction", gpio->u.sysfs.line);
-
-    if ((fd = open(gpio_path, O_WRONLY)) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Opening GPIO 'direction'");
+    /* The direction attribute is absent for a line with a fixed direction,
+     * which is an input if it has the edge attribute */
+    if (gpio->u.sysfs.direction_fd < 0) {
+        if (direction == GPIO_DIR_IN && gpio->u.sysfs.edge_fd >= 0)
+            return 0;
 
-    if (write(fd, buf, strlen(buf)) < 0) {
-        int errsv = errno;
-        close(fd);
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errsv, "Writing GPIO 'direction'");
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO has a fixed direction (no 'direction' attribute)");
     }
 
-    if (close(fd) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Closing GPIO 'direction'");
+    /* Write direction */
+    if (_gpio_sysfs_attr_write(gpio->u.sysfs.direction_fd, buf) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Writing GPIO 'direction'");
 
     return 0;
 }
 
 static int gpio_sysfs_get_direction(gpio_t *gpio, gpio_direction_t *direction) {
-    char gpio_path[P_PATH_MAX];
     char buf[8];
-    int fd, ret;
 
-    /* Read direction */
-    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/direction", gpio->u.sysfs.line);
+    /* A line with a fixed direction is an input if it has the edge
+     * attribute, otherwise its direction is unknown */
+    if (gpio->u.sysfs.direction_fd < 0) {
+        if (gpio->u.sysfs.edge_fd < 0)
+            return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO has a fixed, unknown direction (no 'direction' attribute)");
 
-    if ((fd = open(gpio_path, O_RDONLY)) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Opening GPIO 'direction'");
-
-    if ((ret = read(fd, buf, sizeof(buf) - 1)) < 0) {
-        int errsv = errno;
-        close(fd);
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errsv, "Reading GPIO 'direction'");
+        *direction = GPIO_DIR_IN;
+        return 0;
     }
 
-    buf[ret] = '\0';
-
-    if (close(fd) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Closing GPIO 'direction'");
+    /* Read direction */
+    if (_gpio_sysfs_attr_read(gpio->u.sysfs.direction_fd, buf, sizeof(buf)) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Reading GPIO 'direction'");
 
     if (strcmp(buf, "in\n") == 0)
         *direction = GPIO_DIR_IN;
@@ -196,9 +252,7 @@ static int gpio_sysfs_get_direction(gpio_t *gpio, gpio_direction_t *direction) {
 }
 
 static int gpio_sysfs_set_edge(gpio_t *gpio, gpio_edge_t edge) {
-    char gpio_path[P_PATH_MAX];
     const char *buf;
-    int fd;
 
     if (edge == GPIO_EDGE_NONE)
         buf = "none\n";
@@ -212,44 +266,18 @@ static int gpio_sysfs_set_edge(gpio_t *gpio, gpio_edge_t edge) {
         return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO interrupt edge (can be none, rising, falling, both)");
 
     /* Write edge */
-    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/edge", gpio->u.sysfs.line);
-
-    if ((fd = open(gpio_path, O_WRONLY)) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Opening GPIO 'edge'");
-
-    if (write(fd, buf, strlen(buf)) < 0) {
-        int errsv = errno;
-        close(fd);
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errsv, "Writing GPIO 'edge'");
-    }
-
-    if (close(fd) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Closing GPIO 'edge'");
+    if (_gpio_sysfs_attr_write(gpio->u.sysfs.edge_fd, buf) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Writing GPIO 'edge'");
 
     return 0;
 }
 
 static int gpio_sysfs_get_edge(gpio_t *gpio, gpio_edge_t *edge) {
-    char gpio_path[P_PATH_MAX];
     char buf[16];
-    int fd, ret;
 
     /* Read edge */
-    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/edge", gpio->u.sysfs.line);
-
-    if ((fd = open(gpio_path, O_RDONLY)) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Opening GPIO 'edge'");
-
-    if ((ret = read(fd, buf, sizeof(buf) - 1)) < 0) {
-        int errsv = errno;
-        close(fd);
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errsv, "Reading GPIO 'edge'");
-    }
-
-    buf[ret] = '\0';
-
-    if (close(fd) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Closing GPIO 'edge'");
+    if (_gpio_sysfs_attr_read(gpio->u.sysfs.edge_fd, buf, sizeof(buf)) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Reading GPIO 'edge'");
 
     if (strcmp(buf, "none\n") == 0)
         *edge = GPIO_EDGE_NONE;
@@ -306,47 +334,21 @@ static int gpio_sysfs_get_drive(gpio_t *gpio, gpio_drive_t *drive) {
 }
 
 static int gpio_sysfs_set_inverted(gpio_t *gpio, bool inverted) {
-    char gpio_path[P_PATH_MAX];
     static const char *inverted_str[2] = {"0\n", "1\n"};
-    int fd;
 
     /* Write active_low */
-    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/active_low", gpio->u.sysfs.line);
-
-    if ((fd = open(gpio_path, O_WRONLY)) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Opening GPIO 'active_low'");
-
-    if (write(fd, inverted_str[inverted], strlen(inverted_str[inverted])) < 0) {
-        int errsv = errno;
-        close(fd);
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errsv, "Writing GPIO 'active_low'");
-    }
-
-    if (close(fd) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Closing GPIO 'active_low'");
+    if (_gpio_sysfs_attr_write(gpio->u.sysfs.active_low_fd, inverted_str[inverted]) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Writing GPIO 'active_low'");
 
     return 0;
 }
 
 static int gpio_sysfs_get_inverted(gpio_t *gpio, bool *inverted) {
-    char gpio_path[P_PATH_MAX];
     char buf[4];
-    int fd, ret;
 
     /* Read active_low */
-    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/active_low", gpio->u.sysfs.line);
-
-    if ((fd = open(gpio_path, O_RDONLY)) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Opening GPIO 'active_low'");
-
-    if ((ret = read(fd, buf, sizeof(buf) - 1)) < 0) {
-        int errsv = errno;
-        close(fd);
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errsv, "Reading GPIO 'active_low'");
-    }
-
-    if (close(fd) < 0)
-        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Closing GPIO 'active_low'");
+    if (_gpio_sysfs_attr_read(gpio->u.sysfs.active_low_fd, buf, sizeof(buf)) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_QUERY, errno, "Reading GPIO 'active_low'");
 
     if (buf[0] == '0')
         *inverted = false;
@@ -358,6 +360,41 @@ static int gpio_sysfs_get_inverted(gpio_t *gpio, bool *inverted) {
     return 0;
 }
 
+static int gpio_sysfs_set_config(gpio_t *gpio, const gpio_config_t *config) {
+    int ret;
+
+    if (config->event_clock != GPIO_EVENT_CLOCK_REALTIME)
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support event clock configuration");
+    else if (config->debounce_us != 0)
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support debounce attribute");
+    else if (config->bias != GPIO_BIAS_DEFAULT)
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support line bias attribute");
+    else if (config->drive != GPIO_DRIVE_DEFAULT)
+        return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "GPIO of type sysfs does not support line drive attribute");
+
+    if (config->direction != GPIO_DIR_IN && config->direction != GPIO_DIR_OUT && config->direction != GPIO_DIR_OUT_LOW && config->direction != GPIO_DIR_OUT_HIGH)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
+    else if (config->edge != GPIO_EDGE_NONE && config->edge != GPIO_EDGE_RISING && config->edge != GPIO_EDGE_FALLING && config->edge != GPIO_EDGE_BOTH)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO interrupt edge (can be none, rising, falling, both)");
+    else if (config->direction != GPIO_DIR_IN && config->edge != GPIO_EDGE_NONE)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO edge for output GPIO");
+
+    /* Clear the edge before changing direction, as the kernel refuses to
+     * make a line with an interrupt edge an output. The attributes are
+     * written one at a time, so a failed write leaves the attributes
+     * written before it applied. */
+    if (gpio->u.sysfs.edge_fd >= 0 && (ret = gpio_sysfs_set_edge(gpio, GPIO_EDGE_NONE)) < 0)
+        return ret;
+
+    if ((ret = gpio_sysfs_set_direction(gpio, config->direction)) < 0)
+        return ret;
+
+    if (config->edge != GPIO_EDGE_NONE && (ret = gpio_sysfs_set_edge(gpio, config->edge)) < 0)
+        return ret;
+
+    return gpio_sysfs_set_inverted(gpio, config->inverted);
+}
+
 static unsigned int gpio_sysfs_line(gpio_t *gpio) {
     return gpio->u.sysfs.line;
 }
@@ -495,6 +532,9 @@ const struct gpio_ops gpio_sysfs_ops = {
     .read = gpio_sysfs_read,
     .write = gpio_sysfs_write,
     .read_event = gpio_sysfs_read_event,
+    .read_events = gpio_sysfs_read_events,
+    .get_event_stats = gpio_sysfs_get_event_stats,
+    .read_line_info_event = gpio_sysfs_read_line_info_event,
     .poll = gpio_sysfs_poll,
     .close = gpio_sysfs_close,
     .get_direction = gpio_sysfs_get_direction,
@@ -511,6 +551,7 @@ const struct gpio_ops gpio_sysfs_ops = {
     .set_bias = gpio_sysfs_set_bias,
     .set_drive = gpio_sysfs_set_drive,
     .set_inverted = gpio_sysfs_set_inverted,
+    .set_config = gpio_sysfs_set_config,
     .line = gpio_sysfs_line,
     .fd = gpio_sysfs_fd,
     .name = gpio_sysfs_name,
@@ -521,103 +562,309 @@ const struct gpio_ops gpio_sysfs_ops = {
     .tostring = gpio_sysfs_tostring,
 };
 
-int gpio_open_sysfs(gpio_t *gpio, unsigned int line, gpio_direction_t direction) {
+static uint64_t _gpio_sysfs_now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static int _gpio_sysfs_export(gpio_t *gpio, unsigned int line, bool *exported) {
     char gpio_path[P_PATH_MAX];
     struct stat stat_buf;
     char buf[16];
-    int len, fd, ret;
-    bool exported = false;
+    int len, fd;
 
-    if (direction != GPIO_DIR_IN && direction != GPIO_DIR_OUT && direction != GPIO_DIR_OUT_LOW && direction != GPIO_DIR_OUT_HIGH)
-        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
+    *exported = false;
 
     /* Check if GPIO directory exists */
     snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u", line);
-    if (stat(gpio_path, &stat_buf) < 0) {
-        /* Write line number to export file */
-        len = snprintf(buf, sizeof(buf), "%u\n", line);
+    if (stat(gpio_path, &stat_buf) == 0)
+        return 0;
 
-        if ((fd = open("/sys/class/gpio/export", O_WRONLY)) < 0)
-            return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO: opening 'export'");
+    /* Write line number to export file */
+    len = snprintf(buf, sizeof(buf), "%u\n", line);
 
-        if (write(fd, buf, len) < 0) {
-            int errsv = errno;
-            close(fd);
-            return _gpio_error(gpio, GPIO_ERROR_OPEN, errsv, "Opening GPIO: writing 'export'");
-        }
+    if ((fd = open("/sys/class/gpio/export", O_WRONLY)) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO: opening 'export'");
 
-        if (close(fd) < 0)
-            return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO: closing 'export'");
-
-        /* Wait until GPIO directory appears */
-        unsigned int retry_count;
-        for (retry_count = 0; retry_count < GPIO_SYSFS_OPEN_RETRIES; retry_count++) {
-            int ret = stat(gpio_path, &stat_buf);
-            if (ret == 0) {
-                exported = true;
-                break;
-            } else if (ret < 0 && errno != ENOENT) {
-                return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO: stat 'gpio%u/' after export", line);
-            }
+    if (write(fd, buf, len) < 0) {
+        int errsv = errno;
+        close(fd);
+        return _gpio_error(gpio, GPIO_ERROR_OPEN, errsv, "Opening GPIO: writing 'export'");
+    }
 
-            usleep(GPIO_SYSFS_OPEN_DELAY);
-        }
+    if (close(fd) < 0)
+        return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO: closing 'export'");
 
-        if (retry_count == GPIO_SYSFS_OPEN_RETRIES)
-            return _gpio_error(gpio, GPIO_ERROR_OPEN, 0, "Opening GPIO: waiting for 'gpio%u/' timed out", line);
+    *exported = true;
 
-        /* Write direction, looping in case of EACCES errors due to delayed
-         * udev permission rule application after export */
-        const char *dir = (direction == GPIO_DIR_OUT) ? "out\n" :
-                          (direction == GPIO_DIR_OUT_HIGH) ? "high\n" :
-                          (direction == GPIO_DIR_OUT_LOW) ? "low\n" : "in\n";
+    return 0;
+}
 
-        snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/direction", line);
+static void _gpio_sysfs_unexport(unsigned int line) {
+    char buf[16];
+    int len, fd;
 
-        for (retry_count = 0; retry_count < GPIO_SYSFS_OPEN_RETRIES; retry_count++) {
-            if ((fd = open(gpio_path, O_WRONLY)) >= 0) {
-                if (write(fd, dir, strlen(dir)) < 0) {
-                    int errsv = errno;
-                    close(fd);
-                    return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errsv, "Writing GPIO 'direction'");
-                }
+    len = snprintf(buf, sizeof(buf), "%u\n", line);
 
-                if (close(fd) < 0)
-                    return _gpio_error(gpio, GPIO_ERROR_CONFIGURE, errno, "Closing GPIO 'direction'");
+    if ((fd = open("/sys/class/gpio/unexport", O_WRONLY)) < 0)
+        return;
+
+    if (write(fd, buf, len) < 0) { /* Best effort */ }
+
+    close(fd);
+}
 
-                break;
-            } else if (errno != EACCES) {
-                return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO: opening 'gpio%u/direction'", line);
+/* Returns 1 if the exported GPIO is ready, 0 with errno set to the reason
+ * if it is still pending, or -1 with errno set on error */
+static int _gpio_sysfs_check_ready(int inotify_fd, unsigned int line) {
+    char gpio_path[P_PATH_MAX];
+    struct stat stat_buf;
+    int fd;
+
+    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u", line);
+    if (stat(gpio_path, &stat_buf) < 0)
+        return (errno == ENOENT) ? 0 : -1;
+
+    /* Watch for udev applying permission rules to the direction attribute,
+     * before checking it, so that a change in between is not missed. A
+     * failed watch is left to the periodic recheck. */
+    snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/direction", line);
+    inotify_add_watch(inotify_fd, gpio_path, IN_ATTRIB);
+
+    if ((fd = open(gpio_path, O_WRONLY)) < 0) {
+        if (errno == EACCES)
+            return 0;
+        else if (errno != ENOENT)
+            return -1;
+
+        /* The direction attribute is created along with value, unless the
+         * line has a fixed direction, which is then ready with value */
+        snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/value", line);
+        if (stat(gpio_path, &stat_buf) == 0)
+            return 1;
+
+        errno = ENOENT;
+        return 0;
+    }
+
+    close(fd);
+
+    return 1;
+}
+
+static int _gpio_sysfs_wait_ready(gpio_t **gpios, const unsigned int *lines, bool *pending, size_t count) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[1];
+    uint64_t now, deadline;
+    size_t i, first, remaining = 0;
+    int ret, errsv, reason = 0;
+
+    for (i = 0; i < count; i++) {
+        if (pending[i])
+            remaining++;
+    }
+
+    if (remaining == 0)
+        return 0;
+
+    for (first = 0; !pending[first]; first++);
+
+    if ((fds[0].fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+        return _gpio_error(gpios[first], GPIO_ERROR_OPEN, errno, "Opening GPIO: inotify_init1()");
+
+    fds[0].events = POLLIN;
+
+    /* Watch for the gpioN directories appearing */
+    inotify_add_watch(fds[0].fd, "/sys/class/gpio", IN_CREATE | IN_ONLYDIR);
+
+    deadline = _gpio_sysfs_now_ms() + GPIO_SYSFS_OPEN_TIMEOUT;
+
+    while (true) {
+        bool progress = false;
+
+        first = count;
+
+        for (i = 0; i < count; i++) {
+            if (!pending[i])
+                continue;
+
+            if ((ret = _gpio_sysfs_check_ready(fds[0].fd, lines[i])) < 0) {
+                errsv = errno;
+                close(fds[0].fd);
+                return _gpio_error(gpios[i], GPIO_ERROR_OPEN, errsv, "Opening GPIO: opening 'gpio%u/direction'", lines[i]);
+            } else if (ret > 0) {
+                pending[i] = false;
+                remaining--;
+                progress = true;
+            } else if (first == count) {
+                first = i;
+                reason = errno;
             }
+        }
+
+        if (remaining == 0)
+            break;
 
-            usleep(GPIO_SYSFS_OPEN_DELAY);
+        now = _gpio_sysfs_now_ms();
+        if (progress)
+            deadline = now + GPIO_SYSFS_OPEN_TIMEOUT;
+
+        if (now >= deadline) {
+            close(fds[0].fd);
+            return _gpio_error(gpios[first], GPIO_ERROR_OPEN, reason, "Opening GPIO: waiting for 'gpio%u/direction' timed out", lines[first]);
+        }
+
+        /* Wait for an inotify event or the next recheck */
+        if (poll(fds, 1, (deadline - now < GPIO_SYSFS_OPEN_RECHECK) ? (int)(deadline - now) : GPIO_SYSFS_OPEN_RECHECK) < 0 && errno != EINTR) {
+            errsv = errno;
+            close(fds[0].fd);
+            return _gpio_error(gpios[first], GPIO_ERROR_OPEN, errsv, "Opening GPIO: polling inotify");
         }
 
-        if (retry_count == GPIO_SYSFS_OPEN_RETRIES)
-            return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO: opening 'gpio%u/direction'", line);
+        /* Drain events, readiness is rechecked above */
+        while (read(fds[0].fd, buf, sizeof(buf)) > 0);
     }
 
+    close(fds[0].fd);
+
+    return 0;
+}
+
+static int _gpio_sysfs_open_exported(gpio_t *gpio, unsigned int line, gpio_direction_t direction, bool exported) {
+    static const char *attr_names[3] = {"direction", "edge", "active_low"};
+    char gpio_path[P_PATH_MAX];
+    bool fixed_unknown;
+    int fd, ret;
+    int attr_fds[3];
+    unsigned int i;
+
     /* Open value */
     snprintf(gpio_path, sizeof(gpio_path), "/sys/class/gpio/gpio%u/value", line);
     if ((fd = open(gpio_path, O_RDWR)) < 0)
         return _gpio_error(gpio, GPIO_ERROR_OPEN, errno, "Opening GPIO 'gpio%u/value'", line);
 
+    /* Open attributes once, to access them with pread()/pwrite(). The
+     * direction and edge attributes are absent for lines with a fixed
+     * direction or without an interrupt, respectively. */
+    for (i = 0; i < 3; i++) {
+        if ((attr_fds[i] = _gpio_sysfs_attr_open(line, attr_names[i])) < 0 && (errno != ENOENT || i == 2)) {
+            int errsv = errno;
+            for (unsigned int j = 0; j < i; j++) {
+                if (attr_fds[j] >= 0)
+                    close(attr_fds[j]);
+            }
+            close(fd);
+            return _gpio_error(gpio, GPIO_ERROR_OPEN, errsv, "Opening GPIO 'gpio%u/%s'", line, attr_names[i]);
+        }
+    }
+
     memset(gpio, 0, sizeof(gpio_t));
     gpio->ops = &gpio_sysfs_ops;
     gpio->u.sysfs.line = line;
     gpio->u.sysfs.line_fd = fd;
+    gpio->u.sysfs.direction_fd = attr_fds[0];
+    gpio->u.sysfs.edge_fd = attr_fds[1];
+    gpio->u.sysfs.active_low_fd = attr_fds[2];
     gpio->u.sysfs.exported = exported;
 
-    if (!exported) {
-        ret = gpio_sysfs_set_direction(gpio, direction);
-        if (ret < 0)
-            return ret;
+    /* A line with a fixed, unknown direction is opened as is */
+    fixed_unknown = gpio->u.sysfs.direction_fd < 0 && gpio->u.sysfs.edge_fd < 0;
+
+    if ((!fixed_unknown && (ret = gpio_sysfs_set_direction(gpio, direction)) < 0) || (ret = gpio_sysfs_set_inverted(gpio, false)) < 0) {
+        /* Leave the GPIO closed, but exported, preserving the error */
+        for (i = 0; i < 3; i++) {
+            if (attr_fds[i] >= 0)
+                close(attr_fds[i]);
+        }
+        close(fd);
+        gpio->u.sysfs.line_fd = gpio->u.sysfs.direction_fd = gpio->u.sysfs.edge_fd = gpio->u.sysfs.active_low_fd = -1;
+        return ret;
     }
 
-    ret = gpio_sysfs_set_inverted(gpio, false);
-    if (ret < 0)
+    return 0;
+}
+
+int gpio_open_sysfs(gpio_t *gpio, unsigned int line, gpio_direction_t direction) {
+    bool exported, pending;
+    int ret;
+
+    if (direction != GPIO_DIR_IN && direction != GPIO_DIR_OUT && direction != GPIO_DIR_OUT_LOW && direction != GPIO_DIR_OUT_HIGH)
+        return _gpio_error(gpio, GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
+
+    if ((ret = _gpio_sysfs_export(gpio, line, &exported)) < 0)
+        return ret;
+
+    /* Wait until the GPIO directory appears and udev permission rules have
+     * been applied to the direction attribute after export */
+    pending = exported;
+    if ((ret = _gpio_sysfs_wait_ready(&gpio, &line, &pending, 1)) < 0)
         return ret;
 
+    return _gpio_sysfs_open_exported(gpio, line, direction, exported);
+}
+
+int gpio_open_sysfs_many(gpio_t **gpios, const unsigned int *lines, const gpio_direction_t *directions, size_t count) {
+    bool exported[count ? count : 1];
+    bool pending[count ? count : 1];
+    size_t i, exports = 0, opened = 0;
+    int ret;
+
+    for (i = 0; i < count; i++) {
+        if (directions[i] != GPIO_DIR_IN && directions[i] != GPIO_DIR_OUT && directions[i] != GPIO_DIR_OUT_LOW && directions[i] != GPIO_DIR_OUT_HIGH)
+            return _gpio_error(gpios[i], GPIO_ERROR_ARG, 0, "Invalid GPIO direction (can be in, out, low, high)");
+    }
+
+    /* Export all GPIOs first */
+    for (exports = 0; exports < count; exports++) {
+        if ((ret = _gpio_sysfs_export(gpios[exports], lines[exports], &exported[exports])) < 0)
+            goto fail;
+
+        pending[exports] = exported[exports];
+    }
+
+    /* Wait for all exported GPIOs together */
+    if ((ret = _gpio_sysfs_wait_ready(gpios, lines, pending, count)) < 0)
+        goto fail;
+
+    for (opened = 0; opened < count; opened++) {
+        if ((ret = _gpio_sysfs_open_exported(gpios[opened], lines[opened], directions[opened], exported[opened])) < 0)
+            goto fail;
+    }
+
     return 0;
+
+fail:
+    /* Close the GPIOs opened so far, which unexports them, and unexport the
+     * remaining GPIOs exported here */
+    for (i = 0; i < exports; i++) {
+        if (i < opened)
+            gpio_sysfs_close(gpios[i]);
+        else if (exported[i])
+            _gpio_sysfs_unexport(lines[i]);
+    }
+
+    return ret;
+}
+
+#else
+
+int gpio_open_sysfs(gpio_t *gpio, unsigned int line, gpio_direction_t direction) {
+    (void)line;
+    (void)direction;
+    return _gpio_error(gpio, GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built with character device GPIO backend only.");
+}
+
+int gpio_open_sysfs_many(gpio_t **gpios, const unsigned int *lines, const gpio_direction_t *directions, size_t count) {
+    (void)lines;
+    (void)directions;
+
+    if (count == 0)
+        return 0;
+
+    return _gpio_error(gpios[0], GPIO_ERROR_UNSUPPORTED, 0, "c-periphery library built with character device GPIO backend only.");
 }
 
+#endif
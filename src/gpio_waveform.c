@@ -0,0 +1,482 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#define _GNU_SOURCE /* for pthread_attr_setaffinity_np() */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <errno.h>
+
+#include "gpio_waveform.h"
+
+struct gpio_waveform_table {
+    uint64_t period_ns;
+    size_t count;
+    gpio_waveform_step_t steps[];
+};
+
+struct gpio_waveform_handle {
+    gpio_lines_t *lines;
+    uint64_t lines_mask;
+    int priority;
+    int cpu;
+    uint64_t repeat;
+
+    /* current table is owned by the waveform thread while running, pending
+     * table is exchanged atomically */
+    struct gpio_waveform_table *table;
+    struct gpio_waveform_table *pending;
+
+    bool stop;
+    bool done;
+    bool running;
+    pthread_t thread;
+    int timer_fd;   /* step deadlines, while running */
+    int stop_fd;    /* wakes the thread to stop, while running */
+
+    /* updated by waveform thread */
+    gpio_waveform_stats_t stats;
+    uint64_t late_count;
+    int code;
+    int c_errno;
+
+    /* error state */
+    struct {
+        int c_errno;
+        char errmsg[96];
+    } error;
+};
+
+static int _gpio_waveform_error(gpio_waveform_t *waveform, int code, int c_errno, const char *fmt, ...) {
+    va_list ap;
+
+    waveform->error.c_errno = c_errno;
+
+    va_start(ap, fmt);
+    vsnprintf(waveform->error.errmsg, sizeof(waveform->error.errmsg), fmt, ap);
+    va_end(ap);
+
+    /* Tack on strerror() and errno */
+    if (c_errno) {
+        char buf[64] = {0};
+        strerror_r(c_errno, buf, sizeof(buf));
+        snprintf(waveform->error.errmsg+strlen(waveform->error.errmsg), sizeof(waveform->error.errmsg)-strlen(waveform->error.errmsg), ": %s [errno %d]", buf, c_errno);
+    }
+
+    return code;
+}
+
+static uint64_t _gpio_waveform_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void _gpio_waveform_fail(gpio_waveform_t *waveform, int code, int c_errno) {
+    __atomic_store_n(&waveform->c_errno, c_errno, __ATOMIC_RELAXED);
+    __atomic_store_n(&waveform->code, code, __ATOMIC_RELEASE);
+}
+
+static void _gpio_waveform_account_step(gpio_waveform_t *waveform, uint64_t late_ns) {
+    gpio_waveform_stats_t *stats = &waveform->stats;
+    double mean;
+
+    waveform->late_count++;
+    mean = stats->late_mean_ns + ((double)late_ns - stats->late_mean_ns) / waveform->late_count;
+
+    if (late_ns > stats->late_max_ns)
+        __atomic_store_n(&stats->late_max_ns, late_ns, __ATOMIC_RELAXED);
+    __atomic_store(&stats->late_mean_ns, &mean, __ATOMIC_RELAXED);
+}
+
+/* Sleep until the deadline, unless stopped. Returns 1 when stopped, 0 at the
+ * deadline, or -1 with errno set on error. */
+static int _gpio_waveform_sleep(gpio_waveform_t *waveform, uint64_t deadline) {
+    struct itimerspec its = {{0, 0}, {0, 0}};
+    struct pollfd fds[2];
+    uint64_t expirations;
+    int ret;
+
+    /* Step is already due */
+    if (_gpio_waveform_now() >= deadline)
+        return __atomic_load_n(&waveform->stop, __ATOMIC_ACQUIRE) ? 1 : 0;
+
+    its.it_value.tv_sec = deadline / 1000000000ULL;
+    its.it_value.tv_nsec = deadline % 1000000000ULL;
+    if (timerfd_settime(waveform->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+        return -1;
+
+    fds[0].fd = waveform->timer_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = waveform->stop_fd;
+    fds[1].events = POLLIN;
+
+    while ((ret = poll(fds, 2, -1)) < 0 && errno == EINTR);
+    if (ret < 0)
+        return -1;
+
+    if (fds[1].revents & POLLIN)
+        return 1;
+
+    /* Clear the expiration */
+    if (read(waveform->timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+        return -1;
+
+    return 0;
+}
+
+static void *_gpio_waveform_thread(void *arg) {
+    gpio_waveform_t *waveform = (gpio_waveform_t *)arg;
+    uint64_t deadline = _gpio_waveform_now();
+    uint64_t periods = 0;
+
+    while (!__atomic_load_n(&waveform->stop, __ATOMIC_ACQUIRE)) {
+        struct gpio_waveform_table *table;
+        bool overrun = false;
+        uint64_t now;
+
+        /* Adopt a newly loaded table at the period boundary */
+        if ((table = __atomic_exchange_n(&waveform->pending, NULL, __ATOMIC_ACQ_REL)) != NULL) {
+            free(waveform->table);
+            waveform->table = table;
+        }
+        table = waveform->table;
+
+        for (size_t i = 0; i < table->count; i++) {
+            const gpio_waveform_step_t *step = &table->steps[i];
+            uint64_t late;
+            int ret;
+
+            /* Sleep until the step is due, waking early when stopped */
+            if ((ret = _gpio_waveform_sleep(waveform, deadline)) < 0) {
+                _gpio_waveform_fail(waveform, GPIO_ERROR_IO, errno);
+                goto out;
+            } else if (ret > 0) {
+                goto out;
+            }
+
+            /* Update all lines of the step with a single ioctl */
+            if ((ret = gpio_lines_write(waveform->lines, step->mask, step->value)) < 0) {
+                _gpio_waveform_fail(waveform, ret, gpio_lines_errno(waveform->lines));
+                goto out;
+            }
+
+            now = _gpio_waveform_now();
+            late = (now > deadline) ? now - deadline : 0;
+
+            /* Step was applied after the next step was due */
+            if (late >= step->delay_ns)
+                overrun = true;
+
+            _gpio_waveform_account_step(waveform, late);
+
+            deadline += step->delay_ns;
+        }
+
+        periods++;
+        __atomic_store_n(&waveform->stats.periods, periods, __ATOMIC_RELAXED);
+        if (overrun)
+            __atomic_store_n(&waveform->stats.overruns, waveform->stats.overruns + 1, __ATOMIC_RELAXED);
+
+        if (waveform->repeat && periods == waveform->repeat)
+            break;
+
+        /* Skip whole periods that already passed, rather than playing them
+         * in a burst */
+        now = _gpio_waveform_now();
+        if (now > deadline + table->period_ns) {
+            uint64_t skipped = (now - deadline) / table->period_ns;
+
+            deadline += skipped * table->period_ns;
+            __atomic_store_n(&waveform->stats.skipped, waveform->stats.skipped + skipped, __ATOMIC_RELAXED);
+        }
+    }
+
+out:
+    __atomic_store_n(&waveform->done, true, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+gpio_waveform_t *gpio_waveform_new(void) {
+    gpio_waveform_t *waveform = calloc(1, sizeof(gpio_waveform_t));
+    if (waveform == NULL)
+        return NULL;
+
+    return waveform;
+}
+
+void gpio_waveform_free(gpio_waveform_t *waveform) {
+    free(waveform);
+}
+
+int gpio_waveform_open(gpio_waveform_t *waveform, gpio_lines_t *lines, const gpio_waveform_config_t *config) {
+    size_t count;
+
+    if ((count = gpio_lines_count(lines)) == 0)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid GPIO lines (not open)");
+    else if (config->priority < 0 || config->priority > sched_get_priority_max(SCHED_FIFO))
+        return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid priority (can be 0 to %d)", sched_get_priority_max(SCHED_FIFO));
+    else if (config->cpu < -1 || config->cpu >= CPU_SETSIZE)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid CPU (can be -1 to %d)", CPU_SETSIZE - 1);
+
+    memset(waveform, 0, sizeof(gpio_waveform_t));
+    waveform->lines = lines;
+    waveform->lines_mask = (count == 64) ? UINT64_MAX : (((uint64_t)1 << count) - 1);
+    waveform->priority = config->priority;
+    waveform->cpu = config->cpu;
+    waveform->repeat = config->repeat;
+
+    return 0;
+}
+
+int gpio_waveform_load(gpio_waveform_t *waveform, const gpio_waveform_step_t *steps, size_t count) {
+    struct gpio_waveform_table *table;
+    uint64_t period_ns = 0;
+
+    if (waveform->lines == NULL)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: waveform not open");
+
+    if (count == 0 || count > GPIO_WAVEFORM_STEPS_MAX)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid step count (can be 1 to %d)", GPIO_WAVEFORM_STEPS_MAX);
+
+    for (size_t i = 0; i < count; i++) {
+        if (steps[i].mask & ~waveform->lines_mask)
+            return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid mask of step %zu (lines requested: %zu)", i, gpio_lines_count(waveform->lines));
+
+        period_ns += steps[i].delay_ns;
+    }
+
+    if (period_ns == 0)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid waveform period (total step delay can be at least 1 ns)");
+
+    if ((table = malloc(sizeof(struct gpio_waveform_table) + count * sizeof(gpio_waveform_step_t))) == NULL)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_OPEN, ENOMEM, "Allocating waveform table");
+
+    table->period_ns = period_ns;
+    table->count = count;
+    memcpy(table->steps, steps, count * sizeof(gpio_waveform_step_t));
+
+    /* Publish table for the next period. A previously pending table that was
+     * not adopted yet is replaced. */
+    free(__atomic_exchange_n(&waveform->pending, table, __ATOMIC_ACQ_REL));
+
+    return 0;
+}
+
+int gpio_waveform_load_pwm(gpio_waveform_t *waveform, uint64_t period_ns, const double *duty_cycles, size_t count) {
+    gpio_waveform_step_t steps[GPIO_LINES_MAX + 1];
+    uint64_t high_ns[GPIO_LINES_MAX];
+    uint64_t t = 0;
+    size_t num_steps = 0;
+
+    if (waveform->lines == NULL)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: waveform not open");
+
+    if (count == 0 || count > gpio_lines_count(waveform->lines))
+        return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid channel count (can be 1 to %zu)", gpio_lines_count(waveform->lines));
+    else if (period_ns == 0)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid period (can be at least 1 ns)");
+
+    for (size_t i = 0; i < count; i++) {
+        if (!(duty_cycles[i] >= 0.0 && duty_cycles[i] <= 1.0))
+            return _gpio_waveform_error(waveform, GPIO_ERROR_ARG, 0, "Invalid duty cycle of channel %zu (can be 0.0 to 1.0)", i);
+
+        high_ns[i] = (uint64_t)(duty_cycles[i] * (double)period_ns + 0.5);
+    }
+
+    /* Rising edges of all channels with a non-zero duty cycle at the start of
+     * the period */
+    steps[0].mask = (count == 64) ? UINT64_MAX : (((uint64_t)1 << count) - 1);
+    steps[0].value = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (high_ns[i] > 0)
+            steps[0].value |= (uint64_t)1 << i;
+    }
+    num_steps = 1;
+
+    /* One step per distinct falling edge time, in order, so channels with
+     * coinciding edges are updated by a single ioctl */
+    while (true) {
+        uint64_t next = UINT64_MAX;
+
+        for (size_t i = 0; i < count; i++) {
+            if (high_ns[i] > t && high_ns[i] < period_ns && high_ns[i] < next)
+                next = high_ns[i];
+        }
+
+        if (next == UINT64_MAX)
+            break;
+
+        steps[num_steps - 1].delay_ns = next - t;
+
+        steps[num_steps].mask = 0;
+        steps[num_steps].value = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (high_ns[i] == next)
+                steps[num_steps].mask |= (uint64_t)1 << i;
+        }
+        num_steps++;
+
+        t = next;
+    }
+
+    steps[num_steps - 1].delay_ns = period_ns - t;
+
+    return gpio_waveform_load(waveform, steps, num_steps);
+}
+
+int gpio_waveform_start(gpio_waveform_t *waveform) {
+    pthread_attr_t attr;
+    int ret;
+
+    if (waveform->running)
+        return 0;
+
+    if (waveform->lines == NULL)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: waveform not open");
+    else if (waveform->table == NULL && __atomic_load_n(&waveform->pending, __ATOMIC_ACQUIRE) == NULL)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_INVALID_OPERATION, 0, "Invalid operation: no waveform loaded");
+
+    if ((ret = pthread_attr_init(&attr)) != 0)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, ret, "Initializing thread attributes");
+
+    if (waveform->priority > 0) {
+        struct sched_param param = {.sched_priority = waveform->priority};
+
+        if ((ret = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED)) != 0 ||
+                (ret = pthread_attr_setschedpolicy(&attr, SCHED_FIFO)) != 0 ||
+                (ret = pthread_attr_setschedparam(&attr, &param)) != 0) {
+            pthread_attr_destroy(&attr);
+            return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, ret, "Setting SCHED_FIFO thread attributes");
+        }
+    }
+
+    if (waveform->cpu >= 0) {
+        cpu_set_t cpus;
+
+        CPU_ZERO(&cpus);
+        CPU_SET(waveform->cpu, &cpus);
+
+        if ((ret = pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus)) != 0) {
+            pthread_attr_destroy(&attr);
+            return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, ret, "Setting thread CPU affinity");
+        }
+    }
+
+    if ((waveform->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+        ret = errno;
+        pthread_attr_destroy(&attr);
+        return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, ret, "Creating waveform timerfd");
+    }
+
+    if ((waveform->stop_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        ret = errno;
+        close(waveform->timer_fd);
+        pthread_attr_destroy(&attr);
+        return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, ret, "Creating stop eventfd");
+    }
+
+    waveform->stop = false;
+    waveform->done = false;
+    waveform->code = 0;
+
+    ret = pthread_create(&waveform->thread, &attr, _gpio_waveform_thread, waveform);
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0) {
+        close(waveform->stop_fd);
+        close(waveform->timer_fd);
+        return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, ret, "Creating waveform thread");
+    }
+
+    waveform->running = true;
+
+    return 0;
+}
+
+int gpio_waveform_stop(gpio_waveform_t *waveform) {
+    uint64_t value = 1;
+    int ret;
+
+    if (!waveform->running)
+        return 0;
+
+    /* Wake the thread from its step delay */
+    __atomic_store_n(&waveform->stop, true, __ATOMIC_RELEASE);
+    if (write(waveform->stop_fd, &value, sizeof(value)) < 0)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, errno, "Signaling waveform thread");
+
+    if ((ret = pthread_join(waveform->thread, NULL)) != 0)
+        return _gpio_waveform_error(waveform, GPIO_ERROR_CONFIGURE, ret, "Joining waveform thread");
+
+    close(waveform->stop_fd);
+    close(waveform->timer_fd);
+    waveform->running = false;
+
+    /* Report waveform thread failure */
+    if ((ret = __atomic_load_n(&waveform->code, __ATOMIC_ACQUIRE)) < 0)
+        return _gpio_waveform_error(waveform, ret, __atomic_load_n(&waveform->c_errno, __ATOMIC_RELAXED), "Writing GPIO lines");
+
+    return 0;
+}
+
+int gpio_waveform_get_stats(gpio_waveform_t *waveform, gpio_waveform_stats_t *stats) {
+    stats->periods = __atomic_load_n(&waveform->stats.periods, __ATOMIC_RELAXED);
+    stats->overruns = __atomic_load_n(&waveform->stats.overruns, __ATOMIC_RELAXED);
+    stats->skipped = __atomic_load_n(&waveform->stats.skipped, __ATOMIC_RELAXED);
+    stats->late_max_ns = __atomic_load_n(&waveform->stats.late_max_ns, __ATOMIC_RELAXED);
+    __atomic_load(&waveform->stats.late_mean_ns, &stats->late_mean_ns, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+int gpio_waveform_close(gpio_waveform_t *waveform) {
+    int ret;
+
+    if ((ret = gpio_waveform_stop(waveform)) < 0)
+        return ret;
+
+    free(waveform->table);
+    waveform->table = NULL;
+    free(waveform->pending);
+    waveform->pending = NULL;
+    waveform->lines = NULL;
+
+    return 0;
+}
+
+bool gpio_waveform_running(gpio_waveform_t *waveform) {
+    return waveform->running && !__atomic_load_n(&waveform->done, __ATOMIC_ACQUIRE);
+}
+
+int gpio_waveform_tostring(gpio_waveform_t *waveform, char *str, size_t len) {
+    return snprintf(str, len, "GPIO Waveform (lines=%zu, priority=%d, cpu=%d, repeat=%" PRIu64 ", running=%s)",
+                    waveform->lines ? gpio_lines_count(waveform->lines) : 0, waveform->priority, waveform->cpu,
+                    waveform->repeat, gpio_waveform_running(waveform) ? "true" : "false");
+}
+
+int gpio_waveform_errno(gpio_waveform_t *waveform) {
+    return waveform->error.c_errno;
+}
+
+const char *gpio_waveform_errmsg(gpio_waveform_t *waveform) {
+    return waveform->error.errmsg;
+}
+
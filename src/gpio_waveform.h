@@ -0,0 +1,72 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_GPIO_WAVEFORM_H
+#define _PERIPHERY_GPIO_WAVEFORM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio.h"
+
+/* Maximum number of steps in a waveform table */
+#define GPIO_WAVEFORM_STEPS_MAX     65536
+
+/* Waveform table step */
+typedef struct gpio_waveform_step {
+    uint64_t mask;          /* Lines to update, bit i is line index i */
+    uint64_t value;         /* Line values */
+    uint64_t delay_ns;      /* Delay until next step */
+} gpio_waveform_step_t;
+
+/* Configuration structure for gpio_waveform_open() */
+typedef struct gpio_waveform_config {
+    int priority;           /* SCHED_FIFO priority, can be 0 for default scheduling */
+    int cpu;                /* CPU to pin thread to, can be -1 for no pinning */
+    uint64_t repeat;        /* Number of periods to play, can be 0 for continuous */
+} gpio_waveform_config_t;
+
+/* Waveform statistics structure for gpio_waveform_get_stats() */
+typedef struct gpio_waveform_stats {
+    uint64_t periods;       /* Periods played */
+    uint64_t overruns;      /* Periods with a step applied after the next step was due */
+    uint64_t skipped;       /* Periods skipped to catch up */
+    uint64_t late_max_ns;   /* Maximum step lateness */
+    double late_mean_ns;    /* Mean step lateness */
+} gpio_waveform_stats_t;
+
+typedef struct gpio_waveform_handle gpio_waveform_t;
+
+/* Primary Functions */
+gpio_waveform_t *gpio_waveform_new(void);
+int gpio_waveform_open(gpio_waveform_t *waveform, gpio_lines_t *lines, const gpio_waveform_config_t *config);
+int gpio_waveform_load(gpio_waveform_t *waveform, const gpio_waveform_step_t *steps, size_t count);
+int gpio_waveform_load_pwm(gpio_waveform_t *waveform, uint64_t period_ns, const double *duty_cycles, size_t count);
+int gpio_waveform_start(gpio_waveform_t *waveform);
+int gpio_waveform_stop(gpio_waveform_t *waveform);
+int gpio_waveform_get_stats(gpio_waveform_t *waveform, gpio_waveform_stats_t *stats);
+int gpio_waveform_close(gpio_waveform_t *waveform);
+void gpio_waveform_free(gpio_waveform_t *waveform);
+
+/* Miscellaneous */
+bool gpio_waveform_running(gpio_waveform_t *waveform);
+int gpio_waveform_tostring(gpio_waveform_t *waveform, char *str, size_t len);
+
+/* Error Handling */
+int gpio_waveform_errno(gpio_waveform_t *waveform);
+const char *gpio_waveform_errmsg(gpio_waveform_t *waveform);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -188,6 +188,24 @@ int mmio_write(mmio_t *mmio, uintptr_t offset, const uint8_t *buf, size_t len) {
     return 0;
 }
 
+int mmio_get_inline(mmio_t *mmio, uintptr_t offset, size_t size, mmio_inline_t *inl) {
+    if (!mmio->ptr)
+        return _mmio_error(mmio, MMIO_ERROR_ARG, 0, "MMIO not open");
+
+    if (size > mmio->size || offset > mmio->size - size)
+        return _mmio_error(mmio, MMIO_ERROR_ARG, 0, "Window out of bounds");
+
+    /* Naturally aligned offsets within the window are then aligned for all
+     * access widths, including 64-bit */
+    if ((mmio->base + offset) % 8 != 0)
+        return _mmio_error(mmio, MMIO_ERROR_ARG, 0, "Window not 64-bit aligned");
+
+    inl->ptr = ((volatile uint8_t *)mmio->ptr) + (mmio->base - mmio->aligned_base) + offset;
+    inl->size = size;
+
+    return 0;
+}
+
 int mmio_close(mmio_t *mmio) {
     if (!mmio->ptr)
         return 0;
@@ -23,6 +23,13 @@ enum mmio_error_code {
 
 typedef struct mmio_handle mmio_t;
 
+/* Inline access structure for mmio_get_inline(), a window of the mapping of
+ * a MMIO handle validated for the static inline accessors of mmio_inline.h */
+typedef struct mmio_inline {
+    volatile uint8_t *ptr;      /* Start of window in mapped memory */
+    size_t size;                /* Size of window in bytes */
+} mmio_inline_t;
+
 /* Primary Functions */
 mmio_t *mmio_new(void);
 int mmio_open(mmio_t *mmio, uintptr_t base, size_t size);
@@ -46,6 +53,9 @@ uintptr_t mmio_base(mmio_t *mmio);
 size_t mmio_size(mmio_t *mmio);
 int mmio_tostring(mmio_t *mmio, char *str, size_t len);
 
+/* Inline Access (see mmio_inline.h) */
+int mmio_get_inline(mmio_t *mmio, uintptr_t offset, size_t size, mmio_inline_t *inl);
+
 /* Error Handling */
 int mmio_errno(mmio_t *mmio);
 const char *mmio_errmsg(mmio_t *mmio);
@@ -0,0 +1,61 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#ifndef _PERIPHERY_MMIO_INLINE_H
+#define _PERIPHERY_MMIO_INLINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "mmio.h"
+
+/* Static inline accessors of a mmio_inline_t window from mmio_get_inline().
+ * Each access is a single volatile load or store, without the library call,
+ * the offset adjustment, or the bounds check, which are done once when the
+ * window is validated. The offset is relative to the start of the window and
+ * is not checked: it should be naturally aligned and within the window. */
+
+static inline uint64_t mmio_inline_read64(const mmio_inline_t *inl, uintptr_t offset) {
+    return *(volatile uint64_t *)(inl->ptr + offset);
+}
+
+static inline uint32_t mmio_inline_read32(const mmio_inline_t *inl, uintptr_t offset) {
+    return *(volatile uint32_t *)(inl->ptr + offset);
+}
+
+static inline uint16_t mmio_inline_read16(const mmio_inline_t *inl, uintptr_t offset) {
+    return *(volatile uint16_t *)(inl->ptr + offset);
+}
+
+static inline uint8_t mmio_inline_read8(const mmio_inline_t *inl, uintptr_t offset) {
+    return *(inl->ptr + offset);
+}
+
+static inline void mmio_inline_write64(const mmio_inline_t *inl, uintptr_t offset, uint64_t value) {
+    *(volatile uint64_t *)(inl->ptr + offset) = value;
+}
+
+static inline void mmio_inline_write32(const mmio_inline_t *inl, uintptr_t offset, uint32_t value) {
+    *(volatile uint32_t *)(inl->ptr + offset) = value;
+}
+
+static inline void mmio_inline_write16(const mmio_inline_t *inl, uintptr_t offset, uint16_t value) {
+    *(volatile uint16_t *)(inl->ptr + offset) = value;
+}
+
+static inline void mmio_inline_write8(const mmio_inline_t *inl, uintptr_t offset, uint8_t value) {
+    *(inl->ptr + offset) = value;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
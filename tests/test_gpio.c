@@ -34,6 +34,22 @@ void test_arguments(void) {
 
     /* Free GPIO */
     gpio_free(gpio);
+
+    gpio_lines_t *lines;
+    unsigned int offsets[GPIO_LINES_MAX + 1] = {0};
+
+    /* Allocate GPIO lines */
+    lines = gpio_lines_new();
+    passert(lines != NULL);
+
+    /* Invalid line count */
+    passert(gpio_lines_open(lines, device, offsets, 0, GPIO_DIR_IN) == GPIO_ERROR_ARG);
+    passert(gpio_lines_open(lines, device, offsets, GPIO_LINES_MAX + 1, GPIO_DIR_IN) == GPIO_ERROR_ARG);
+    /* Invalid direction */
+    passert(gpio_lines_open(lines, device, offsets, 1, 5) == GPIO_ERROR_ARG);
+
+    /* Free GPIO lines */
+    gpio_lines_free(lines);
 }
 
 void test_open_config_close(void) {
@@ -81,12 +97,23 @@ void test_open_config_close(void) {
     /* Invalid drive */
     passert(gpio_set_drive(gpio, 5) == GPIO_ERROR_ARG);
 
+    /* Check no line info events pending */
+    gpio_line_info_event_t info_event;
+    passert(gpio_read_line_info_event(gpio, &info_event, 0) == 0);
+
     /* Set direction out, check direction out, check value low */
     passert(gpio_set_direction(gpio, GPIO_DIR_OUT) == 0);
     passert(gpio_get_direction(gpio, &direction) == 0);
     passert(direction == GPIO_DIR_OUT);
     passert(gpio_read(gpio, &value) == 0);
     passert(value == false);
+
+    /* Check line info event of reconfiguration */
+    passert(gpio_read_line_info_event(gpio, &info_event, 1000) == 1);
+    passert(info_event.change == GPIO_LINE_INFO_RECONFIGURED);
+    passert(info_event.line == pin_output);
+    passert(info_event.used == true);
+    passert(strncmp(info_event.consumer, "periphery", sizeof(info_event.consumer)) == 0);
     /* Set direction out low, check direction out, check value low */
     passert(gpio_set_direction(gpio, GPIO_DIR_OUT_LOW) == 0);
     passert(gpio_get_direction(gpio, &direction) == 0);
@@ -192,6 +219,40 @@ void test_open_config_close(void) {
     /* Attempt to set drive on input GPIO */
     passert(gpio_set_drive(gpio, GPIO_DRIVE_OPEN_DRAIN) == GPIO_ERROR_INVALID_OPERATION);
 
+    /* Set multiple attributes with set config */
+    gpio_config_t set_config = {
+        .direction = GPIO_DIR_OUT_HIGH,
+        .edge = GPIO_EDGE_NONE,
+        .event_clock = GPIO_EVENT_CLOCK_REALTIME,
+        .bias = GPIO_BIAS_PULL_UP,
+        .drive = GPIO_DRIVE_OPEN_DRAIN,
+        .inverted = false,
+    };
+    passert(gpio_set_config(gpio, &set_config) == 0);
+    passert(gpio_get_direction(gpio, &direction) == 0);
+    passert(direction == GPIO_DIR_OUT);
+    passert(gpio_get_bias(gpio, &bias) == 0);
+    passert(bias == GPIO_BIAS_PULL_UP);
+    passert(gpio_get_drive(gpio, &drive) == 0);
+    passert(drive == GPIO_DRIVE_OPEN_DRAIN);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == true);
+
+    /* Reconfigure output, check output value is preserved */
+    passert(gpio_set_drive(gpio, GPIO_DRIVE_DEFAULT) == 0);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == true);
+    passert(gpio_set_bias(gpio, GPIO_BIAS_DEFAULT) == 0);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == true);
+
+    /* Invalid set config */
+    set_config.edge = GPIO_EDGE_RISING;
+    passert(gpio_set_config(gpio, &set_config) == GPIO_ERROR_ARG);
+
+    /* Restore input direction */
+    passert(gpio_set_direction(gpio, GPIO_DIR_IN) == 0);
+
     /* Close GPIO */
     passert(gpio_close(gpio) == 0);
 
@@ -232,6 +293,69 @@ void test_open_config_close(void) {
     /* Close GPIO */
     passert(gpio_close(gpio) == 0);
 
+    /* Open shared GPIO chip */
+    gpio_chip_t *chip = gpio_chip_new();
+    passert(chip != NULL);
+    passert(gpio_chip_open(chip, device) == 0);
+    passert(gpio_chip_handle_fd(chip) >= 0);
+    passert(gpio_chip_num_lines(chip) > pin_input && gpio_chip_num_lines(chip) > pin_output);
+
+    /* Open two GPIOs from the chip */
+    gpio_t *gpio2 = gpio_new();
+    passert(gpio2 != NULL);
+    passert(gpio_open_chip(gpio, chip, pin_input, GPIO_DIR_IN) == 0);
+    passert(gpio_open_chip(gpio2, chip, pin_output, GPIO_DIR_OUT) == 0);
+
+    /* Check GPIOs share the chip fd and cached chip info */
+    passert(gpio_chip_fd(gpio) == gpio_chip_handle_fd(chip));
+    passert(gpio_chip_fd(gpio2) == gpio_chip_handle_fd(chip));
+    char chip_label[32];
+    passert(gpio_chip_label(gpio, label, sizeof(label)) == 0);
+    passert(gpio_chip_handle_label(chip, chip_label, sizeof(chip_label)) == 0);
+    passert(strncmp(label, chip_label, sizeof(label)) == 0);
+
+    /* Invalid line */
+    passert(gpio_open_chip(gpio2, chip, gpio_chip_num_lines(chip), GPIO_DIR_IN) == GPIO_ERROR_ARG);
+
+    /* Close chip, check GPIOs remain usable */
+    passert(gpio_chip_close(chip) == 0);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(gpio_write(gpio2, true) == 0);
+
+    /* Open GPIO from closed chip */
+    gpio_t *gpio3 = gpio_new();
+    passert(gpio3 != NULL);
+    passert(gpio_open_chip(gpio3, chip, pin_input, GPIO_DIR_IN) == GPIO_ERROR_INVALID_OPERATION);
+    gpio_free(gpio3);
+
+    /* Look up line by name in the line name index */
+    char name[32];
+    char path[64];
+    unsigned int line;
+    passert(gpio_name(gpio, name, sizeof(name)) == 0);
+    if (name[0] != '\0') {
+        passert(gpio_index_lookup(name, path, sizeof(path), &line) == 0);
+        passert(line == pin_input);
+
+        /* Open GPIO by name without chip path */
+        gpio_t *gpio4 = gpio_new();
+        passert(gpio4 != NULL);
+        passert(gpio_open_name_any(gpio4, name, GPIO_DIR_IN) == 0);
+        passert(gpio_line(gpio4) == line);
+        passert(gpio_close(gpio4) == 0);
+        gpio_free(gpio4);
+    }
+
+    /* Look up non-existent name */
+    passert(gpio_index_lookup("periphery-nonexistent", path, sizeof(path), &line) == GPIO_ERROR_NOT_FOUND);
+    gpio_index_invalidate();
+
+    /* Free chip, then close GPIOs, releasing the chip */
+    gpio_chip_free(chip);
+    passert(gpio_close(gpio) == 0);
+    passert(gpio_close(gpio2) == 0);
+    gpio_free(gpio2);
+
     /* Free GPIO */
     gpio_free(gpio);
 }
@@ -371,6 +495,156 @@ void test_loopback(void) {
     passert(gpio_poll_multiple(gpios, 1, 1000, gpios_ready) == 0);
     passert(gpios_ready[0] == false);
 
+    /* Check batched read events */
+    gpio_event_t events[4];
+    passert(gpio_write(gpio_out, false) == 0);
+    passert(gpio_write(gpio_out, true) == 0);
+    passert(gpio_read_events(gpio_in, events, 4, 1000) == 2);
+    passert(events[0].edge == GPIO_EDGE_FALLING);
+    passert(events[0].line == pin_input);
+    passert(events[1].edge == GPIO_EDGE_RISING);
+    passert(events[1].line == pin_input);
+    passert(events[1].timestamp >= events[0].timestamp);
+
+    /* Check read events timeout */
+    passert(gpio_read_events(gpio_in, events, 4, 0) == 0);
+
+    /* Check event stats */
+    gpio_event_stats_t event_stats;
+    passert(gpio_get_event_stats(gpio_in, &event_stats) == 0);
+    passert(event_stats.events > 0);
+    passert(event_stats.dropped == 0);
+
+    /* Test low latency wait */
+    gpio_wait_stats_t wait_stats;
+    uint32_t spin_us;
+    passert(gpio_set_spin_us(gpio_in, 1000) == 0);
+    passert(gpio_get_spin_us(gpio_in, &spin_us) == 0);
+    passert(spin_us == 1000);
+
+    /* Check wait catches pending edge while spinning */
+    passert(gpio_write(gpio_out, false) == 0);
+    passert(gpio_wait_event(gpio_in, &events[0], 1000) == 1);
+    passert(events[0].edge == GPIO_EDGE_FALLING);
+
+    /* Check wait timeout after spin budget */
+    passert(gpio_wait_event(gpio_in, &events[0], 10) == 0);
+    passert(gpio_wait_event(gpio_in, &events[0], 0) == 0);
+
+    /* Check wait stats */
+    passert(gpio_get_wait_stats(gpio_in, &wait_stats) == 0);
+    passert(wait_stats.spin_wakes == 1);
+    passert(wait_stats.sleep_wakes == 0);
+    passert(wait_stats.timeouts == 2);
+    passert(wait_stats.latency_min_ns == wait_stats.latency_max_ns);
+
+    /* Check wait falls back to poll without a spin budget, and stats reset */
+    passert(gpio_set_spin_us(gpio_in, 0) == 0);
+    passert(gpio_write(gpio_out, true) == 0);
+    passert(gpio_wait_event(gpio_in, &events[0], 1000) == 1);
+    passert(events[0].edge == GPIO_EDGE_RISING);
+    passert(gpio_get_wait_stats(gpio_in, &wait_stats) == 0);
+    passert(wait_stats.spin_wakes == 0);
+    passert(wait_stats.sleep_wakes == 1);
+    passert(wait_stats.timeouts == 0);
+
+    /* Test event set API with one GPIO */
+    gpio_event_set_t *set = gpio_event_set_new();
+    passert(set != NULL);
+    gpio_t *set_gpios[4];
+
+    passert(gpio_event_set_open(set) == 0);
+    passert(gpio_event_set_fd(set) >= 0);
+    passert(gpio_event_set_add(set, gpio_in) == 0);
+    passert(gpio_event_set_count(set) == 1);
+
+    /* Check wait returns drained events of ready GPIO */
+    passert(gpio_write(gpio_out, false) == 0);
+    passert(gpio_write(gpio_out, true) == 0);
+    passert(gpio_event_set_wait(set, set_gpios, events, 4, 1000) == 2);
+    passert(set_gpios[0] == gpio_in && set_gpios[1] == gpio_in);
+    passert(events[0].edge == GPIO_EDGE_FALLING);
+    passert(events[1].edge == GPIO_EDGE_RISING);
+
+    /* Check wait timeout */
+    passert(gpio_event_set_wait(set, set_gpios, events, 4, 100) == 0);
+
+    /* Check GPIO stays in the set across reconfiguration */
+    passert(gpio_set_edge(gpio_in, GPIO_EDGE_RISING) == 0);
+    passert(gpio_write(gpio_out, false) == 0);
+    passert(gpio_write(gpio_out, true) == 0);
+    passert(gpio_event_set_wait(set, set_gpios, events, 4, 1000) == 1);
+    passert(set_gpios[0] == gpio_in);
+    passert(events[0].edge == GPIO_EDGE_RISING);
+    passert(gpio_set_edge(gpio_in, GPIO_EDGE_BOTH) == 0);
+
+    passert(gpio_event_set_remove(set, gpio_in) == 0);
+    passert(gpio_event_set_count(set) == 0);
+    passert(gpio_event_set_close(set) == 0);
+    gpio_event_set_free(set);
+
+    /* Test background reader */
+    gpio_reader_t *reader = gpio_reader_new();
+    passert(reader != NULL);
+    passert(gpio_reader_open(reader, 0) == GPIO_ERROR_ARG);
+    passert(gpio_reader_open(reader, 16) == 0);
+    passert(gpio_reader_add(reader, gpio_in) == 0);
+    passert(gpio_reader_count(reader) == 1);
+    passert(gpio_reader_start(reader) == 0);
+    passert(gpio_reader_running(reader) == true);
+
+    /* Check add while running fails */
+    passert(gpio_reader_add(reader, gpio_out) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Check events are dequeued in order */
+    passert(gpio_write(gpio_out, false) == 0);
+    passert(gpio_write(gpio_out, true) == 0);
+    size_t dequeued = 0;
+    for (int i = 0; i < 1000 && dequeued < 2; i++) {
+        int ret = gpio_reader_dequeue(reader, gpio_in, events + dequeued, 4 - dequeued);
+        passert(ret >= 0);
+        dequeued += ret;
+        usleep(1000);
+    }
+    passert(dequeued == 2);
+    passert(events[0].edge == GPIO_EDGE_FALLING);
+    passert(events[1].edge == GPIO_EDGE_RISING);
+    passert(gpio_reader_dequeue(reader, gpio_in, events, 4) == 0);
+
+    /* Check stats */
+    passert(gpio_reader_get_stats(reader, gpio_in, &event_stats) == 0);
+    passert(event_stats.events == 2);
+    passert(event_stats.dropped == 0);
+
+    passert(gpio_reader_stop(reader) == 0);
+    passert(gpio_reader_running(reader) == false);
+    passert(gpio_reader_close(reader) == 0);
+
+    /* Check ring overflow is reported */
+    passert(gpio_reader_open(reader, 1) == 0);
+    passert(gpio_reader_add(reader, gpio_in) == 0);
+    passert(gpio_reader_start(reader) == 0);
+    passert(gpio_write(gpio_out, false) == 0);
+    usleep(10000);
+    passert(gpio_write(gpio_out, true) == 0);
+    usleep(10000);
+    passert(gpio_write(gpio_out, false) == 0);
+    usleep(10000);
+    passert(gpio_reader_get_stats(reader, gpio_in, &event_stats) == 0);
+    passert(event_stats.events == 1);
+    passert(event_stats.dropped == 2);
+    passert(gpio_reader_dequeue(reader, gpio_in, events, 4) == 1);
+    passert(events[0].edge == GPIO_EDGE_FALLING);
+
+    /* Check reopening a running reader stops and closes it first */
+    passert(gpio_reader_open(reader, 16) == 0);
+    passert(gpio_reader_running(reader) == false);
+    passert(gpio_reader_count(reader) == 0);
+    passert(gpio_reader_add(reader, gpio_in) == 0);
+
+    passert(gpio_reader_close(reader) == 0);
+    gpio_reader_free(reader);
+
     passert(gpio_close(gpio_in) == 0);
     passert(gpio_close(gpio_out) == 0);
 
@@ -393,6 +667,85 @@ void test_loopback(void) {
     passert(gpio_close(gpio_in) == 0);
     passert(gpio_close(gpio_out) == 0);
 
+    /* Open input pin as GPIO and output pin as GPIO lines */
+    gpio_lines_t *lines_out = gpio_lines_new();
+    passert(lines_out != NULL);
+    unsigned int offsets[1] = {pin_output};
+    uint64_t bits;
+
+    passert(gpio_open(gpio_in, device, pin_input, GPIO_DIR_IN) == 0);
+    passert(gpio_lines_open(lines_out, device, offsets, 1, GPIO_DIR_OUT) == 0);
+    passert(gpio_lines_count(lines_out) == 1);
+    passert(gpio_lines_line(lines_out, 0) == pin_output);
+    passert(gpio_lines_fd(lines_out) >= 0);
+    passert(gpio_lines_chip_fd(lines_out) >= 0);
+
+    /* Invalid mask */
+    passert(gpio_lines_write(lines_out, 0x2, 0x2) == GPIO_ERROR_ARG);
+    passert(gpio_lines_read(lines_out, 0x2, &bits) == GPIO_ERROR_ARG);
+
+    /* Drive lines high, check in high */
+    passert(gpio_lines_write(lines_out, 0x1, 0x1) == 0);
+    passert(gpio_lines_read(lines_out, 0x1, &bits) == 0);
+    passert(bits == 0x1);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == true);
+
+    /* Drive lines low, check in low */
+    passert(gpio_lines_write(lines_out, 0x1, 0x0) == 0);
+    passert(gpio_lines_read(lines_out, 0x1, &bits) == 0);
+    passert(bits == 0x0);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == false);
+
+    passert(gpio_close(gpio_in) == 0);
+
+    /* Output GPIO lines cannot read events */
+    gpio_event_t line_events[4];
+    passert(gpio_lines_read_events(lines_out, line_events, 4, 0) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Open input pin as GPIO lines with both edges */
+    gpio_lines_t *lines_in = gpio_lines_new();
+    passert(lines_in != NULL);
+    unsigned int offsets_in[1] = {pin_input};
+    gpio_config_t lines_config = {
+        .direction = GPIO_DIR_IN,
+        .edge = GPIO_EDGE_BOTH,
+        .event_clock = GPIO_EVENT_CLOCK_MONOTONIC,
+        .debounce_us = 0,
+        .bias = GPIO_BIAS_DEFAULT,
+        .drive = GPIO_DRIVE_DEFAULT,
+        .inverted = false,
+        .label = NULL,
+    };
+#if PERIPHERY_GPIO_CDEV_SUPPORT == 1
+    /* Line handles of the v1 ABI carry no edge events */
+    lines_config.event_clock = GPIO_EVENT_CLOCK_REALTIME;
+    passert(gpio_lines_open_advanced(lines_in, device, offsets_in, 1, &lines_config) == GPIO_ERROR_UNSUPPORTED);
+#else
+    passert(gpio_lines_open_advanced(lines_in, device, offsets_in, 1, &lines_config) == 0);
+
+    /* No events pending */
+    passert(gpio_lines_read_events(lines_in, line_events, 4, 0) == 0);
+
+    /* Pulse out, check rising and falling events in order */
+    passert(gpio_lines_write(lines_out, 0x1, 0x1) == 0);
+    passert(gpio_lines_write(lines_out, 0x1, 0x0) == 0);
+    usleep(1000);
+    passert(gpio_lines_read_events(lines_in, line_events, 4, 1000) == 2);
+    passert(line_events[0].edge == GPIO_EDGE_RISING);
+    passert(line_events[1].edge == GPIO_EDGE_FALLING);
+    passert(line_events[0].line == pin_input && line_events[1].line == pin_input);
+    passert(line_events[1].seqno == line_events[0].seqno + 1);
+    passert(line_events[1].timestamp >= line_events[0].timestamp);
+
+    passert(gpio_lines_close(lines_in) == 0);
+#endif
+    gpio_lines_free(lines_in);
+
+    passert(gpio_lines_close(lines_out) == 0);
+    gpio_lines_free(lines_out);
+
     /* Free GPIO */
     gpio_free(gpio_in);
     gpio_free(gpio_out);
@@ -0,0 +1,282 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../src/gpio_capture.h"
+
+const char *device;
+unsigned int pin_input, pin_output;
+
+void test_arguments(void) {
+    gpio_capture_t *capture;
+    gpio_capture_cursor_t cursor = {0};
+    gpio_capture_event_t event;
+    gpio_capture_stats_t stats;
+    struct stat st;
+
+    ptest();
+
+    /* Allocate capture */
+    capture = gpio_capture_new();
+    passert(capture != NULL);
+
+    /* Invalid buffer size */
+    passert(gpio_capture_open(capture, 0, NULL) == GPIO_ERROR_ARG);
+
+    /* Open in memory capture */
+    passert(gpio_capture_open(capture, 4096, NULL) == 0);
+    passert(gpio_capture_count(capture) == 0);
+    passert(gpio_capture_running(capture) == false);
+
+    /* Empty capture */
+    passert(gpio_capture_next(capture, &cursor, &event) == 0);
+    passert(gpio_capture_get_stats(capture, &stats) == 0);
+    passert(stats.events == 0 && stats.dropped == 0 && stats.overflows == 0 && stats.bytes == 0);
+    passert(gpio_capture_export_vcd(capture, "/tmp/test_gpio_capture.vcd") == 0);
+    passert(stat("/tmp/test_gpio_capture.vcd", &st) == 0);
+    passert(st.st_size > 0);
+    unlink("/tmp/test_gpio_capture.vcd");
+
+    /* Start and stop without channels */
+    passert(gpio_capture_start(capture) == 0);
+    passert(gpio_capture_running(capture) == true);
+    passert(gpio_capture_stop(capture) == 0);
+    passert(gpio_capture_running(capture) == false);
+
+    passert(gpio_capture_close(capture) == 0);
+
+    /* Open file backed capture, check file is trimmed on close */
+    passert(gpio_capture_open(capture, 1 << 20, "/tmp/test_gpio_capture.bin") == 0);
+    passert(stat("/tmp/test_gpio_capture.bin", &st) == 0);
+    passert(st.st_size == 1 << 20);
+    passert(gpio_capture_close(capture) == 0);
+    passert(stat("/tmp/test_gpio_capture.bin", &st) == 0);
+    passert(st.st_size == 0);
+    unlink("/tmp/test_gpio_capture.bin");
+
+    /* Free capture */
+    gpio_capture_free(capture);
+}
+
+void test_mock(void) {
+#if !PERIPHERY_GPIO_CDEV_ONLY
+    gpio_config_t config = {0};
+    gpio_capture_t *capture;
+    gpio_capture_stats_t stats;
+    gpio_event_t events[6];
+    gpio_t *gpio;
+    int ret;
+
+    ptest();
+
+    gpio = gpio_new();
+    passert(gpio != NULL);
+    capture = gpio_capture_new();
+    passert(capture != NULL);
+
+    /* Open mock GPIO with an event buffer of 4 events */
+    config.direction = GPIO_DIR_IN;
+    config.edge = GPIO_EDGE_BOTH;
+    config.event_buffer_size = 4;
+    passert(gpio_open_mock_advanced(gpio, 0, &config) == 0);
+
+    passert(gpio_capture_open(capture, 4096, NULL) == 0);
+    passert(gpio_capture_add(capture, gpio, NULL) == 0);
+
+    /* Overflow the event buffer before the capture starts, dropping the
+     * events with line sequence numbers 5 and 6 */
+    for (unsigned int i = 0; i < 6; i++)
+        events[i] = (gpio_event_t){.edge = (i % 2) ? GPIO_EDGE_FALLING : GPIO_EDGE_RISING, .timestamp = 100 + i};
+    passert(gpio_mock_inject_events(gpio, events, 6) == 4);
+
+    passert(gpio_capture_start(capture) == 0);
+    usleep(10000);
+
+    /* Next event has line sequence number 7 */
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_RISING, 200) == 1);
+    usleep(10000);
+
+    passert(gpio_capture_stop(capture) == 0);
+
+    /* Check the sequence number gap is counted as exactly 2 drops */
+    passert(gpio_capture_get_stats(capture, &stats) == 0);
+    passert(stats.events == 5);
+    passert(stats.dropped == 2);
+    passert(stats.overflows == 0);
+
+    passert(gpio_capture_close(capture) == 0);
+    passert(gpio_close(gpio) == 0);
+
+    /* Check edges right before a stop are stored, when the stop is
+     * reported in the same wakeup as them */
+    gpio_t *gpios[2];
+    for (unsigned int i = 0; i < 2; i++) {
+        gpios[i] = gpio_new();
+        passert(gpios[i] != NULL);
+        passert(gpio_open_mock_advanced(gpios[i], i, &config) == 0);
+    }
+
+    unsigned int lost = 0;
+    for (unsigned int iteration = 0; iteration < 100; iteration++) {
+        if ((ret = gpio_capture_open(capture, 4096, NULL)) < 0 ||
+            (ret = gpio_capture_add(capture, gpios[0], NULL)) < 0 ||
+            (ret = gpio_capture_add(capture, gpios[1], NULL)) < 0 ||
+            (ret = gpio_capture_start(capture)) < 0)
+            passert(ret == 0);
+
+        if (gpio_mock_inject_edge(gpios[0], GPIO_EDGE_RISING, 300) != 1 || gpio_mock_inject_edge(gpios[1], GPIO_EDGE_RISING, 301) != 1)
+            passert(false);
+
+        if ((ret = gpio_capture_stop(capture)) < 0 || (ret = gpio_capture_get_stats(capture, &stats)) < 0 || (ret = gpio_capture_close(capture)) < 0)
+            passert(ret == 0);
+
+        lost += 2 - stats.events;
+    }
+    passert(lost == 0);
+
+    for (unsigned int i = 0; i < 2; i++) {
+        passert(gpio_close(gpios[i]) == 0);
+        gpio_free(gpios[i]);
+    }
+
+    gpio_capture_free(capture);
+    gpio_free(gpio);
+#endif
+}
+
+void test_loopback(void) {
+    gpio_t *gpio_in, *gpio_out;
+    gpio_capture_t *capture;
+    gpio_capture_cursor_t cursor = {0};
+    gpio_capture_event_t event;
+    gpio_capture_stats_t stats;
+    uint64_t last_timestamp = 0;
+    struct stat st;
+    unsigned int i;
+    int ret;
+
+    ptest();
+
+    gpio_in = gpio_new();
+    passert(gpio_in != NULL);
+    gpio_out = gpio_new();
+    passert(gpio_out != NULL);
+    capture = gpio_capture_new();
+    passert(capture != NULL);
+
+    passert(gpio_open(gpio_out, device, pin_output, GPIO_DIR_OUT) == 0);
+    passert(gpio_open(gpio_in, device, pin_input, GPIO_DIR_IN) == 0);
+
+    passert(gpio_capture_open(capture, 1 << 20, NULL) == 0);
+
+    /* Check GPIO without both edges is rejected */
+    passert(gpio_capture_add(capture, gpio_in, "in") == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_set_edge(gpio_in, GPIO_EDGE_BOTH) == 0);
+    passert(gpio_capture_add(capture, gpio_in, "in") == 0);
+    passert(gpio_capture_add(capture, gpio_in, "in") == GPIO_ERROR_ARG);
+    passert(gpio_capture_count(capture) == 1);
+
+    passert(gpio_capture_start(capture) == 0);
+
+    /* Check GPIO cannot be added to running capture */
+    passert(gpio_capture_add(capture, gpio_out, NULL) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Generate 100 pulses */
+    for (i = 0; i < 100; i++) {
+        passert(gpio_write(gpio_out, true) == 0);
+        usleep(100);
+        passert(gpio_write(gpio_out, false) == 0);
+        usleep(100);
+    }
+    usleep(10000);
+
+    passert(gpio_capture_stop(capture) == 0);
+
+    passert(gpio_capture_get_stats(capture, &stats) == 0);
+    passert(stats.events == 200);
+    passert(stats.dropped == 0);
+    passert(stats.overflows == 0);
+    passert(stats.bytes > 0 && stats.bytes < 200 * 12);
+
+    /* Decode and check alternating edges in order */
+    for (i = 0; (ret = gpio_capture_next(capture, &cursor, &event)) > 0; i++) {
+        passert(event.channel == 0);
+        passert(event.edge == ((i % 2 == 0) ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING));
+        passert(event.timestamp >= last_timestamp);
+        last_timestamp = event.timestamp;
+    }
+    passert(ret == 0);
+    passert(i == 200);
+
+    /* Export VCD */
+    passert(gpio_capture_export_vcd(capture, "/tmp/test_gpio_capture.vcd") == 0);
+    passert(stat("/tmp/test_gpio_capture.vcd", &st) == 0);
+    passert(st.st_size > 200 * 3);
+    unlink("/tmp/test_gpio_capture.vcd");
+
+    passert(gpio_capture_close(capture) == 0);
+
+    /* Check overflow counts lost edges without blocking */
+    passert(gpio_capture_open(capture, 64, NULL) == 0);
+    passert(gpio_capture_add(capture, gpio_in, NULL) == 0);
+    passert(gpio_capture_start(capture) == 0);
+    for (i = 0; i < 50; i++) {
+        passert(gpio_write(gpio_out, true) == 0);
+        usleep(100);
+        passert(gpio_write(gpio_out, false) == 0);
+        usleep(100);
+    }
+    usleep(10000);
+    passert(gpio_capture_stop(capture) == 0);
+    passert(gpio_capture_get_stats(capture, &stats) == 0);
+    passert(stats.events > 0);
+    passert(stats.overflows > 0);
+    passert(stats.events + stats.overflows == 100);
+    passert(gpio_capture_close(capture) == 0);
+
+    passert(gpio_close(gpio_in) == 0);
+    passert(gpio_close(gpio_out) == 0);
+
+    gpio_capture_free(capture);
+    gpio_free(gpio_in);
+    gpio_free(gpio_out);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2>\n\n", argv[0]);
+        fprintf(stderr, "[1/3] Argument test: No requirements.\n");
+        fprintf(stderr, "[2/3] Mock test: No requirements.\n");
+        fprintf(stderr, "[3/3] Loopback test: GPIOs #1 and #2 should be connected with a wire.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13),\n");
+        fprintf(stderr, "connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 27\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input = strtoul(argv[2], NULL, 10);
+    pin_output = strtoul(argv[3], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_mock();
+    printf(" " STR_OK "  Mock test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
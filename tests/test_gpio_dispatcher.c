@@ -0,0 +1,196 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include <unistd.h>
+
+#include "../src/gpio_dispatcher.h"
+
+const char *device;
+unsigned int pin_input, pin_output;
+
+struct edge_log {
+    gpio_edge_t edges[64];
+    uint32_t line_seqno[64];
+    unsigned int count;
+};
+
+static void log_edge(gpio_t *gpio, const gpio_event_t *event, void *ctx) {
+    struct edge_log *log = (struct edge_log *)ctx;
+
+    (void)gpio;
+
+    if (log->count < 64) {
+        log->edges[log->count] = event->edge;
+        log->line_seqno[log->count] = event->line_seqno;
+    }
+
+    __atomic_add_fetch(&log->count, 1, __ATOMIC_RELEASE);
+}
+
+void test_arguments(void) {
+    gpio_dispatcher_t *dispatcher;
+    gpio_dispatcher_stats_t stats;
+    gpio_t *gpio;
+    char str[128];
+
+    ptest();
+
+    /* Allocate dispatcher and GPIO */
+    dispatcher = gpio_dispatcher_new();
+    passert(dispatcher != NULL);
+    gpio = gpio_new();
+    passert(gpio != NULL);
+
+    /* Invalid workers */
+    gpio_dispatcher_config_t config = {.workers = 0, .queue_size = 64};
+    passert(gpio_dispatcher_open(dispatcher, &config) == GPIO_ERROR_ARG);
+    config.workers = GPIO_DISPATCHER_WORKERS_MAX + 1;
+    passert(gpio_dispatcher_open(dispatcher, &config) == GPIO_ERROR_ARG);
+    /* Invalid queue size */
+    config.workers = 2;
+    config.queue_size = 0;
+    passert(gpio_dispatcher_open(dispatcher, &config) == GPIO_ERROR_ARG);
+
+    /* Unopened dispatcher */
+    passert(gpio_dispatcher_add(dispatcher, gpio, log_edge, NULL) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_dispatcher_start(dispatcher) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Open dispatcher */
+    config.queue_size = 100;
+    passert(gpio_dispatcher_open(dispatcher, &config) == 0);
+    passert(gpio_dispatcher_count(dispatcher) == 0);
+    passert(gpio_dispatcher_running(dispatcher) == false);
+    passert(gpio_dispatcher_tostring(dispatcher, str, sizeof(str)) > 0);
+    passert(strstr(str, "queue_size=128") != NULL);
+
+    /* Missing callback */
+    passert(gpio_dispatcher_add(dispatcher, gpio, NULL, NULL) == GPIO_ERROR_ARG);
+    /* Unknown GPIO */
+    passert(gpio_dispatcher_remove(dispatcher, gpio) == GPIO_ERROR_ARG);
+    passert(gpio_dispatcher_get_stats(dispatcher, gpio, &stats) == GPIO_ERROR_ARG);
+
+    /* Empty statistics */
+    passert(gpio_dispatcher_get_stats(dispatcher, NULL, &stats) == 0);
+    passert(stats.events == 0 && stats.dropped == 0 && stats.dispatched == 0);
+
+    /* Start and stop without GPIOs */
+    passert(gpio_dispatcher_start(dispatcher) == 0);
+    passert(gpio_dispatcher_running(dispatcher) == true);
+    passert(gpio_dispatcher_stop(dispatcher) == 0);
+    passert(gpio_dispatcher_running(dispatcher) == false);
+
+    /* Close and free */
+    passert(gpio_dispatcher_close(dispatcher) == 0);
+    gpio_dispatcher_free(dispatcher);
+    gpio_free(gpio);
+}
+
+void test_loopback(void) {
+    gpio_dispatcher_t *dispatcher;
+    gpio_dispatcher_stats_t stats;
+    gpio_t *gpio_in, *gpio_out;
+    struct edge_log log = {0};
+    unsigned int i;
+
+    ptest();
+
+    /* Allocate dispatcher and GPIOs */
+    dispatcher = gpio_dispatcher_new();
+    passert(dispatcher != NULL);
+    gpio_in = gpio_new();
+    passert(gpio_in != NULL);
+    gpio_out = gpio_new();
+    passert(gpio_out != NULL);
+
+    /* Open GPIOs */
+    passert(gpio_open(gpio_out, device, pin_output, GPIO_DIR_OUT) == 0);
+    passert(gpio_open(gpio_in, device, pin_input, GPIO_DIR_IN) == 0);
+    passert(gpio_set_edge(gpio_in, GPIO_EDGE_BOTH) == 0);
+
+    /* Open dispatcher */
+    gpio_dispatcher_config_t config = {.workers = 2, .queue_size = 64};
+    passert(gpio_dispatcher_open(dispatcher, &config) == 0);
+    passert(gpio_dispatcher_add(dispatcher, gpio_in, log_edge, &log) == 0);
+    passert(gpio_dispatcher_add(dispatcher, gpio_in, log_edge, &log) == GPIO_ERROR_ARG);
+    passert(gpio_dispatcher_count(dispatcher) == 1);
+
+    passert(gpio_dispatcher_start(dispatcher) == 0);
+
+    /* Cannot add or remove while running */
+    passert(gpio_dispatcher_add(dispatcher, gpio_out, log_edge, &log) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_dispatcher_remove(dispatcher, gpio_in) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Toggle output */
+    for (i = 0; i < 16; i++) {
+        passert(gpio_write(gpio_out, (i % 2) == 0) == 0);
+        usleep(1000);
+    }
+
+    /* Stop dispatches queued events */
+    usleep(10000);
+    passert(gpio_dispatcher_stop(dispatcher) == 0);
+
+    /* Check edges were dispatched in order */
+    passert(__atomic_load_n(&log.count, __ATOMIC_ACQUIRE) == 16);
+    for (i = 0; i < 16; i++) {
+        passert(log.edges[i] == (((i % 2) == 0) ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING));
+        if (i > 0)
+            passert(log.line_seqno[i] == log.line_seqno[i - 1] + 1);
+    }
+
+    /* Check statistics */
+    passert(gpio_dispatcher_get_stats(dispatcher, gpio_in, &stats) == 0);
+    printf("events %" PRIu64 ", dropped %" PRIu64 ", dispatched %" PRIu64 ", delay min %" PRIu64 " ns, max %" PRIu64 " ns, mean %.0f ns\n",
+           stats.events, stats.dropped, stats.dispatched, stats.delay_min_ns, stats.delay_max_ns, stats.delay_mean_ns);
+    passert(stats.events == 16);
+    passert(stats.dropped == 0);
+    passert(stats.dispatched == 16);
+    passert(stats.delay_min_ns <= stats.delay_max_ns);
+
+    /* Remove GPIO */
+    passert(gpio_dispatcher_remove(dispatcher, gpio_in) == 0);
+    passert(gpio_dispatcher_count(dispatcher) == 0);
+
+    /* Close and free */
+    passert(gpio_dispatcher_close(dispatcher) == 0);
+    passert(gpio_close(gpio_in) == 0);
+    passert(gpio_close(gpio_out) == 0);
+    gpio_dispatcher_free(dispatcher);
+    gpio_free(gpio_in);
+    gpio_free(gpio_out);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2>\n\n", argv[0]);
+        fprintf(stderr, "[1/2] Arguments test: No requirements.\n");
+        fprintf(stderr, "[2/2] Loopback test: GPIOs #1 and #2 should be connected with a wire.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13),\n");
+        fprintf(stderr, "connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 27\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input = strtoul(argv[2], NULL, 10);
+    pin_output = strtoul(argv[3], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+
+#include "../src/gpio_encoder.h"
+
+const char *device;
+unsigned int pin_input_a, pin_input_b, pin_output_a, pin_output_b;
+
+void test_arguments(void) {
+    gpio_encoder_t *encoder;
+
+    ptest();
+
+    /* Allocate encoder */
+    encoder = gpio_encoder_new();
+    passert(encoder != NULL);
+
+    /* Same line for A and B */
+    passert(gpio_encoder_open(encoder, NULL, 1, 1) == GPIO_ERROR_ARG);
+
+    /* Update without GPIO lines */
+    passert(gpio_encoder_open(encoder, NULL, 0, 1) == 0);
+    passert(gpio_encoder_fd(encoder) == -1);
+    passert(gpio_encoder_update(encoder, 0) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_encoder_close(encoder) == 0);
+
+    /* Free encoder */
+    gpio_encoder_free(encoder);
+}
+
+static void make_event(gpio_event_t *event, unsigned int line, gpio_edge_t edge, uint64_t timestamp, uint32_t seqno) {
+    event->edge = edge;
+    event->timestamp = timestamp;
+    event->line = line;
+    event->seqno = seqno;
+    event->line_seqno = 0;
+}
+
+void test_feed(void) {
+    gpio_encoder_t *encoder;
+    gpio_encoder_stats_t stats;
+    gpio_event_t events[16];
+
+    ptest();
+
+    encoder = gpio_encoder_new();
+    passert(encoder != NULL);
+
+    gpio_encoder_config_t config = {
+        .bias = GPIO_BIAS_DEFAULT,
+        .event_clock = GPIO_EVENT_CLOCK_MONOTONIC,
+        .debounce_us = 0,
+        .inverted = false,
+        .velocity_window_us = 500,
+        .event_buffer_size = 0,
+        .label = NULL,
+    };
+    passert(gpio_encoder_open_advanced(encoder, NULL, 0, 1, &config) == 0);
+
+    /* Two forward cycles, one transition every 100 us: 00 -> 01 -> 11 -> 10 -> 00 */
+    for (unsigned int i = 0; i < 8; i++) {
+        static const unsigned int lines[4] = {1, 0, 1, 0};
+        static const gpio_edge_t edges[4] = {GPIO_EDGE_RISING, GPIO_EDGE_RISING, GPIO_EDGE_FALLING, GPIO_EDGE_FALLING};
+        make_event(&events[i], lines[i % 4], edges[i % 4], 1000000 + i * 100000, i + 1);
+    }
+    passert(gpio_encoder_feed(encoder, events, 8) == 8);
+    passert(gpio_encoder_get_position(encoder) == 8);
+
+    /* 10000 counts per second */
+    passert(gpio_encoder_get_velocity(encoder) > 9999.0 && gpio_encoder_get_velocity(encoder) < 10001.0);
+
+    passert(gpio_encoder_get_stats(encoder, &stats) == 0);
+    passert(stats.transitions == 8);
+    passert(stats.errors == 0);
+    passert(stats.dropped == 0);
+
+    /* One backward cycle: 00 -> 10 -> 11 -> 01 -> 00 */
+    make_event(&events[0], 0, GPIO_EDGE_RISING, 2000000, 9);
+    make_event(&events[1], 1, GPIO_EDGE_RISING, 2100000, 10);
+    make_event(&events[2], 0, GPIO_EDGE_FALLING, 2200000, 11);
+    make_event(&events[3], 1, GPIO_EDGE_FALLING, 2300000, 12);
+    passert(gpio_encoder_feed(encoder, events, 4) == 4);
+    passert(gpio_encoder_get_position(encoder) == 4);
+
+    /* Illegal transition: falling edge of a low line */
+    make_event(&events[0], 0, GPIO_EDGE_FALLING, 2400000, 13);
+    passert(gpio_encoder_feed(encoder, events, 1) == 1);
+    passert(gpio_encoder_get_position(encoder) == 4);
+    passert(gpio_encoder_get_stats(encoder, &stats) == 0);
+    passert(stats.errors == 1);
+
+    /* Dropped events */
+    make_event(&events[0], 1, GPIO_EDGE_RISING, 2500000, 16);
+    passert(gpio_encoder_feed(encoder, events, 1) == 1);
+    passert(gpio_encoder_get_position(encoder) == 5);
+    passert(gpio_encoder_get_stats(encoder, &stats) == 0);
+    passert(stats.dropped == 2);
+
+    /* Events of other lines are ignored */
+    make_event(&events[0], 7, GPIO_EDGE_RISING, 2600000, 0);
+    passert(gpio_encoder_feed(encoder, events, 1) == 1);
+    passert(gpio_encoder_get_position(encoder) == 5);
+
+    /* Set position */
+    gpio_encoder_set_position(encoder, -100);
+    passert(gpio_encoder_get_position(encoder) == -100);
+
+    passert(gpio_encoder_close(encoder) == 0);
+
+    /* Check inverted counting direction */
+    config.inverted = true;
+    passert(gpio_encoder_open_advanced(encoder, NULL, 0, 1, &config) == 0);
+    make_event(&events[0], 1, GPIO_EDGE_RISING, 1000000, 1);
+    make_event(&events[1], 0, GPIO_EDGE_RISING, 1100000, 2);
+    passert(gpio_encoder_feed(encoder, events, 2) == 2);
+    passert(gpio_encoder_get_position(encoder) == -2);
+    passert(gpio_encoder_close(encoder) == 0);
+
+    gpio_encoder_free(encoder);
+}
+
+void test_loopback(void) {
+    gpio_lines_t *lines_out;
+    gpio_encoder_t *encoder;
+    gpio_encoder_stats_t stats;
+    char str[256];
+
+    ptest();
+
+    lines_out = gpio_lines_new();
+    passert(lines_out != NULL);
+    encoder = gpio_encoder_new();
+    passert(encoder != NULL);
+
+    /* Drive A and B low */
+    unsigned int offsets[2] = {pin_output_a, pin_output_b};
+    passert(gpio_lines_open(lines_out, device, offsets, 2, GPIO_DIR_OUT_LOW) == 0);
+    passert(gpio_encoder_open(encoder, device, pin_input_a, pin_input_b) == 0);
+    passert(gpio_encoder_fd(encoder) >= 0);
+
+    passert(gpio_encoder_tostring(encoder, str, sizeof(str)) > 0);
+    printf("Encoder description: %s\n", str);
+
+    /* Step 5 cycles forward, then 2 cycles backward */
+    static const uint64_t forward[4] = {0x2, 0x3, 0x1, 0x0};
+    static const uint64_t backward[4] = {0x1, 0x3, 0x2, 0x0};
+    for (unsigned int i = 0; i < 20; i++) {
+        passert(gpio_lines_write(lines_out, 0x3, forward[i % 4]) == 0);
+        usleep(1000);
+    }
+    for (unsigned int i = 0; i < 8; i++) {
+        passert(gpio_lines_write(lines_out, 0x3, backward[i % 4]) == 0);
+        usleep(1000);
+    }
+
+    /* Process all events */
+    while (gpio_encoder_update(encoder, 100) > 0);
+
+    passert(gpio_encoder_get_position(encoder) == 12);
+    passert(gpio_encoder_get_stats(encoder, &stats) == 0);
+    passert(stats.transitions == 28);
+    passert(stats.errors == 0);
+    passert(stats.dropped == 0);
+
+    /* Velocity is zero once idle */
+    passert(gpio_encoder_update(encoder, 20) == 0);
+    passert(gpio_encoder_get_velocity(encoder) == 0.0);
+
+    passert(gpio_encoder_close(encoder) == 0);
+    passert(gpio_lines_close(lines_out) == 0);
+
+    gpio_encoder_free(encoder);
+    gpio_lines_free(lines_out);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 6) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2> <GPIO #3> <GPIO #4>\n\n", argv[0]);
+        fprintf(stderr, "[1/3] Argument test: No requirements.\n");
+        fprintf(stderr, "[2/3] Feed test: No requirements.\n");
+        fprintf(stderr, "[3/3] Loopback test: GPIOs #1 and #3, and GPIOs #2 and #4, should be connected with a wire.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13), and GPIO 22 (header pin 15) and\n");
+        fprintf(stderr, "GPIO 23 (header pin 16), connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 22 27 23\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input_a = strtoul(argv[2], NULL, 10);
+    pin_input_b = strtoul(argv[3], NULL, 10);
+    pin_output_a = strtoul(argv[4], NULL, 10);
+    pin_output_b = strtoul(argv[5], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_feed();
+    printf(" " STR_OK "  Feed test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+
+#include "../src/gpio_i2c.h"
+
+#define I2C_EEPROM_ADDRESS      0x51
+
+const char *device;
+unsigned int pin_scl, pin_sda;
+
+void test_arguments(void) {
+    gpio_i2c_t *i2c;
+    uint8_t buf[1] = {0};
+    struct i2c_msg msgs[1] = {{.addr = I2C_EEPROM_ADDRESS, .flags = 0, .len = 1, .buf = buf}};
+
+    ptest();
+
+    /* Allocate I2C */
+    i2c = gpio_i2c_new();
+    passert(i2c != NULL);
+
+    /* Same SCL and SDA */
+    passert(gpio_i2c_open(i2c, device, pin_scl, pin_scl) == GPIO_ERROR_ARG);
+
+    /* Unopened I2C */
+    passert(gpio_i2c_transfer(i2c, msgs, 1) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Free I2C */
+    gpio_i2c_free(i2c);
+}
+
+void test_loopback(void) {
+    gpio_i2c_t *i2c;
+    uint8_t vector[32];
+    uint8_t buf[2 + 32];
+    struct i2c_msg msgs[2];
+    char str[256];
+    unsigned int i;
+
+    ptest();
+
+    /* Allocate I2C */
+    i2c = gpio_i2c_new();
+    passert(i2c != NULL);
+
+    passert(gpio_i2c_open(i2c, device, pin_scl, pin_sda) == 0);
+
+    passert(gpio_i2c_tostring(i2c, str, sizeof(str)) > 0);
+    printf("I2C description: %s\n", str);
+
+    /* Invalid message arguments */
+    msgs[0].addr = 0x80;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = buf;
+    passert(gpio_i2c_transfer(i2c, msgs, 1) == GPIO_ERROR_ARG);
+    msgs[0].addr = I2C_EEPROM_ADDRESS;
+    msgs[0].flags = I2C_M_RD | I2C_M_RECV_LEN;
+    passert(gpio_i2c_transfer(i2c, msgs, 1) == GPIO_ERROR_UNSUPPORTED);
+
+    /* Missing acknowledge from an absent device */
+    msgs[0].addr = 0x7a;
+    msgs[0].flags = 0;
+    passert(gpio_i2c_transfer(i2c, msgs, 1) == GPIO_ERROR_IO);
+    passert(gpio_i2c_errno(i2c) == ENXIO);
+
+    /* Generate random byte vector */
+    srandom(1234);
+    for (i = 0; i < sizeof(vector); i++) {
+        vector[i] = (uint8_t)random();
+    }
+
+    /* Write bytes to 0x100 */
+    /* S [ 0x51 W ] [ 0x01 ] [ 0x00 ] [ Data... ] P */
+    buf[0] = 0x01;
+    buf[1] = 0x00;
+    memcpy(buf + 2, vector, sizeof(vector));
+    msgs[0].addr = I2C_EEPROM_ADDRESS;
+    msgs[0].flags = 0; /* Write */
+    msgs[0].len = sizeof(buf);
+    msgs[0].buf = buf;
+    passert(gpio_i2c_transfer(i2c, msgs, 1) == 0);
+
+    /* Wait for Write Cycle */
+    usleep(10000);
+
+    /* Read bytes from 0x100 */
+    /* S [ 0x51 W ] [ 0x01 ] [ 0x00 ] S [ 0x51 R ] [ Data... ] P */
+    buf[0] = 0x01;
+    buf[1] = 0x00;
+    memset(buf + 2, 0, sizeof(vector));
+    msgs[0].addr = I2C_EEPROM_ADDRESS;
+    msgs[0].flags = 0; /* Write */
+    msgs[0].len = 2;
+    msgs[0].buf = buf;
+    msgs[1].addr = I2C_EEPROM_ADDRESS;
+    msgs[1].flags = I2C_M_RD; /* Read */
+    msgs[1].len = sizeof(vector);
+    msgs[1].buf = buf + 2;
+    passert(gpio_i2c_transfer(i2c, msgs, 2) == 0);
+
+    /* Verify bytes */
+    passert(memcmp(buf + 2, vector, sizeof(vector)) == 0);
+
+    passert(gpio_i2c_close(i2c) == 0);
+
+    /* Free I2C */
+    gpio_i2c_free(i2c);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <SCL GPIO> <SDA GPIO>\n\n", argv[0]);
+        fprintf(stderr, "[1/2] Arguments test: No requirements.\n");
+        fprintf(stderr, "[2/2] Loopback test: Expects 24XX32 EEPROM (or similar) at address 0x51, with pull-ups on SCL and SDA.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3, with I2C1 disabled,\n");
+        fprintf(stderr, "Use GPIO 3 (header pin 5) as SCL and GPIO 2 (header pin 3) as SDA,\n");
+        fprintf(stderr, "and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 3 2\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_scl = strtoul(argv[2], NULL, 10);
+    pin_sda = strtoul(argv[3], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <time.h>
+
+#include "../src/gpio.h"
+#include "../src/gpio_inline.h"
+
+#define BENCHMARK_ITERATIONS    1000000
+
+const char *device;
+unsigned int pin_input, pin_output;
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+void test_arguments(void) {
+    gpio_inline_t inl;
+    gpio_t *gpio;
+
+    ptest();
+
+    /* Allocate GPIO */
+    gpio = gpio_new();
+    passert(gpio != NULL);
+
+    /* Unopened GPIO */
+    passert(gpio_get_inline(gpio, &inl) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Free GPIO */
+    gpio_free(gpio);
+}
+
+void test_loopback(void) {
+    gpio_inline_t inl_in, inl_out;
+    gpio_t *gpio_in, *gpio_out;
+    bool value;
+
+    ptest();
+
+    /* Allocate GPIOs */
+    gpio_in = gpio_new();
+    passert(gpio_in != NULL);
+    gpio_out = gpio_new();
+    passert(gpio_out != NULL);
+
+    /* Open GPIOs */
+    passert(gpio_open(gpio_out, device, pin_output, GPIO_DIR_OUT) == 0);
+    passert(gpio_open(gpio_in, device, pin_input, GPIO_DIR_IN) == 0);
+
+    /* Get inline access */
+    passert(gpio_get_inline(gpio_out, &inl_out) == 0);
+    passert(inl_out.line_fd == gpio_fd(gpio_out));
+    passert(inl_out.output == true);
+    passert(gpio_get_inline(gpio_in, &inl_in) == 0);
+    passert(inl_in.output == false);
+
+    /* Write to input */
+    passert(gpio_inline_write(&inl_in, true) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Drive out high, check in high */
+    passert(gpio_inline_write(&inl_out, true) == 0);
+    passert(gpio_inline_read(&inl_in, &value) == 0);
+    passert(value == true);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == true);
+
+    /* Drive out low, check in low */
+    passert(gpio_inline_write(&inl_out, false) == 0);
+    passert(gpio_inline_read(&inl_in, &value) == 0);
+    passert(value == false);
+    passert(gpio_inline_read(&inl_out, &value) == 0);
+    passert(value == false);
+
+    /* Inverted out, check inline write is inverted by the kernel */
+    passert(gpio_set_inverted(gpio_out, true) == 0);
+    passert(gpio_get_inline(gpio_out, &inl_out) == 0);
+    passert(gpio_inline_write(&inl_out, true) == 0);
+    passert(gpio_inline_read(&inl_in, &value) == 0);
+    passert(value == false);
+    passert(gpio_set_inverted(gpio_out, false) == 0);
+
+    /* Close GPIOs */
+    passert(gpio_close(gpio_out) == 0);
+    passert(gpio_close(gpio_in) == 0);
+
+    /* Closed GPIO */
+    passert(gpio_get_inline(gpio_out, &inl_out) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Free GPIOs */
+    gpio_free(gpio_out);
+    gpio_free(gpio_in);
+}
+
+void test_benchmark(void) {
+    struct timespec start, end;
+    gpio_inline_t inl;
+    gpio_t *gpio;
+    bool value;
+    unsigned int i;
+    double write_ns, inline_write_ns, read_ns, inline_read_ns;
+
+    ptest();
+
+    /* Allocate and open GPIO */
+    gpio = gpio_new();
+    passert(gpio != NULL);
+    passert(gpio_open(gpio, device, pin_output, GPIO_DIR_OUT) == 0);
+    passert(gpio_get_inline(gpio, &inl) == 0);
+
+    /* Library writes */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        passert(gpio_write(gpio, i & 0x1) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    write_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    /* Inline writes */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        passert(gpio_inline_write(&inl, i & 0x1) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    inline_write_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    /* Library reads */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        passert(gpio_read(gpio, &value) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    read_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    /* Inline reads */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        passert(gpio_inline_read(&inl, &value) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    inline_read_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    printf("gpio_write(): %.1f ns/op, gpio_inline_write(): %.1f ns/op (%+.1f%%)\n",
+           write_ns, inline_write_ns, 100.0 * (inline_write_ns - write_ns) / write_ns);
+    printf("gpio_read(): %.1f ns/op, gpio_inline_read(): %.1f ns/op (%+.1f%%)\n",
+           read_ns, inline_read_ns, 100.0 * (inline_read_ns - read_ns) / read_ns);
+
+    /* Close and free GPIO */
+    passert(gpio_close(gpio) == 0);
+    gpio_free(gpio);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2>\n\n", argv[0]);
+        fprintf(stderr, "[1/3] Arguments test: No requirements.\n");
+        fprintf(stderr, "[2/3] Loopback test: GPIOs #1 and #2 should be connected with a wire.\n");
+        fprintf(stderr, "[3/3] Benchmark: GPIO #2 should be free to toggle.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13),\n");
+        fprintf(stderr, "connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 27\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input = strtoul(argv[2], NULL, 10);
+    pin_output = strtoul(argv[3], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+    test_benchmark();
+    printf(" " STR_OK "  Benchmark passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
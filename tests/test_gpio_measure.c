@@ -0,0 +1,185 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+
+#include "../src/gpio_measure.h"
+
+const char *device;
+unsigned int pin_input, pin_output;
+
+void test_arguments(void) {
+    gpio_measure_t *measure;
+
+    ptest();
+
+    /* Allocate measure */
+    measure = gpio_measure_new();
+    passert(measure != NULL);
+
+    /* Invalid histogram bins */
+    gpio_measure_config_t config = {.histogram_bin_ns = 1000, .histogram_bins = 0};
+    passert(gpio_measure_open(measure, NULL, &config) == GPIO_ERROR_ARG);
+    config.histogram_bins = GPIO_MEASURE_HISTOGRAM_MAX + 1;
+    passert(gpio_measure_open(measure, NULL, &config) == GPIO_ERROR_ARG);
+
+    /* Update without GPIO */
+    passert(gpio_measure_open(measure, NULL, NULL) == 0);
+    passert(gpio_measure_update(measure, 0) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_measure_close(measure) == 0);
+
+    /* Free measure */
+    gpio_measure_free(measure);
+}
+
+void test_feed(void) {
+    gpio_measure_t *measure;
+    gpio_measure_result_t result;
+    uint64_t bins[4];
+
+    ptest();
+
+    measure = gpio_measure_new();
+    passert(measure != NULL);
+
+    gpio_measure_config_t config = {.histogram_bin_ns = 1000, .histogram_bins = 4};
+    passert(gpio_measure_open(measure, NULL, &config) == 0);
+
+    /* 100 kHz, 30% duty cycle: 3 us high, 7 us low */
+    gpio_event_t events[8];
+    for (unsigned int i = 0; i < 8; i++) {
+        events[i].edge = (i % 2 == 0) ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING;
+        events[i].timestamp = 1000000 + (i / 2) * 10000 + ((i % 2) ? 3000 : 0);
+        events[i].line = 0;
+        events[i].seqno = i + 1;
+        events[i].line_seqno = i + 1;
+    }
+    passert(gpio_measure_feed(measure, events, 8) == 8);
+
+    passert(gpio_measure_get_result(measure, &result) == 0);
+    passert(result.edges == 8);
+    passert(result.discontinuities == 0);
+    passert(result.period.count == 3);
+    passert(result.period.min_ns == 10000 && result.period.max_ns == 10000);
+    passert(result.high.count == 4);
+    passert(result.high.mean_ns == 3000.0);
+    passert(result.low.count == 3);
+    passert(result.low.mean_ns == 7000.0);
+    passert(result.frequency_hz > 99999.0 && result.frequency_hz < 100001.0);
+    passert(result.duty_cycle > 0.299 && result.duty_cycle < 0.301);
+
+    /* Check pulse width histogram */
+    passert(gpio_measure_get_histogram(measure, bins, 4) == 4);
+    passert(bins[0] == 0 && bins[1] == 0 && bins[2] == 0 && bins[3] == 4);
+
+    /* Check dropped edge restarts interval measurement */
+    events[0].edge = GPIO_EDGE_RISING;
+    events[0].timestamp = 2000000;
+    events[0].line_seqno = 10;
+    passert(gpio_measure_feed(measure, events, 1) == 1);
+    passert(gpio_measure_get_result(measure, &result) == 0);
+    passert(result.discontinuities == 1);
+    passert(result.period.count == 3);
+    passert(result.low.count == 3);
+
+    /* Check reset */
+    gpio_measure_reset(measure);
+    passert(gpio_measure_get_result(measure, &result) == 0);
+    passert(result.edges == 0 && result.period.count == 0);
+
+    passert(gpio_measure_close(measure) == 0);
+    gpio_measure_free(measure);
+}
+
+void test_loopback(void) {
+    gpio_t *gpio_in, *gpio_out;
+    gpio_measure_t *measure;
+    gpio_measure_result_t result;
+    char str[256];
+
+    ptest();
+
+    gpio_in = gpio_new();
+    passert(gpio_in != NULL);
+    gpio_out = gpio_new();
+    passert(gpio_out != NULL);
+    measure = gpio_measure_new();
+    passert(measure != NULL);
+
+    passert(gpio_open(gpio_out, device, pin_output, GPIO_DIR_OUT) == 0);
+    passert(gpio_open(gpio_in, device, pin_input, GPIO_DIR_IN) == 0);
+
+    /* Check GPIO without edge is rejected */
+    passert(gpio_measure_open(measure, gpio_in, NULL) == GPIO_ERROR_INVALID_OPERATION);
+
+    passert(gpio_set_edge(gpio_in, GPIO_EDGE_BOTH) == 0);
+    passert(gpio_measure_open(measure, gpio_in, NULL) == 0);
+
+    /* Generate 10 pulses of 2 ms high, 6 ms low */
+    for (unsigned int i = 0; i < 10; i++) {
+        passert(gpio_write(gpio_out, true) == 0);
+        usleep(2000);
+        passert(gpio_write(gpio_out, false) == 0);
+        usleep(6000);
+    }
+
+    /* Process all events */
+    while (gpio_measure_update(measure, 100) > 0);
+
+    passert(gpio_measure_get_result(measure, &result) == 0);
+    passert(result.edges == 20);
+    passert(result.high.count == 10);
+    passert(result.low.count == 9);
+    passert(result.period.count == 9);
+    passert(result.high.mean_ns > 1.5e6 && result.high.mean_ns < 4e6);
+    passert(result.frequency_hz > 80.0 && result.frequency_hz < 130.0);
+    passert(result.duty_cycle > 0.15 && result.duty_cycle < 0.40);
+
+    passert(gpio_measure_tostring(measure, str, sizeof(str)) > 0);
+    printf("Measure description: %s\n", str);
+
+    passert(gpio_measure_close(measure) == 0);
+    passert(gpio_close(gpio_in) == 0);
+    passert(gpio_close(gpio_out) == 0);
+
+    gpio_measure_free(measure);
+    gpio_free(gpio_in);
+    gpio_free(gpio_out);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2>\n\n", argv[0]);
+        fprintf(stderr, "[1/3] Argument test: No requirements.\n");
+        fprintf(stderr, "[2/3] Feed test: No requirements.\n");
+        fprintf(stderr, "[3/3] Loopback test: GPIOs #1 and #2 should be connected with a wire.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13),\n");
+        fprintf(stderr, "connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 27\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input = strtoul(argv[2], NULL, 10);
+    pin_output = strtoul(argv[3], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_feed();
+    printf(" " STR_OK "  Feed test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <time.h>
+
+#include "../src/gpio.h"
+#include "../src/mmio.h"
+
+#define PAGE_SIZE   4096
+
+const char *device;
+unsigned int pin_input, pin_output;
+uintptr_t controller_base;
+
+void test_arguments(void) {
+    gpio_t *gpio;
+    mmio_t *mmio;
+
+    ptest();
+
+    /* Allocate GPIO and MMIO */
+    gpio = gpio_new();
+    passert(gpio != NULL);
+    mmio = mmio_new();
+    passert(mmio != NULL);
+
+    /* Map a page of zeros in place of controller registers */
+    passert(mmio_open_advanced(mmio, 0, PAGE_SIZE, "/dev/zero") == 0);
+
+    /* Missing registers */
+    passert(gpio_open_mmio(gpio, device, pin_output, GPIO_DIR_OUT, NULL) == GPIO_ERROR_ARG);
+    gpio_mmio_regs_t regs_null = GPIO_MMIO_REGS_BCM2835(NULL);
+    passert(gpio_open_mmio(gpio, device, pin_output, GPIO_DIR_OUT, &regs_null) == GPIO_ERROR_ARG);
+
+    /* Registers outside of mapping */
+    gpio_mmio_regs_t regs_outside = {.mmio = mmio, .level_offset = PAGE_SIZE, .set_offset = 0x0, .clear_offset = 0x4, .bank_stride = 0, .data_offset = 0, .rmw = false};
+    passert(gpio_open_mmio(gpio, device, pin_output, GPIO_DIR_OUT, &regs_outside) == GPIO_ERROR_ARG);
+    gpio_mmio_regs_t regs_rmw = {.mmio = mmio, .level_offset = 0x0, .set_offset = 0x0, .clear_offset = 0x0, .bank_stride = 0, .data_offset = PAGE_SIZE - 2, .rmw = true};
+    passert(gpio_open_mmio(gpio, device, pin_output, GPIO_DIR_OUT, &regs_rmw) == GPIO_ERROR_ARG);
+    /* Line beyond a single bank */
+    gpio_mmio_regs_t regs_bank = GPIO_MMIO_REGS_AM335X(mmio);
+    passert(gpio_open_mmio(gpio, device, 32, GPIO_DIR_OUT, &regs_bank) == GPIO_ERROR_ARG);
+    /* Bank beyond mapping */
+    gpio_mmio_regs_t regs_stride = GPIO_MMIO_REGS_SUNXI(mmio);
+    passert(gpio_open_mmio(gpio, device, 32 * 120, GPIO_DIR_OUT, &regs_stride) == GPIO_ERROR_ARG);
+
+    /* Registers misaligned in memory by an unaligned MMIO base */
+    mmio_t *mmio_unaligned = mmio_new();
+    passert(mmio_unaligned != NULL);
+    passert(mmio_open_advanced(mmio_unaligned, 2, PAGE_SIZE - 2, "/dev/zero") == 0);
+    gpio_mmio_regs_t regs_unaligned = GPIO_MMIO_REGS_BCM2835(mmio_unaligned);
+    passert(gpio_open_mmio(gpio, device, pin_output, GPIO_DIR_OUT, &regs_unaligned) == GPIO_ERROR_ARG);
+    passert(mmio_close(mmio_unaligned) == 0);
+    mmio_free(mmio_unaligned);
+
+    /* Invalid direction */
+    gpio_mmio_regs_t regs = GPIO_MMIO_REGS_BCM2835(mmio);
+    passert(gpio_open_mmio(gpio, device, pin_output, 5, &regs) == GPIO_ERROR_ARG);
+
+    /* Free GPIO and MMIO */
+    passert(mmio_close(mmio) == 0);
+    mmio_free(mmio);
+    gpio_free(gpio);
+}
+
+void test_loopback(void) {
+    gpio_t *gpio_in, *gpio_out;
+    mmio_t *mmio;
+    bool value;
+    struct timespec start, end;
+    char str[512];
+    unsigned int i;
+
+    ptest();
+
+    /* Allocate GPIOs and MMIO */
+    gpio_in = gpio_new();
+    passert(gpio_in != NULL);
+    gpio_out = gpio_new();
+    passert(gpio_out != NULL);
+    mmio = mmio_new();
+    passert(mmio != NULL);
+
+    /* Map controller */
+    passert(mmio_open(mmio, controller_base, PAGE_SIZE) == 0);
+    gpio_mmio_regs_t regs = GPIO_MMIO_REGS_BCM2835(mmio);
+
+    /* Open input through cdev and output through MMIO */
+    passert(gpio_open(gpio_in, device, pin_input, GPIO_DIR_IN) == 0);
+    passert(gpio_open_mmio(gpio_out, device, pin_output, GPIO_DIR_OUT, &regs) == 0);
+
+    passert(gpio_tostring(gpio_out, str, sizeof(str)) > 0);
+    printf("GPIO description: %s\n", str);
+    passert(strstr(str, "type=mmio") != NULL);
+
+    /* Line is claimed through cdev */
+    passert(gpio_fd(gpio_out) >= 0);
+    passert(gpio_line(gpio_out) == pin_output);
+
+    /* Drive out low, check in low */
+    passert(gpio_write(gpio_out, false) == 0);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == false);
+    passert(gpio_read(gpio_out, &value) == 0);
+    passert(value == false);
+
+    /* Drive out high, check in high */
+    passert(gpio_write(gpio_out, true) == 0);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == true);
+    passert(gpio_read(gpio_out, &value) == 0);
+    passert(value == true);
+
+    /* Invert out, check in low */
+    passert(gpio_set_inverted(gpio_out, true) == 0);
+    passert(gpio_write(gpio_out, true) == 0);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == false);
+    passert(gpio_set_inverted(gpio_out, false) == 0);
+
+    /* Measure toggle rate */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < 1000000; i++)
+        passert(gpio_write(gpio_out, i & 0x1) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Toggle rate: %.0f writes/s\n", 1e6 / ((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9));
+
+    passert(gpio_close(gpio_out) == 0);
+    passert(gpio_close(gpio_in) == 0);
+
+    /* Open input through MMIO and output through cdev */
+    passert(gpio_open_mmio(gpio_in, device, pin_input, GPIO_DIR_IN, &regs) == 0);
+    passert(gpio_open(gpio_out, device, pin_output, GPIO_DIR_OUT) == 0);
+
+    /* Write to input */
+    passert(gpio_write(gpio_in, true) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Drive out high, check in high */
+    passert(gpio_write(gpio_out, true) == 0);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == true);
+
+    /* Drive out low, check in low */
+    passert(gpio_write(gpio_out, false) == 0);
+    passert(gpio_read(gpio_in, &value) == 0);
+    passert(value == false);
+
+    passert(gpio_close(gpio_out) == 0);
+    passert(gpio_close(gpio_in) == 0);
+
+    /* Closed GPIO does not touch the registers */
+    passert(gpio_read(gpio_in, &value) < 0);
+
+    /* Free GPIOs and MMIO */
+    passert(mmio_close(mmio) == 0);
+    mmio_free(mmio);
+    gpio_free(gpio_out);
+    gpio_free(gpio_in);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2> <BCM2835 GPIO controller base address>\n\n", argv[0]);
+        fprintf(stderr, "[1/2] Arguments test: No requirements.\n");
+        fprintf(stderr, "[2/2] Loopback test: GPIOs #1 and #2 should be connected with a wire, on a BCM2835 compatible GPIO controller.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13),\n");
+        fprintf(stderr, "connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 27 0x3f200000\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input = strtoul(argv[2], NULL, 10);
+    pin_output = strtoul(argv[3], NULL, 10);
+    controller_base = strtoul(argv[4], NULL, 0);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
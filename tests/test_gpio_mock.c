@@ -0,0 +1,311 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "../src/gpio.h"
+
+#define LOAD_EVENTS         4000000
+#define LOAD_BATCH          64
+#define LOAD_BUFFER_SIZE    65536
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+void test_arguments(void) {
+    gpio_config_t config = {0};
+    gpio_t *gpio;
+
+    ptest();
+
+    /* Allocate GPIO */
+    gpio = gpio_new();
+    passert(gpio != NULL);
+
+    /* Inject into unopened non-mock GPIO */
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_RISING, 0) == GPIO_ERROR_UNSUPPORTED);
+
+#if PERIPHERY_GPIO_CDEV_ONLY
+    /* Mock GPIOs are unsupported in character device only builds */
+    passert(gpio_open_mock(gpio, 0, GPIO_DIR_IN) == GPIO_ERROR_UNSUPPORTED);
+    passert(gpio_open_mock_advanced(gpio, 0, &config) == GPIO_ERROR_UNSUPPORTED);
+#else
+    /* Invalid direction */
+    passert(gpio_open_mock(gpio, 0, 5) == GPIO_ERROR_ARG);
+
+    /* Invalid edge for output */
+    config.direction = GPIO_DIR_OUT;
+    config.edge = GPIO_EDGE_BOTH;
+    passert(gpio_open_mock_advanced(gpio, 0, &config) == GPIO_ERROR_ARG);
+
+    /* Invalid event buffer size */
+    config.direction = GPIO_DIR_IN;
+    config.event_buffer_size = 0xffffffff;
+    passert(gpio_open_mock_advanced(gpio, 0, &config) == GPIO_ERROR_ARG);
+
+    /* Invalid injected edge */
+    config.event_buffer_size = 0;
+    passert(gpio_open_mock_advanced(gpio, 0, &config) == 0);
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_BOTH, 0) == GPIO_ERROR_ARG);
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_NONE, 0) == GPIO_ERROR_ARG);
+    passert(gpio_close(gpio) == 0);
+
+    /* Inject into closed mock GPIO */
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_RISING, 0) == GPIO_ERROR_INVALID_OPERATION);
+#endif
+
+    /* Free GPIO */
+    gpio_free(gpio);
+}
+
+void test_open_config_close(void) {
+    gpio_direction_t direction;
+    gpio_edge_t edge;
+    gpio_t *gpio;
+    bool value;
+    char str[256];
+
+    ptest();
+
+    /* Allocate and open GPIO */
+    gpio = gpio_new();
+    passert(gpio != NULL);
+    passert(gpio_open_mock(gpio, 7, GPIO_DIR_IN) == 0);
+
+    /* Check properties */
+    passert(gpio_line(gpio) == 7);
+    passert(gpio_fd(gpio) >= 0);
+    passert(gpio_chip_fd(gpio) == -1);
+    passert(gpio_chip_name(gpio, str, sizeof(str)) == 0);
+    passert(strcmp(str, "mock") == 0);
+    passert(gpio_label(gpio, str, sizeof(str)) == 0);
+    passert(strcmp(str, "periphery") == 0);
+    passert(gpio_tostring(gpio, str, sizeof(str)) > 0);
+    printf("gpio_tostring(): %s\n", str);
+    passert(strstr(str, "type=mock") != NULL);
+
+    /* Write to input */
+    passert(gpio_write(gpio, true) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Reconfigure as output */
+    passert(gpio_set_direction(gpio, GPIO_DIR_OUT_HIGH) == 0);
+    passert(gpio_get_direction(gpio, &direction) == 0);
+    passert(direction == GPIO_DIR_OUT);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == true);
+    passert(gpio_write(gpio, false) == 0);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == false);
+    passert(gpio_set_edge(gpio, GPIO_EDGE_RISING) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_RISING, 0) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Inverting flips the logical value */
+    passert(gpio_set_inverted(gpio, true) == 0);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == true);
+    passert(gpio_set_inverted(gpio, false) == 0);
+
+    /* Reconfigure as input with edge */
+    passert(gpio_set_direction(gpio, GPIO_DIR_IN) == 0);
+    passert(gpio_set_edge(gpio, GPIO_EDGE_BOTH) == 0);
+    passert(gpio_get_edge(gpio, &edge) == 0);
+    passert(edge == GPIO_EDGE_BOTH);
+
+    /* Line info events are unsupported */
+    passert(gpio_read_line_info_event(gpio, NULL, 0) == GPIO_ERROR_UNSUPPORTED);
+
+    /* Close GPIO */
+    passert(gpio_close(gpio) == 0);
+    passert(gpio_fd(gpio) == -1);
+    passert(gpio_read(gpio, &value) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Free GPIO */
+    gpio_free(gpio);
+}
+
+void test_events(void) {
+    gpio_config_t config = {0};
+    gpio_event_t events[8];
+    gpio_event_stats_t stats;
+    struct pollfd fds[1];
+    gpio_edge_t edge;
+    uint64_t timestamp;
+    gpio_t *gpio;
+    bool value;
+
+    ptest();
+
+    /* Allocate and open GPIO with a small event buffer */
+    gpio = gpio_new();
+    passert(gpio != NULL);
+    config.direction = GPIO_DIR_IN;
+    config.edge = GPIO_EDGE_BOTH;
+    config.event_clock = GPIO_EVENT_CLOCK_MONOTONIC;
+    config.event_buffer_size = 3;
+    passert(gpio_open_mock_advanced(gpio, 3, &config) == 0);
+
+    /* No events queued */
+    passert(gpio_poll(gpio, 0) == 0);
+    passert(gpio_read_events(gpio, events, 8, 0) == 0);
+    passert(gpio_read_events(gpio, events, 8, 10) == 0);
+    fds[0].fd = gpio_fd(gpio);
+    fds[0].events = POLLIN;
+    passert(poll(fds, 1, 0) == 0);
+
+    /* Inject rising edge with timestamp */
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_RISING, 1234) == 1);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == true);
+    passert(poll(fds, 1, 0) == 1);
+    passert(gpio_poll(gpio, 0) == 1);
+    passert(gpio_read_event(gpio, &edge, &timestamp) == 0);
+    passert(edge == GPIO_EDGE_RISING);
+    passert(timestamp == 1234);
+
+    /* Wakeup is consumed with the last event */
+    passert(poll(fds, 1, 0) == 0);
+
+    /* Inject falling edge timestamped on injection */
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_FALLING, 0) == 1);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == false);
+    passert(gpio_read_events(gpio, events, 8, -1) == 1);
+    passert(events[0].edge == GPIO_EDGE_FALLING);
+    passert(events[0].timestamp != 0);
+    passert(events[0].line == 3);
+    passert(events[0].seqno == 2);
+    passert(events[0].line_seqno == 2);
+
+    /* Overflow event buffer of 4 events, dropping 2 */
+    for (unsigned int i = 0; i < 6; i++)
+        events[i] = (gpio_event_t){.edge = (i % 2) ? GPIO_EDGE_FALLING : GPIO_EDGE_RISING, .timestamp = 100 + i};
+    passert(gpio_mock_inject_events(gpio, events, 6) == 4);
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_RISING, 0) == 0);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == true);
+
+    /* Read in two batches */
+    passert(gpio_read_events(gpio, events, 3, 0) == 3);
+    passert(events[0].seqno == 3 && events[0].timestamp == 100);
+    passert(events[2].seqno == 5 && events[2].edge == GPIO_EDGE_RISING);
+    passert(poll(fds, 1, 0) == 1);
+    passert(gpio_read_events(gpio, events, 8, 0) == 1);
+    passert(events[0].seqno == 6);
+    passert(poll(fds, 1, 0) == 0);
+
+    passert(gpio_get_event_stats(gpio, &stats) == 0);
+    passert(stats.events == 6);
+    passert(stats.dropped == 3);
+
+    /* Rising edge only, falling edges are filtered but update the value */
+    passert(gpio_set_edge(gpio, GPIO_EDGE_RISING) == 0);
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_FALLING, 0) == 0);
+    passert(gpio_read(gpio, &value) == 0);
+    passert(value == false);
+    passert(gpio_poll(gpio, 0) == 0);
+    passert(gpio_mock_inject_edge(gpio, GPIO_EDGE_RISING, 0) == 1);
+    passert(gpio_read_events(gpio, events, 8, 0) == 1);
+    passert(events[0].edge == GPIO_EDGE_RISING);
+
+    /* Close and free GPIO */
+    passert(gpio_close(gpio) == 0);
+    gpio_free(gpio);
+}
+
+static void *producer_thread(void *arg) {
+    gpio_t *gpio = arg;
+    gpio_event_t events[LOAD_BATCH];
+
+    for (unsigned int i = 0; i < LOAD_BATCH; i++)
+        events[i] = (gpio_event_t){.edge = (i % 2) ? GPIO_EDGE_FALLING : GPIO_EDGE_RISING, .timestamp = 1};
+
+    for (unsigned int i = 0; i < LOAD_EVENTS / LOAD_BATCH; i++)
+        assert(gpio_mock_inject_events(gpio, events, LOAD_BATCH) >= 0);
+
+    return NULL;
+}
+
+void test_load(void) {
+    gpio_config_t config = {0};
+    gpio_event_t events[LOAD_BATCH];
+    gpio_event_stats_t stats;
+    struct timespec start, end;
+    pthread_t thread;
+    gpio_t *gpio;
+    uint64_t count = 0, dropped;
+    uint32_t last_seqno = 0;
+    int ret;
+
+    ptest();
+
+    /* Allocate and open GPIO */
+    gpio = gpio_new();
+    passert(gpio != NULL);
+    config.direction = GPIO_DIR_IN;
+    config.edge = GPIO_EDGE_BOTH;
+    config.event_buffer_size = LOAD_BUFFER_SIZE;
+    passert(gpio_open_mock_advanced(gpio, 0, &config) == 0);
+
+    /* Inject from a producer thread, read until all events are accounted */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    passert(pthread_create(&thread, NULL, producer_thread, gpio) == 0);
+
+    while (true) {
+        passert(gpio_get_event_stats(gpio, &stats) == 0);
+        dropped = stats.dropped;
+        if (count + dropped == LOAD_EVENTS)
+            break;
+
+        if ((ret = gpio_read_events(gpio, events, LOAD_BATCH, 100)) < 0)
+            passert(ret >= 0);
+
+        for (int i = 0; i < ret; i++) {
+            if (events[i].seqno <= last_seqno)
+                passert(events[i].seqno > last_seqno);
+            last_seqno = events[i].seqno;
+        }
+
+        count += ret;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    passert(pthread_join(thread, NULL) == 0);
+
+    /* Nothing left behind */
+    passert(gpio_read_events(gpio, events, LOAD_BATCH, 0) == 0);
+    passert(gpio_poll(gpio, 0) == 0);
+
+    printf("%" PRIu64 " events read, %" PRIu64 " dropped, %.1f ns/event\n", count, dropped, elapsed_ns(&start, &end) / LOAD_EVENTS);
+
+    /* Close and free GPIO */
+    passert(gpio_close(gpio) == 0);
+    gpio_free(gpio);
+}
+
+int main(void) {
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+#if !PERIPHERY_GPIO_CDEV_ONLY
+    test_open_config_close();
+    printf(" " STR_OK "  Open/close test passed.\n\n");
+    test_events();
+    printf(" " STR_OK "  Event injection test passed.\n\n");
+    test_load();
+    printf(" " STR_OK "  Load test passed.\n\n");
+#endif
+
+    printf("All tests passed!\n");
+    return 0;
+}
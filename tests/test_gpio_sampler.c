@@ -0,0 +1,217 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "../src/gpio_sampler.h"
+
+const char *device;
+unsigned int pin_input, pin_output;
+
+void test_arguments(void) {
+    gpio_sampler_t *sampler;
+    gpio_lines_t *lines;
+    gpio_sample_t samples[4];
+
+    ptest();
+
+    /* Allocate sampler and lines */
+    sampler = gpio_sampler_new();
+    passert(sampler != NULL);
+    lines = gpio_lines_new();
+    passert(lines != NULL);
+
+    gpio_sampler_config_t config = {
+        .period_ns = 1000000,
+        .pacing = GPIO_SAMPLER_PACING_TIMERFD,
+        .ring_size = 1024,
+        .filter_samples = 0,
+    };
+
+    /* Unopened lines */
+    passert(gpio_sampler_open(sampler, lines, &config) == GPIO_ERROR_ARG);
+
+    /* Unopened sampler */
+    passert(gpio_sampler_start(sampler) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_sampler_dequeue(sampler, samples, 4) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_sampler_running(sampler) == false);
+
+    gpio_lines_free(lines);
+    gpio_sampler_free(sampler);
+}
+
+void test_loopback(void) {
+    gpio_t *gpio_out;
+    gpio_lines_t *lines_in;
+    gpio_sampler_t *sampler;
+    gpio_sampler_stats_t stats;
+    gpio_sample_t samples[256];
+    gpio_event_t events[16];
+    char str[256];
+    int ret;
+
+    ptest();
+
+    gpio_out = gpio_new();
+    passert(gpio_out != NULL);
+    lines_in = gpio_lines_new();
+    passert(lines_in != NULL);
+    sampler = gpio_sampler_new();
+    passert(sampler != NULL);
+
+    passert(gpio_open(gpio_out, device, pin_output, GPIO_DIR_OUT) == 0);
+    unsigned int offsets[1] = {pin_input};
+    passert(gpio_lines_open(lines_in, device, offsets, 1, GPIO_DIR_IN) == 0);
+
+    gpio_sampler_config_t config = {
+        .period_ns = 1000000,
+        .pacing = GPIO_SAMPLER_PACING_TIMERFD,
+        .ring_size = 1024,
+        .filter_samples = 0,
+    };
+
+    /* Invalid arguments */
+    config.period_ns = 0;
+    passert(gpio_sampler_open(sampler, lines_in, &config) == GPIO_ERROR_ARG);
+    config.period_ns = 1000000;
+    config.pacing = 5;
+    passert(gpio_sampler_open(sampler, lines_in, &config) == GPIO_ERROR_ARG);
+    config.pacing = GPIO_SAMPLER_PACING_TIMERFD;
+    config.ring_size = 0;
+    passert(gpio_sampler_open(sampler, lines_in, &config) == GPIO_ERROR_ARG);
+    config.ring_size = 1024;
+    config.filter_samples = 4;
+    passert(gpio_sampler_open(sampler, lines_in, &config) == GPIO_ERROR_ARG);
+    config.filter_samples = GPIO_SAMPLER_FILTER_MAX + 2;
+    passert(gpio_sampler_open(sampler, lines_in, &config) == GPIO_ERROR_ARG);
+    config.filter_samples = 0;
+
+    for (unsigned int pacing = GPIO_SAMPLER_PACING_TIMERFD; pacing <= GPIO_SAMPLER_PACING_ONESHOT; pacing++) {
+        /* Sample at 1 kHz with a 3 sample majority filter */
+        config.pacing = pacing;
+        config.filter_samples = 3;
+        passert(gpio_sampler_open(sampler, lines_in, &config) == 0);
+
+        passert(gpio_sampler_tostring(sampler, str, sizeof(str)) > 0);
+        printf("Sampler description: %s\n", str);
+
+        passert(gpio_write(gpio_out, false) == 0);
+        passert(gpio_sampler_start(sampler) == 0);
+        passert(gpio_sampler_running(sampler) == true);
+
+        /* Generate 5 pulses of 20 ms high, 20 ms low */
+        for (unsigned int i = 0; i < 5; i++) {
+            passert(gpio_write(gpio_out, true) == 0);
+            usleep(20000);
+            passert(gpio_write(gpio_out, false) == 0);
+            usleep(20000);
+        }
+
+        passert(gpio_sampler_stop(sampler) == 0);
+        passert(gpio_sampler_running(sampler) == false);
+
+        /* Check samples */
+        unsigned int count = 0, high = 0;
+        uint64_t last_timestamp = 0;
+        while ((ret = gpio_sampler_dequeue(sampler, samples, 256)) > 0) {
+            for (int i = 0; i < ret; i++) {
+                passert(samples[i].timestamp > last_timestamp);
+                passert((samples[i].bits & ~0x1ULL) == 0);
+                last_timestamp = samples[i].timestamp;
+                high += samples[i].bits;
+            }
+            count += ret;
+        }
+        passert(ret == 0);
+        passert(count > 150 && count < 250);
+        passert(high > count / 4 && high < (count * 3) / 4);
+
+        /* Check filtered edge events */
+        passert(gpio_sampler_read_events(sampler, events, 16) == 10);
+        for (unsigned int i = 0; i < 10; i++) {
+            passert(events[i].edge == ((i % 2 == 0) ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING));
+            passert(events[i].line == pin_input);
+            passert(events[i].seqno == i + 1);
+        }
+
+        /* Check statistics */
+        passert(gpio_sampler_get_stats(sampler, &stats) == 0);
+        passert(stats.samples == count);
+        passert(stats.samples_dropped == 0);
+        passert(stats.events == 10);
+        passert(stats.events_dropped == 0);
+        passert(stats.jitter_min_ns <= stats.jitter_max_ns);
+        passert(stats.jitter_mean_ns >= (double)stats.jitter_min_ns && stats.jitter_mean_ns <= (double)stats.jitter_max_ns);
+        printf("Jitter min %" PRIu64 " ns, max %" PRIu64 " ns, mean %.0f ns, missed %" PRIu64 "\n",
+               stats.jitter_min_ns, stats.jitter_max_ns, stats.jitter_mean_ns, stats.missed);
+
+        passert(gpio_sampler_close(sampler) == 0);
+    }
+
+    /* Check stop interrupts a long sampling period */
+    config.period_ns = 10000000000ULL;
+    config.filter_samples = 0;
+    for (unsigned int pacing = GPIO_SAMPLER_PACING_TIMERFD; pacing <= GPIO_SAMPLER_PACING_ONESHOT; pacing++) {
+        struct timespec start, end;
+
+        config.pacing = pacing;
+        passert(gpio_sampler_open(sampler, lines_in, &config) == 0);
+        passert(gpio_sampler_start(sampler) == 0);
+        usleep(10000);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        passert(gpio_sampler_stop(sampler) == 0);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        passert((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec) < 100000000LL);
+        passert(gpio_sampler_close(sampler) == 0);
+    }
+    config.period_ns = 1000000;
+
+    /* Check events are unavailable without filter */
+    config.filter_samples = 0;
+    passert(gpio_sampler_open(sampler, lines_in, &config) == 0);
+    passert(gpio_sampler_read_events(sampler, events, 16) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_sampler_close(sampler) == 0);
+
+    passert(gpio_lines_close(lines_in) == 0);
+    passert(gpio_close(gpio_out) == 0);
+
+    gpio_sampler_free(sampler);
+    gpio_lines_free(lines_in);
+    gpio_free(gpio_out);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2>\n\n", argv[0]);
+        fprintf(stderr, "[1/2] Argument test: No requirements.\n");
+        fprintf(stderr, "[2/2] Loopback test: GPIOs #1 and #2 should be connected with a wire.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13),\n");
+        fprintf(stderr, "connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 27\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input = strtoul(argv[2], NULL, 10);
+    pin_output = strtoul(argv[3], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
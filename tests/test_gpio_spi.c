@@ -0,0 +1,131 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <time.h>
+
+#include "../src/gpio_spi.h"
+
+const char *device;
+unsigned int pin_sclk, pin_mosi, pin_miso;
+
+void test_arguments(void) {
+    gpio_spi_t *spi;
+    uint8_t buf[4] = {0};
+
+    ptest();
+
+    /* Allocate SPI */
+    spi = gpio_spi_new();
+    passert(spi != NULL);
+
+    /* Invalid mode */
+    passert(gpio_spi_open(spi, device, pin_sclk, pin_mosi, pin_miso, GPIO_SPI_LINE_NONE, 4, 100000) == GPIO_ERROR_ARG);
+    /* Missing SCLK */
+    passert(gpio_spi_open(spi, device, GPIO_SPI_LINE_NONE, pin_mosi, pin_miso, GPIO_SPI_LINE_NONE, 0, 100000) == GPIO_ERROR_ARG);
+    /* Line used twice */
+    passert(gpio_spi_open(spi, device, pin_sclk, pin_sclk, pin_miso, GPIO_SPI_LINE_NONE, 0, 100000) == GPIO_ERROR_ARG);
+    passert(gpio_spi_open(spi, device, pin_sclk, pin_mosi, pin_miso, pin_mosi, 0, 100000) == GPIO_ERROR_ARG);
+
+    /* Invalid bit order */
+    gpio_spi_config_t config = {.mode = 0, .max_speed = 100000, .bit_order = 2, .cs_high = false, .mmio = NULL, .label = NULL};
+    passert(gpio_spi_open_advanced(spi, device, pin_sclk, pin_mosi, pin_miso, GPIO_SPI_LINE_NONE, &config) == GPIO_ERROR_ARG);
+
+    /* Unopened SPI */
+    passert(gpio_spi_transfer(spi, buf, buf, sizeof(buf)) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Free SPI */
+    gpio_spi_free(spi);
+}
+
+void test_loopback(void) {
+    gpio_spi_t *spi;
+    uint8_t buf[32];
+    uint8_t rxbuf1[32], rxbuf2[32];
+    spi_msg_t msgs[2] = {
+        { .txbuf = buf, .rxbuf = rxbuf1, .len = sizeof(buf), .deselect = true },
+        { .txbuf = buf, .rxbuf = rxbuf2, .len = sizeof(buf), .deselect = false },
+    };
+    struct timespec start, end;
+    char str[256];
+    unsigned int i;
+
+    ptest();
+
+    /* Allocate SPI */
+    spi = gpio_spi_new();
+    passert(spi != NULL);
+
+    for (unsigned int mode = 0; mode < 4; mode++) {
+        for (unsigned int bit_order = MSB_FIRST; bit_order <= LSB_FIRST; bit_order++) {
+            gpio_spi_config_t config = {.mode = mode, .max_speed = 100000, .bit_order = bit_order, .cs_high = false, .mmio = NULL, .label = NULL};
+            passert(gpio_spi_open_advanced(spi, device, pin_sclk, pin_mosi, pin_miso, GPIO_SPI_LINE_NONE, &config) == 0);
+
+            passert(gpio_spi_tostring(spi, str, sizeof(str)) > 0);
+            printf("SPI description: %s\n", str);
+
+            for (i = 0; i < sizeof(buf); i++)
+                buf[i] = i * 37;
+
+            /* In place transfer */
+            passert(gpio_spi_transfer(spi, buf, buf, sizeof(buf)) == 0);
+
+            for (i = 0; i < sizeof(buf); i++)
+                passert(buf[i] == (uint8_t)(i * 37));
+
+            passert(gpio_spi_transfer_advanced(spi, msgs, 2) == 0);
+
+            for (i = 0; i < sizeof(buf); i++) {
+                passert(rxbuf1[i] == buf[i]);
+                passert(rxbuf2[i] == buf[i]);
+            }
+
+            passert(gpio_spi_close(spi) == 0);
+        }
+    }
+
+    /* Clock rate is bounded by max speed */
+    passert(gpio_spi_open(spi, device, pin_sclk, pin_mosi, pin_miso, GPIO_SPI_LINE_NONE, 0, 10000) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    passert(gpio_spi_transfer(spi, buf, NULL, 10) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    passert((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec) >= 8000000LL);
+    passert(gpio_spi_close(spi) == 0);
+
+    /* Free SPI */
+    gpio_spi_free(spi);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <SCLK GPIO> <MOSI GPIO> <MISO GPIO>\n\n", argv[0]);
+        fprintf(stderr, "[1/2] Arguments test: No requirements.\n");
+        fprintf(stderr, "[2/2] Loopback test: MOSI and MISO GPIOs should be connected with a wire.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 22 (header pin 15) as SCLK, and GPIO 17 (header pin 11) and GPIO 27 (header pin 13) as MOSI and MISO,\n");
+        fprintf(stderr, "connect a loopback between MOSI and MISO, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 22 17 27\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_sclk = strtoul(argv[2], NULL, 10);
+    pin_mosi = strtoul(argv[3], NULL, 10);
+    pin_miso = strtoul(argv[4], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
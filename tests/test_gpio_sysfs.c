@@ -29,6 +29,7 @@ void test_arguments(void) {
 
     /* Invalid direction */
     passert(gpio_open_sysfs(gpio, pin_input, 5) == GPIO_ERROR_ARG);
+    passert(gpio_open_sysfs_many(&gpio, &pin_input, (gpio_direction_t[]){5}, 1) == GPIO_ERROR_ARG);
 
     /* Free GPIO */
     gpio_free(gpio);
@@ -135,6 +136,27 @@ void test_open_config_close(void) {
 
     /* Free GPIO */
     gpio_free(gpio);
+
+    /* Open both GPIOs together */
+    gpio_t *gpios[2] = {gpio_new(), gpio_new()};
+    passert(gpios[0] != NULL && gpios[1] != NULL);
+    passert(gpio_open_sysfs_many(gpios, (unsigned int[]){pin_input, pin_output}, (gpio_direction_t[]){GPIO_DIR_IN, GPIO_DIR_OUT_HIGH}, 2) == 0);
+    passert(gpio_get_direction(gpios[0], &direction) == 0);
+    passert(direction == GPIO_DIR_IN);
+    passert(gpio_read(gpios[1], &value) == 0);
+    passert(value == true);
+
+    passert(gpio_close(gpios[0]) == 0);
+    passert(gpio_close(gpios[1]) == 0);
+
+    /* Open non-existent GPIO along with a legitimate one -- legitimate
+     * GPIO should be left closed */
+    passert(gpio_open_sysfs_many(gpios, (unsigned int[]){pin_input, 9999}, (gpio_direction_t[]){GPIO_DIR_IN, GPIO_DIR_IN}, 2) == GPIO_ERROR_OPEN);
+    passert(gpio_errno(gpios[1]) == EINVAL);
+    passert(gpio_fd(gpios[0]) == -1);
+
+    gpio_free(gpios[0]);
+    gpio_free(gpios[1]);
 }
 
 /* Threaded poll helper functions */
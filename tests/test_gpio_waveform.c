@@ -0,0 +1,181 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "../src/gpio_waveform.h"
+
+const char *device;
+unsigned int pin_input, pin_output;
+
+void test_arguments(void) {
+    gpio_waveform_t *waveform;
+    gpio_lines_t *lines;
+
+    ptest();
+
+    /* Allocate waveform and lines */
+    waveform = gpio_waveform_new();
+    passert(waveform != NULL);
+    lines = gpio_lines_new();
+    passert(lines != NULL);
+
+    gpio_waveform_config_t config = {.priority = 0, .cpu = -1, .repeat = 0};
+
+    /* Unopened lines */
+    passert(gpio_waveform_open(waveform, lines, &config) == GPIO_ERROR_ARG);
+
+    /* Unopened waveform */
+    gpio_waveform_step_t step = {.mask = 0x1, .value = 0x1, .delay_ns = 1000};
+    passert(gpio_waveform_load(waveform, &step, 1) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_waveform_start(waveform) == GPIO_ERROR_INVALID_OPERATION);
+    passert(gpio_waveform_running(waveform) == false);
+
+    gpio_lines_free(lines);
+    gpio_waveform_free(waveform);
+}
+
+void test_loopback(void) {
+    gpio_t *gpio_in;
+    gpio_lines_t *lines_out;
+    gpio_waveform_t *waveform;
+    gpio_waveform_stats_t stats;
+    gpio_event_t events[64];
+    char str[256];
+    int ret;
+
+    ptest();
+
+    gpio_in = gpio_new();
+    passert(gpio_in != NULL);
+    lines_out = gpio_lines_new();
+    passert(lines_out != NULL);
+    waveform = gpio_waveform_new();
+    passert(waveform != NULL);
+
+    unsigned int offsets[1] = {pin_output};
+    passert(gpio_lines_open(lines_out, device, offsets, 1, GPIO_DIR_OUT_LOW) == 0);
+    passert(gpio_open(gpio_in, device, pin_input, GPIO_DIR_IN) == 0);
+    passert(gpio_set_edge(gpio_in, GPIO_EDGE_BOTH) == 0);
+
+    gpio_waveform_config_t config = {.priority = 0, .cpu = 0, .repeat = 10};
+
+    /* Invalid arguments */
+    config.priority = -1;
+    passert(gpio_waveform_open(waveform, lines_out, &config) == GPIO_ERROR_ARG);
+    config.priority = 0;
+    config.cpu = -2;
+    passert(gpio_waveform_open(waveform, lines_out, &config) == GPIO_ERROR_ARG);
+    config.cpu = 0;
+
+    passert(gpio_waveform_open(waveform, lines_out, &config) == 0);
+
+    /* No waveform loaded */
+    passert(gpio_waveform_start(waveform) == GPIO_ERROR_INVALID_OPERATION);
+
+    /* Invalid tables */
+    gpio_waveform_step_t steps[2] = {
+        {.mask = 0x2, .value = 0x2, .delay_ns = 1000},
+        {.mask = 0x1, .value = 0x0, .delay_ns = 1000},
+    };
+    passert(gpio_waveform_load(waveform, steps, 0) == GPIO_ERROR_ARG);
+    passert(gpio_waveform_load(waveform, steps, 2) == GPIO_ERROR_ARG);
+    steps[0].mask = 0x1;
+    steps[0].delay_ns = 0;
+    steps[1].delay_ns = 0;
+    passert(gpio_waveform_load(waveform, steps, 2) == GPIO_ERROR_ARG);
+
+    /* Invalid PWM */
+    double duty_cycle = 1.5;
+    passert(gpio_waveform_load_pwm(waveform, 10000000, &duty_cycle, 1) == GPIO_ERROR_ARG);
+    duty_cycle = 0.25;
+    passert(gpio_waveform_load_pwm(waveform, 10000000, &duty_cycle, 2) == GPIO_ERROR_ARG);
+    passert(gpio_waveform_load_pwm(waveform, 0, &duty_cycle, 1) == GPIO_ERROR_ARG);
+
+    /* Play 10 periods of 10 ms at 25% duty cycle */
+    passert(gpio_waveform_load_pwm(waveform, 10000000, &duty_cycle, 1) == 0);
+    passert(gpio_waveform_start(waveform) == 0);
+
+    passert(gpio_waveform_tostring(waveform, str, sizeof(str)) > 0);
+    printf("Waveform description: %s\n", str);
+
+    usleep(150000);
+    passert(gpio_waveform_running(waveform) == false);
+    passert(gpio_waveform_stop(waveform) == 0);
+
+    /* Check edges and pulse widths */
+    passert((ret = gpio_read_events(gpio_in, events, 64, 100)) == 20);
+    for (int i = 0; i < ret; i++) {
+        passert(events[i].edge == ((i % 2 == 0) ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING));
+
+        if (i % 2 == 1) {
+            uint64_t high_ns = events[i].timestamp - events[i - 1].timestamp;
+            passert(high_ns > 1500000 && high_ns < 3500000);
+        } else if (i > 0) {
+            uint64_t period_ns = events[i].timestamp - events[i - 2].timestamp;
+            passert(period_ns > 8000000 && period_ns < 12000000);
+        }
+    }
+
+    passert(gpio_waveform_get_stats(waveform, &stats) == 0);
+    passert(stats.periods == 10);
+    passert(stats.late_mean_ns <= (double)stats.late_max_ns);
+    printf("Periods %" PRIu64 ", overruns %" PRIu64 ", skipped %" PRIu64 ", late max %" PRIu64 " ns, mean %.0f ns\n",
+           stats.periods, stats.overruns, stats.skipped, stats.late_max_ns, stats.late_mean_ns);
+
+    /* Check stop interrupts a long step delay */
+    struct timespec start, end;
+    duty_cycle = 0.5;
+    passert(gpio_waveform_load_pwm(waveform, 10000000000ULL, &duty_cycle, 1) == 0);
+    passert(gpio_waveform_start(waveform) == 0);
+    usleep(10000);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    passert(gpio_waveform_stop(waveform) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    passert((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec) < 100000000LL);
+
+    passert(gpio_waveform_close(waveform) == 0);
+
+    passert(gpio_close(gpio_in) == 0);
+    passert(gpio_lines_close(lines_out) == 0);
+
+    gpio_waveform_free(waveform);
+    gpio_lines_free(lines_out);
+    gpio_free(gpio_in);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <GPIO chip device> <GPIO #1> <GPIO #2>\n\n", argv[0]);
+        fprintf(stderr, "[1/2] Argument test: No requirements.\n");
+        fprintf(stderr, "[2/2] Loopback test: GPIOs #1 and #2 should be connected with a wire.\n\n");
+        fprintf(stderr, "Hint: for Raspberry Pi 3,\n");
+        fprintf(stderr, "Use GPIO 17 (header pin 11) and GPIO 27 (header pin 13),\n");
+        fprintf(stderr, "connect a loopback between them, and run this test with:\n");
+        fprintf(stderr, "    %s /dev/gpiochip0 17 27\n\n", argv[0]);
+        exit(1);
+    }
+
+    device = argv[1];
+    pin_input = strtoul(argv[2], NULL, 10);
+    pin_output = strtoul(argv[3], NULL, 10);
+
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_loopback();
+    printf(" " STR_OK "  Loopback test passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}
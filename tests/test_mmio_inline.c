@@ -0,0 +1,180 @@
+/*
+ * c-periphery
+ * https://github.com/vsergeev/c-periphery
+ * License: MIT
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <time.h>
+
+#include "../src/mmio.h"
+#include "../src/mmio_inline.h"
+
+#define PAGE_SIZE               4096
+#define BENCHMARK_ITERATIONS    10000000
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+void test_arguments(void) {
+    mmio_inline_t inl;
+    mmio_t *mmio;
+
+    ptest();
+
+    /* Allocate MMIO */
+    mmio = mmio_new();
+    passert(mmio != NULL);
+
+    /* Unopened MMIO */
+    passert(mmio_get_inline(mmio, 0, 4, &inl) == MMIO_ERROR_ARG);
+
+    /* Map a page of zeros in place of registers, at an unaligned base */
+    passert(mmio_open_advanced(mmio, 8, PAGE_SIZE - 8, "/dev/zero") == 0);
+
+    /* Window out of bounds */
+    passert(mmio_get_inline(mmio, 0, PAGE_SIZE, &inl) == MMIO_ERROR_ARG);
+    passert(mmio_get_inline(mmio, PAGE_SIZE - 12, 8, &inl) == MMIO_ERROR_ARG);
+    passert(mmio_get_inline(mmio, 4, SIZE_MAX, &inl) == MMIO_ERROR_ARG);
+    passert(mmio_get_inline(mmio, UINTPTR_MAX - 3, 8, &inl) == MMIO_ERROR_ARG);
+
+    /* Window not 64-bit aligned */
+    passert(mmio_get_inline(mmio, 2, 4, &inl) == MMIO_ERROR_ARG);
+    passert(mmio_get_inline(mmio, 4, 8, &inl) == MMIO_ERROR_ARG);
+
+    /* Whole mapping, and an empty window at the end */
+    passert(mmio_get_inline(mmio, 0, PAGE_SIZE - 8, &inl) == 0);
+    passert(inl.ptr == (volatile uint8_t *)mmio_ptr(mmio));
+    passert(inl.size == PAGE_SIZE - 8);
+    passert(mmio_get_inline(mmio, PAGE_SIZE - 8, 0, &inl) == 0);
+
+    /* Close and free MMIO */
+    passert(mmio_close(mmio) == 0);
+    mmio_free(mmio);
+}
+
+void test_read_write(void) {
+    mmio_inline_t inl;
+    mmio_t *mmio;
+    uint64_t value64;
+    uint32_t value32;
+    uint16_t value16;
+    uint8_t value8;
+
+    ptest();
+
+    /* Allocate and open MMIO */
+    mmio = mmio_new();
+    passert(mmio != NULL);
+    passert(mmio_open_advanced(mmio, 0, PAGE_SIZE, "/dev/zero") == 0);
+
+    /* Window at 0x100 */
+    passert(mmio_get_inline(mmio, 0x100, 0x100, &inl) == 0);
+    passert(inl.ptr == (volatile uint8_t *)mmio_ptr(mmio) + 0x100);
+
+    /* Inline writes, checked reads */
+    mmio_inline_write64(&inl, 0x0, 0x0123456789abcdefULL);
+    mmio_inline_write32(&inl, 0x8, 0xdeadbeef);
+    mmio_inline_write16(&inl, 0xc, 0xaa55);
+    mmio_inline_write8(&inl, 0xe, 0x5a);
+    passert(mmio_read64(mmio, 0x100, &value64) == 0);
+    passert(value64 == 0x0123456789abcdefULL);
+    passert(mmio_read32(mmio, 0x108, &value32) == 0);
+    passert(value32 == 0xdeadbeef);
+    passert(mmio_read16(mmio, 0x10c, &value16) == 0);
+    passert(value16 == 0xaa55);
+    passert(mmio_read8(mmio, 0x10e, &value8) == 0);
+    passert(value8 == 0x5a);
+
+    /* Checked writes, inline reads */
+    passert(mmio_write64(mmio, 0x1f8, 0xfedcba9876543210ULL) == 0);
+    passert(mmio_write32(mmio, 0x1f0, 0xcafebabe) == 0);
+    passert(mmio_write16(mmio, 0x1f4, 0x1234) == 0);
+    passert(mmio_write8(mmio, 0x1f6, 0x42) == 0);
+    passert(mmio_inline_read64(&inl, 0xf8) == 0xfedcba9876543210ULL);
+    passert(mmio_inline_read32(&inl, 0xf0) == 0xcafebabe);
+    passert(mmio_inline_read16(&inl, 0xf4) == 0x1234);
+    passert(mmio_inline_read8(&inl, 0xf6) == 0x42);
+
+    /* Close and free MMIO */
+    passert(mmio_close(mmio) == 0);
+    mmio_free(mmio);
+}
+
+void test_benchmark(void) {
+    struct timespec start, end;
+    mmio_inline_t inl;
+    mmio_t *mmio;
+    uint32_t value32;
+    unsigned int i;
+    int ret;
+    double write_ns, inline_write_ns, read_ns, inline_read_ns;
+
+    ptest();
+
+    /* Allocate and open MMIO */
+    mmio = mmio_new();
+    passert(mmio != NULL);
+    passert(mmio_open_advanced(mmio, 0, PAGE_SIZE, "/dev/zero") == 0);
+    passert(mmio_get_inline(mmio, 0, PAGE_SIZE, &inl) == 0);
+
+    /* Library writes */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        if ((ret = mmio_write32(mmio, 0x40, i)) < 0)
+            passert(ret == 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    write_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    /* Inline writes */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        mmio_inline_write32(&inl, 0x40, i);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    inline_write_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    /* Library reads */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        if ((ret = mmio_read32(mmio, 0x40, &value32)) < 0)
+            passert(ret == 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    read_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    /* Inline reads */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        value32 = mmio_inline_read32(&inl, 0x40);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    inline_read_ns = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+    passert(value32 == BENCHMARK_ITERATIONS - 1);
+
+    printf("mmio_write32(): %.2f ns/op, mmio_inline_write32(): %.2f ns/op (%+.1f%%)\n",
+           write_ns, inline_write_ns, 100.0 * (inline_write_ns - write_ns) / write_ns);
+    printf("mmio_read32(): %.2f ns/op, mmio_inline_read32(): %.2f ns/op (%+.1f%%)\n",
+           read_ns, inline_read_ns, 100.0 * (inline_read_ns - read_ns) / read_ns);
+
+    /* Close and free MMIO */
+    passert(mmio_close(mmio) == 0);
+    mmio_free(mmio);
+}
+
+int main(void) {
+    test_arguments();
+    printf(" " STR_OK "  Arguments test passed.\n\n");
+    test_read_write();
+    printf(" " STR_OK "  Read/write test passed.\n\n");
+    test_benchmark();
+    printf(" " STR_OK "  Benchmark passed.\n\n");
+
+    printf("All tests passed!\n");
+    return 0;
+}